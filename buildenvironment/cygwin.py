@@ -44,9 +44,13 @@ localconf = {
                                  "boost_iostreams-mt"
     ],
     
-    "clibraries"            : [ ],
+    "clibraries"            : [ "z",
+                                "bz2"
+    ],
     
-    "cheaders"              :  [ "omp.h"
+    "cheaders"              :  [ "omp.h",
+                                 "zlib.h",
+                                 "bzlib.h"
     ],
     
     "cppheaders"            :  [ "map",
@@ -123,7 +127,8 @@ localconf = {
                                  os.path.join("boost", "iostreams", "filter", "counter.hpp"), 
                                  os.path.join("boost", "iostreams", "concepts.hpp"), 
                                  os.path.join("boost", "iostreams", "operations.hpp"), 
-                                 os.path.join("boost", "iostreams", "copy.hpp")
+                                 os.path.join("boost", "iostreams", "copy.hpp"),
+                                 os.path.join("boost", "iostreams", "device", "mapped_file.hpp")
     ]
 }
 # ==========================================================================
@@ -299,9 +304,28 @@ if conf.env["withsymbolicmath"] :
     )
 
 
+if conf.env["withcompression"] :
+    conf.env.AppendUnique(CPPDEFINES  = ["MACHINELEARNING_COMPRESSION"])
+    localconf["clibraries"].extend([
+                            "zstd",
+                            "lz4",
+                            "lzma"
+    ])
+    localconf["cheaders"].extend([
+                            "zstd.h",
+                            "zdict.h",
+                            "lz4.h",
+                            "lz4hc.h",
+                            "lzma.h"
+    ])
+
+
 if conf.env["withlogger"] :
     conf.env.AppendUnique(CPPDEFINES  = ["MACHINELEARNING_LOGGER"])
-    localconf["cpplibraries"].extend(["boost_thread-mt", "boost_system-mt"])  
+
+# logger and patch prefetching need threads
+if conf.env["withlogger"] or conf.env["withfiles"] :
+    localconf["cpplibraries"].extend(["boost_thread-mt", "boost_system-mt"])
 
 
 if conf.env["withsources"] :
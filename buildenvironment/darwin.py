@@ -38,9 +38,13 @@ localconf = {
                                  "boost_iostreams-mt"
     ],
     
-    "clibraries"            : [ ],
+    "clibraries"            : [ "z",
+                                "bz2"
+    ],
     
-    "cheaders"              : [ "omp.h"
+    "cheaders"              : [ "omp.h",
+                                "zlib.h",
+                                "bzlib.h"
     ],
     
     "cppheaders"            : [ "map",
@@ -117,7 +121,8 @@ localconf = {
                                 os.path.join("boost", "iostreams", "filter", "counter.hpp"), 
                                 os.path.join("boost", "iostreams", "concepts.hpp"), 
                                 os.path.join("boost", "iostreams", "operations.hpp"), 
-                                os.path.join("boost", "iostreams", "copy.hpp")
+                                os.path.join("boost", "iostreams", "copy.hpp"),
+                                os.path.join("boost", "iostreams", "device", "mapped_file.hpp")
     ]
 }
 # ==========================================================================
@@ -276,6 +281,15 @@ if conf.env["withmpi"] and not("librarybuild" in COMMAND_LINE_TARGETS) :
     )
     
 
+if conf.env["withsharedmemory"] :
+    conf.env.AppendUnique(CPPDEFINES  = ["MACHINELEARNING_SHAREDMEMORY"])
+    if not("boost_serialization-mt" in localconf["cpplibraries"]) :
+        localconf["cpplibraries"].append("boost_serialization-mt")
+    localconf["cppheaders"].append(
+                            os.path.join("boost", "interprocess", "anonymous_shared_memory.hpp")
+    )
+
+
 if conf.env["withmultilanguage"] :
     conf.env.AppendUnique(CPPDEFINES  = ["MACHINELEARNING_MULTILANGUAGE"])
     localconf["clibraries"].append(
@@ -312,9 +326,28 @@ if conf.env["withsymbolicmath"] :
     )
 
 
+if conf.env["withcompression"] :
+    conf.env.AppendUnique(CPPDEFINES  = ["MACHINELEARNING_COMPRESSION"])
+    localconf["clibraries"].extend([
+                            "zstd",
+                            "lz4",
+                            "lzma"
+    ])
+    localconf["cheaders"].extend([
+                            "zstd.h",
+                            "zdict.h",
+                            "lz4.h",
+                            "lz4hc.h",
+                            "lzma.h"
+    ])
+
+
 if conf.env["withlogger"] :
     conf.env.AppendUnique(CPPDEFINES  = ["MACHINELEARNING_LOGGER"])
-    localconf["cpplibraries"].extend(["boost_thread-mt", "boost_system-mt"])    
+
+# logger and patch prefetching need threads
+if conf.env["withlogger"] or conf.env["withfiles"] :
+    localconf["cpplibraries"].extend(["boost_thread-mt", "boost_system-mt"])
 
 
 if conf.env["withsources"] :
@@ -32,6 +32,8 @@ Import("*")
 
 if conf.env["withmpi"] :
     raise RuntimeError("MPI build does not work under Msys")
+if conf.env["withsharedmemory"] :
+    raise RuntimeError("shared-memory build does not work under Msys")
 
 
 # === default configuration ================================================
@@ -46,10 +48,14 @@ localconf = {
     "clibraries"            : [ "lapack",
                                 "lapacke",
                                 "blas",
-                                "gfortran"
+                                "gfortran",
+                                "z",
+                                "bz2"
     ],
     
-    "cheaders"              : [ "omp.h"
+    "cheaders"              : [ "omp.h",
+                                "zlib.h",
+                                "bzlib.h"
     ],
     
     "cppheaders"            : [ "map",
@@ -126,7 +132,8 @@ localconf = {
                                 os.path.join("boost", "iostreams", "filter", "counter.hpp"), 
                                 os.path.join("boost", "iostreams", "concepts.hpp"), 
                                 os.path.join("boost", "iostreams", "operations.hpp"), 
-                                os.path.join("boost", "iostreams", "copy.hpp")
+                                os.path.join("boost", "iostreams", "copy.hpp"),
+                                os.path.join("boost", "iostreams", "device", "mapped_file.hpp")
     ]
 }
 # ==========================================================================
@@ -326,9 +333,28 @@ if conf.env["withsymbolicmath"] :
     )
 
 
+if conf.env["withcompression"] :
+    conf.env.AppendUnique(CPPDEFINES  = ["MACHINELEARNING_COMPRESSION"])
+    localconf["clibraries"].extend([
+                            "zstd",
+                            "lz4",
+                            "lzma"
+    ])
+    localconf["cheaders"].extend([
+                            "zstd.h",
+                            "zdict.h",
+                            "lz4.h",
+                            "lz4hc.h",
+                            "lzma.h"
+    ])
+
+
 if conf.env["withlogger"] :
     conf.env.AppendUnique(CPPDEFINES  = ["MACHINELEARNING_LOGGER"])
-    localconf["cpplibraries"].extend(["boost_thread-mt", "boost_system-mt"])     
+
+# logger and patch prefetching need threads
+if conf.env["withlogger"] or conf.env["withfiles"] :
+    localconf["cpplibraries"].extend(["boost_thread-mt", "boost_system-mt"])
 
 
 if conf.env["withsources"] :
@@ -41,6 +41,7 @@ namespace machinelearning {
 #include "nonsupervised/relational_neuralgas.hpp"
 #include "nonsupervised/kmeans.hpp"
 #include "nonsupervised/spectralclustering.hpp"
+#include "nonsupervised/patchtrainer.hpp"
 
 #include "supervised/clustering.hpp"
 #include "supervised/rlvq.hpp"
@@ -29,10 +29,6 @@
 #include <boost/numeric/ublas/matrix.hpp>
 #include <boost/numeric/ublas/vector.hpp>
 
-#ifdef MACHINELEARNING_MPI
-#include <boost/mpi.hpp>
-#endif
-
 #include "../../errorhandling/exception.hpp"
 #include "../../distances/distances.h"
 #include "../../tools/tools.h"
@@ -44,8 +40,8 @@ namespace machinelearning {  namespace clustering {
         
         #ifndef SWIG
         namespace ublas = boost::numeric::ublas;
-        #ifdef MACHINELEARNING_MPI
-        namespace mpi   = boost::mpi;
+        #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
+        namespace mpi   = machinelearning::tools::communication;
         #endif
         #endif
         
@@ -117,7 +113,7 @@ namespace machinelearning {  namespace clustering {
         
         
         
-        #ifdef MACHINELEARNING_MPI
+        #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
         
         /** abstract class for clustering with MPI interface **/           
         template<typename T> class mpiclustering
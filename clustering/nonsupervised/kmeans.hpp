@@ -30,7 +30,6 @@
 #include <boost/numeric/ublas/matrix.hpp>
 #include <boost/numeric/ublas/matrix_sparse.hpp>
 #include <boost/numeric/ublas/vector.hpp>
-
 #include "clustering.hpp"
 #include "../../errorhandling/exception.hpp"
 #include "../../tools/tools.h"
@@ -42,13 +41,23 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
     
     #ifndef SWIG
     namespace ublas = boost::numeric::ublas;
+    #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
+    namespace mpi   = machinelearning::tools::communication;
+    #endif
     #endif
     
     
     /** class for calculate (batch) k-means
+     * @note The MPI methods use the data of each process as a shard of the whole data, every process
+     * owns its prototypes and the prototypes of all processes are the prototypes of the cluster. Only
+     * the sums and counts of the winner data points are reduced on each iteration. The MPI methods
+     * must be called on each process.
      * @todo determine best k with variance analyse
      **/
     template<typename T> class kmeans : public clustering<T>
+        #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
+        , public mpiclustering<T>
+        #endif
     {
         
         public:
@@ -64,6 +73,15 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
             std::vector<T> getLoggedQuantizationError( void ) const;
             ublas::indirect_array<> use( const ublas::matrix<T>& ) const;
         
+            #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
+            void train( const mpi::communicator&, const ublas::matrix<T>&, const std::size_t& );
+            ublas::matrix<T> getPrototypes( const mpi::communicator& ) const;
+            std::vector< ublas::matrix<T> > getLoggedPrototypes( const mpi::communicator& ) const;
+            std::vector<T> getLoggedQuantizationError( const mpi::communicator& ) const;
+            ublas::indirect_array<> use( const mpi::communicator&, const ublas::matrix<T>& ) const;
+            void use( const mpi::communicator& ) const;
+            #endif
+            
             
         private :
         
@@ -78,8 +96,16 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
             /** std::vector for quantisation error in each iteration **/
             std::vector<T> m_quantizationerror;
             
-            T calculateQuantizationError( const ublas::matrix<T>& ) const;
+            T calculateQuantizationError( const ublas::matrix<T>&, const ublas::matrix<T>& ) const;
+            ublas::indirect_array<> getWinner( const ublas::matrix<T>&, const ublas::matrix<T>& ) const;
         
+            #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
+            /** map with information to every process and prototype**/
+            std::vector< std::pair<std::size_t,std::size_t> > m_processprototypinfo;
+            
+            ublas::matrix<T> gatherAllPrototypes( const mpi::communicator& ) const;
+            void setProcessPrototypeInfo( const mpi::communicator& );
+            #endif
     };
     
     
@@ -95,6 +121,9 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
         m_logging( false ),
         m_logprototypes( std::vector< ublas::matrix<T> >() ),
         m_quantizationerror( std::vector<T>() )
+        #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
+        , m_processprototypinfo()
+        #endif
     {
         if (p_prototypesize == 0)
             throw exception::runtime(_("prototype size must be greater than zero"), *this);
@@ -215,7 +244,7 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
             // determine quantization error for logging
             if (m_logging) {
                 m_logprototypes.push_back( m_prototypes );
-                m_quantizationerror.push_back( calculateQuantizationError(p_data) );
+                m_quantizationerror.push_back( calculateQuantizationError(p_data, m_prototypes) );
             }            
         }
     }
@@ -241,15 +270,16 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
     
     /** calculate the quantization error
      * @param p_data matrix with data points
+     * @param p_prototypes prototype matrix
      * @return quantization error
      **/    
-    template<typename T> inline T kmeans<T>::calculateQuantizationError( const ublas::matrix<T>& p_data ) const
+    template<typename T> inline T kmeans<T>::calculateQuantizationError( const ublas::matrix<T>& p_data, const ublas::matrix<T>& p_prototypes ) const
     {
-        ublas::matrix<T> l_distances( m_prototypes.size1(), p_data.size1() );
+        ublas::matrix<T> l_distances( p_prototypes.size1(), p_data.size1() );
         
         #pragma omp parallel for
-        for(std::size_t i=0; i < m_prototypes.size1(); ++i)
-            ublas::row(l_distances, i) = m_distance.getDistance( p_data, ublas::row(m_prototypes, i) );
+        for(std::size_t i=0; i < p_prototypes.size1(); ++i)
+            ublas::row(l_distances, i) = m_distance.getDistance( p_data, ublas::row(p_prototypes, i) );
         
         return 0.5 * ublas::sum(  m_distance.getAbs(tools::matrix::min(l_distances, tools::matrix::column))  );  
     }
@@ -265,13 +295,24 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
         if (p_data.size1() < m_prototypes.size1())
             throw exception::runtime(_("number of datapoints are less than prototypes"), *this);        
         
+        return getWinner( p_data, m_prototypes );
+    }
+    
+    
+    /** determines for each datapoint the index of the nearest prototype
+     * @param p_data matrix
+     * @param p_prototypes prototype matrix
+     * @return index array of prototype indices
+     **/
+    template<typename T> inline ublas::indirect_array<> kmeans<T>::getWinner( const ublas::matrix<T>& p_data, const ublas::matrix<T>& p_prototypes ) const
+    {
         ublas::indirect_array<> l_idx(p_data.size1());
-        ublas::matrix<T> l_distance(m_prototypes.size1(), p_data.size1());
+        ublas::matrix<T> l_distance(p_prototypes.size1(), p_data.size1());
         
         // calculate distance for every prototype
         #pragma omp parallel for shared(l_distance)
-        for(std::size_t i=0; i < m_prototypes.size1(); ++i)
-            ublas::row(l_distance, i)  = m_distance.getDistance( p_data, ublas::row(m_prototypes, i) );
+        for(std::size_t i=0; i < p_prototypes.size1(); ++i)
+            ublas::row(l_distance, i)  = m_distance.getDistance( p_data, ublas::row(p_prototypes, i) );
         
         // determine nearest prototype
         #pragma omp parallel for shared(l_distance, l_idx)
@@ -286,6 +327,204 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
     }
 
     
-
+    
+    //======= MPI ==================================================================================================================================
+    #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
+    
+    /** gathering prototypes of every process and return the full prototypes matrix (row oriantated)
+     * @param p_mpi MPI object for communication
+     * @return full prototypes matrix
+     **/
+    template<typename T> inline ublas::matrix<T> kmeans<T>::gatherAllPrototypes( const mpi::communicator& p_mpi ) const
+    {
+        // gathering in this way, that every process get all prototypes
+        std::vector< ublas::matrix<T> > l_prototypedata;
+        mpi::all_gather(p_mpi, m_prototypes, l_prototypedata);
+        
+        // create full prototype matrix with processprotos
+        ublas::matrix<T> l_prototypes = l_prototypedata[0];
+        for(std::size_t i=1; i < l_prototypedata.size(); ++i) {
+            l_prototypes.resize( l_prototypes.size1()+l_prototypedata[i].size1(), l_prototypes.size2());
+            
+            ublas::matrix_range< ublas::matrix<T> > l_range(l_prototypes, 
+                                                            ublas::range( l_prototypes.size1()-l_prototypedata[i].size1(), l_prototypes.size1() ), 
+                                                            ublas::range( 0, l_prototypes.size2() )
+                                                            );
+            l_range.assign(l_prototypedata[i]);
+        }
+        
+        return l_prototypes;
+    }
+    
+    
+    /** sets the std::vector with the begin position and size of the prototypes matrix. Is required for the extraction of prototypes
+     * of the full matrix for each process
+     * @param p_mpi MPI object for communication
+     **/
+    template<typename T> inline void kmeans<T>::setProcessPrototypeInfo( const mpi::communicator& p_mpi )
+    {
+        m_processprototypinfo.clear();
+        // gathering the number of prototypes
+        std::vector< std::size_t > l_processdata;
+        mpi::all_gather(p_mpi, m_prototypes.size1(), l_processdata);
+        
+        // create map
+        std::size_t l_sum = 0;
+        for(std::size_t i=0; i < l_processdata.size(); ++i) {
+            m_processprototypinfo.push_back( std::pair<std::size_t,std::size_t>(l_sum, l_processdata[i]) );
+            l_sum += l_processdata[i];
+        }
+    }
+    
+    
+    /** train the data on the cluster. Each process determines the winner prototype of its data points
+     * and sums the data points and the number of points for each prototype. Only these sums are reduced,
+     * so the communication is independent of the number of data points
+     * @param p_mpi MPI object for communication
+     * @param p_data datapoints
+     * @param p_iterations iterations
+     **/
+    template<typename T> inline void kmeans<T>::train( const mpi::communicator& p_mpi, const ublas::matrix<T>& p_data, const std::size_t& p_iterations )
+    {
+        if (p_iterations == 0)
+            throw exception::runtime(_("iterations must be greater than zero"), *this);
+        if (p_data.size2() != m_prototypes.size2())
+            throw exception::runtime(_("data and prototype dimension are not equal"), *this);
+        
+        // we use the max. of all values of each process
+        const std::size_t l_iterationsMPI = mpi::all_reduce(p_mpi, p_iterations, mpi::maximum<std::size_t>());
+        m_logging                         = mpi::all_reduce(p_mpi, m_logging, std::multiplies<bool>());
+        setProcessPrototypeInfo(p_mpi);
+        
+        ublas::matrix<T> l_prototypes = gatherAllPrototypes( p_mpi );
+        if (mpi::all_reduce(p_mpi, p_data.size1(), std::plus<std::size_t>()) < l_prototypes.size1())
+            throw exception::runtime(_("number of datapoints are less than prototypes"), *this);
+        
+        // creates logging
+        if (m_logging) {
+            m_logprototypes.clear();
+            m_quantizationerror.clear();
+            m_logprototypes.reserve(l_iterationsMPI);
+            m_quantizationerror.reserve(l_iterationsMPI);
+        }
+        
+        
+        // run kmeans, the sum matrix stores the sums of the data points and the number of points in the last column
+        const std::size_t l_columns = l_prototypes.size2()+1;
+        ublas::matrix<T> l_sum( l_prototypes.size1(), l_columns );
+        ublas::matrix<T> l_reduce( l_prototypes.size1(), l_columns );
+        
+        for(std::size_t i=0; i < l_iterationsMPI; ++i) {
+            
+            // determine winner and sum the local data of each prototype
+            const ublas::indirect_array<> l_winner = getWinner( p_data, l_prototypes );
+            
+            l_sum.clear();
+            for(std::size_t n=0; n < l_winner.size(); ++n) {
+                ublas::subrange(l_sum, l_winner(n), l_winner(n)+1, 0, l_prototypes.size2()) += ublas::subrange(p_data, n, n+1, 0, p_data.size2());
+                l_sum(l_winner(n), l_prototypes.size2()) += static_cast<T>(1);
+            }
+            
+            // reduce sums and counts and normalize the prototypes
+            mpi::all_reduce( p_mpi, &(l_sum.data()[0]), static_cast<int>(l_sum.data().size()), &(l_reduce.data()[0]), std::plus<T>() );
+            
+            l_prototypes = ublas::subrange(l_reduce, 0, l_prototypes.size1(), 0, l_prototypes.size2());
+            #pragma omp parallel for shared(l_prototypes)
+            for(std::size_t n=0; n < l_prototypes.size1(); ++n)
+                if (!tools::function::isNumericalZero(l_reduce(n, l_prototypes.size2())))
+                    ublas::row(l_prototypes, n) /= l_reduce(n, l_prototypes.size2());
+            
+            // set local prototypes
+            const std::pair<std::size_t,std::size_t>& l_info = m_processprototypinfo[static_cast<std::size_t>(p_mpi.rank())];
+            m_prototypes = ublas::subrange(l_prototypes, l_info.first, l_info.first+l_info.second, 0, l_prototypes.size2());
+            
+            
+            // determine quantization error for logging
+            if (m_logging) {
+                m_logprototypes.push_back( m_prototypes );
+                m_quantizationerror.push_back( calculateQuantizationError(p_data, l_prototypes) );
+            }
+        }
+    }
+    
+    
+    /** return all prototypes of the cluster
+     * @param p_mpi MPI object for communication
+     * @return matrix (rows = prototypes)
+     **/
+    template<typename T> inline ublas::matrix<T> kmeans<T>::getPrototypes( const mpi::communicator& p_mpi ) const
+    {
+        return gatherAllPrototypes( p_mpi );
+    }
+    
+    
+    /** returns all logged prototypes in all processes
+     * @param p_mpi MPI object for communication
+     * @return std::vector with all logged prototypes
+     **/
+    template<typename T> inline std::vector< ublas::matrix<T> > kmeans<T>::getLoggedPrototypes( const mpi::communicator& p_mpi ) const
+    {
+        // we must gather every logged prototype and create the full prototype matrix
+        std::vector< std::vector< ublas::matrix<T> > > l_gatherProto;
+        mpi::all_gather(p_mpi, m_logprototypes, l_gatherProto);
+        
+        // now we create the full prototype matrix for every log
+        std::vector< ublas::matrix<T> > l_logProto = l_gatherProto[0];
+        for(std::size_t i=1; i < l_gatherProto.size(); ++i)
+            for(std::size_t n=0; n < l_gatherProto[i].size(); ++n) {
+                l_logProto[n].resize( l_logProto[n].size1()+l_gatherProto[i][n].size1(), l_logProto[n].size2());
+                
+                ublas::matrix_range< ublas::matrix<T> > l_range(l_logProto[n], 
+                                                                ublas::range( l_logProto[n].size1()-l_gatherProto[i][n].size1(), l_logProto[n].size1() ), 
+                                                                ublas::range( 0, l_logProto[n].size2() )
+                                                                );
+                l_range.assign(l_gatherProto[i][n]);
+            }
+        
+        return l_logProto;
+    }
+    
+    
+    /** returns the logged quantisation error
+     * @param p_mpi MPI object for communication
+     * @return std::vector with quantization error
+     **/
+    template<typename T> inline std::vector<T> kmeans<T>::getLoggedQuantizationError( const mpi::communicator& p_mpi ) const
+    {
+        // each process stores the error of its data, so the errors are summed
+        std::vector<T> l_error( m_quantizationerror.size(), 0 );
+        if (!l_error.empty())
+            mpi::all_reduce( p_mpi, &m_quantizationerror[0], static_cast<int>(m_quantizationerror.size()), &l_error[0], std::plus<T>() );
+        
+        return l_error;
+    }
+    
+    
+    /** calulates distance between datapoints and prototypes and returns a indirect array
+     * with index of the nearest prototype
+     * @param p_mpi MPI object for communication     
+     * @param p_data matrix
+     * @return index array of prototype indices
+     **/
+    template<typename T> inline ublas::indirect_array<> kmeans<T>::use( const mpi::communicator& p_mpi, const ublas::matrix<T>& p_data ) const
+    {
+        if (p_data.size2() != m_prototypes.size2())
+            throw exception::runtime(_("data and prototype dimension are not equal"), *this);
+        
+        return getWinner( p_data, gatherAllPrototypes(p_mpi) );
+    }
+    
+    
+    /** blank method for receiving all prototypes. The method can be used in combination with the use-method and the matrix parameter, so
+     * only one process can calculate the distances between prototypes and its data, all other process must call only this methode
+     * @param p_mpi MPI object for communication 
+     **/
+    template<typename T> inline void kmeans<T>::use( const mpi::communicator& p_mpi ) const
+    {
+        gatherAllPrototypes( p_mpi );
+    }
+    
+    #endif
+    
 }}}
 #endif
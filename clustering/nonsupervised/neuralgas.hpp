@@ -32,10 +32,6 @@
 #include <boost/numeric/ublas/matrix.hpp>
 #include <boost/numeric/ublas/vector.hpp>
 #include <boost/numeric/bindings/blas.hpp>
-#ifdef MACHINELEARNING_MPI
-#include <boost/mpi.hpp>
-#endif
-
 #include "clustering.hpp"
 #include "../../errorhandling/exception.hpp"
 #include "../../tools/tools.h"
@@ -47,8 +43,8 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
     
     #ifndef SWIG
     namespace ublas = boost::numeric::ublas;
-    #ifdef MACHINELEARNING_MPI
-    namespace mpi   = boost::mpi;
+    #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
+    namespace mpi   = machinelearning::tools::communication;
     #endif
     #endif
 
@@ -57,10 +53,12 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
      * @note The MPI methods do not check the correct ranges / dimension of the prototype
      * data, so it is the task of the developer to use the correct ranges. Also the MPI
      * methods must be called in the correct order, so the MPI calls must be run
-     * on each process.
+     * on each process. The MPI training reduces only partial sums with non-blocking
+     * collectives, so it needs an MPI-3 implementation. The methods can be used with
+     * the shared-memory communicator, too.
      **/
     template<typename T> class neuralgas : public clustering<T>, public patchclustering<T>
-        #ifdef MACHINELEARNING_MPI 
+        #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
         , public mpiclustering<T>, public mpipatchclustering<T>
         #endif
     {
@@ -85,7 +83,7 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
             void trainpatch( const ublas::matrix<T>&, const std::size_t&, const T& );
             std::vector< ublas::vector<T> > getLoggedPrototypeWeights( void ) const;
              
-            #ifdef MACHINELEARNING_MPI
+            #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
             void train( const mpi::communicator&, const ublas::matrix<T>&, const std::size_t& );
             void train( const mpi::communicator&, const ublas::matrix<T>&, const std::size_t&, const T& );
             ublas::matrix<T> getPrototypes( const mpi::communicator& ) const;
@@ -99,6 +97,7 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
             void trainpatch( const mpi::communicator&, const ublas::matrix<T>&, const std::size_t& );
             void trainpatch( const mpi::communicator&, const ublas::matrix<T>&, const std::size_t&, const T& );
             std::vector< ublas::vector<T> > getLoggedPrototypeWeights( const mpi::communicator& ) const;
+            void setCommunicationBlocks( const std::size_t& );
             #endif
         
         
@@ -124,14 +123,18 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
             
             T calculateQuantizationError( const ublas::matrix<T>&, const ublas::matrix<T>& ) const;
             
-            #ifdef MACHINELEARNING_MPI
+            #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
             /** map with information to every process and prototype**/
             std::vector< std::pair<std::size_t,std::size_t> > m_processprototypinfo;
+            /** number of data blocks, which are reduced non-blocking on each iteration **/
+            std::size_t m_communicationblocks;
             
-            void synchronizePrototypes( const mpi::communicator&, ublas::matrix<T>&, ublas::vector<T>& );
+            std::vector< ublas::matrix<T> > splitData( const mpi::communicator&, const ublas::matrix<T>& ) const;
+            std::vector< ublas::vector<T> > splitMultiplier( const std::vector< ublas::matrix<T> >&, const ublas::vector<T>& ) const;
+            ublas::matrix<T> reducePrototypes( const mpi::communicator&, const std::vector< ublas::matrix<T> >&, const std::vector< ublas::vector<T> >&, const ublas::matrix<T>&, const ublas::vector<T>& ) const;
+            void setLocalPrototypes( const mpi::communicator&, const ublas::matrix<T>& );
             void synchronizePrototypeWeights( const mpi::communicator&, ublas::vector<T>& );
             ublas::matrix<T> gatherAllPrototypes( const mpi::communicator& ) const;
-            std::size_t getNumberPrototypes( const mpi::communicator& ) const;
             void setProcessPrototypeInfo( const mpi::communicator& );
             #endif
     };
@@ -152,8 +155,9 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
         m_prototypeWeights( p_prototypes, 0 ),
         m_logprototypeWeights(),
         m_firstpatch(true)
-        #ifdef MACHINELEARNING_MPI
-        , m_processprototypinfo()
+        #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
+        , m_processprototypinfo(),
+        m_communicationblocks(2)
         #endif
     {
         if (p_prototypesize == 0)
@@ -429,7 +433,7 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
         
         // if not the first patch add prototypes to data at the end and set the multiplier
         ublas::matrix<T> l_data(p_data);
-        ublas::vector<std::size_t> l_multiplier(l_data.size1(), 1);
+        ublas::vector<T> l_multiplier(l_data.size1(), 1);
         if (!m_firstpatch) {
             
             // resize data matrix
@@ -442,14 +446,14 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
             
             // resize multiplier
             l_multiplier.resize( l_multiplier.size()+m_prototypeWeights.size() );
-            ublas::vector_range< ublas::vector<std::size_t> > l_multiplierrange( l_multiplier, ublas::range( l_multiplier.size()-m_prototypeWeights.size(), l_multiplier.size()) );
+            ublas::vector_range< ublas::vector<T> > l_multiplierrange( l_multiplier, ublas::range( l_multiplier.size()-m_prototypeWeights.size(), l_multiplier.size()) );
             l_multiplierrange.assign(m_prototypeWeights);
         }
      
 
         // run neural gas       
         const T l_multi = 0.01/p_lambda;
-        ublas::matrix<T> l_adaptmatrix( m_prototypes.size1(), p_data.size1() );
+        ublas::matrix<T> l_adaptmatrix( m_prototypes.size1(), l_data.size1() );
         ublas::vector<T> l_lambda(m_prototypes.size1());
         
         for(std::size_t i=0; i < p_iterations; ++i) {
@@ -525,7 +529,7 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
 
     
     //======= MPI ==================================================================================================================================
-    #ifdef MACHINELEARNING_MPI
+    #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
     
     /** gathering prototypes of every process and return the full prototypes matrix (row oriantated)
      * @param p_mpi MPI object for communication
@@ -554,54 +558,145 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
     
     
     
-    /** synchronize prototypes of every process and set with them the local prototypematrix.
-     * We can not use const references because of the range. The idea is the commutativity
-     * of the dot product of every prototype dimension. The prototypes are a matrix-matrix-product of the
-     * adaption value and the data values. The matrix-matrix-product is a dot product of rows and columns so
-     * the commutativity is used for parallelism / the gathering uses the commutativity for create the correct prototype values
+    /** sets the number of data blocks, which are used on the MPI training. The
+     * partial sums of each block are reduced with a non-blocking collective, so the
+     * communication of a block is overlapped with the distance calculation of the next block
+     * @param p_blocks number of blocks
+     **/
+    template<typename T> inline void neuralgas<T>::setCommunicationBlocks( const std::size_t& p_blocks )
+    {
+        if (p_blocks == 0)
+            throw exception::runtime(_("number of blocks must be greater than zero"), *this);
+        
+        m_communicationblocks = p_blocks;
+    }
+    
+    
+    /** splits the local data into row blocks. The number of blocks is equal
+     * on each process, because every block creates one collective call
      * @param p_mpi MPI object for communication
-     * @param p_localprototypes local prototype matrix
-     * @param p_localnorm normalize vector
+     * @param p_data data matrix
+     * @return std::vector with data blocks (blocks can be empty)
      **/
-    template<typename T> inline void neuralgas<T>::synchronizePrototypes( const mpi::communicator& p_mpi, ublas::matrix<T>& p_localprototypes, ublas::vector<T>& p_localnorm )
+    template<typename T> inline std::vector< ublas::matrix<T> > neuralgas<T>::splitData( const mpi::communicator& p_mpi, const ublas::matrix<T>& p_data ) const
     {
-        // create for each process the norm and prototypes
-        // we need two vectors, in which the index is the process ID and sends the data back to the process
-        std::vector< ublas::matrix<T> > l_prototypes;
-		std::vector< ublas::vector<T> > l_norm;
-        for(int i=0; i < p_mpi.size(); ++i) {
-            
-            // prototypes
-            ublas::matrix_range< ublas::matrix<T> > l_protorange(p_localprototypes, 
-                                                                 ublas::range( m_processprototypinfo[i].first, m_processprototypinfo[i].first + m_processprototypinfo[i].second ), 
-                                                                 ublas::range( 0, p_localprototypes.size2() )
-                                                                 );
-            l_prototypes.push_back(l_protorange);
+        const std::size_t l_blocks    = mpi::all_reduce(p_mpi, m_communicationblocks, mpi::maximum<std::size_t>());
+        const std::size_t l_blocksize = p_data.size1() / l_blocks + ((p_data.size1() % l_blocks) ? 1 : 0);
+        
+        std::vector< ublas::matrix<T> > l_data;
+        for(std::size_t i=0; i < l_blocks; ++i) {
+            const std::size_t l_begin = std::min(i * l_blocksize, p_data.size1());
+            const std::size_t l_end   = std::min(l_begin + l_blocksize, p_data.size1());
             
-            //norm
-            ublas::vector_range< ublas::vector<T> > l_normrange(p_localnorm,
-                                                                ublas::range( m_processprototypinfo[i].first, m_processprototypinfo[i].first + m_processprototypinfo[i].second )
-                                                                );
-            l_norm.push_back(l_normrange);
+            l_data.push_back( ublas::subrange(p_data, l_begin, l_end, 0, p_data.size2()) );
         }
         
+        return l_data;
+    }
+    
+    
+    /** splits the multiplier in the same way as the data blocks
+     * @param p_data data blocks
+     * @param p_multiplier multiplier vector (can be empty)
+     * @return std::vector with multiplier blocks (empty if no multiplier is used)
+     **/
+    template<typename T> inline std::vector< ublas::vector<T> > neuralgas<T>::splitMultiplier( const std::vector< ublas::matrix<T> >& p_data, const ublas::vector<T>& p_multiplier ) const
+    {
+        std::vector< ublas::vector<T> > l_multiplier;
+        if (p_multiplier.size() == 0)
+            return l_multiplier;
+        
+        std::size_t l_begin = 0;
+        for(std::size_t i=0; i < p_data.size(); ++i) {
+            l_multiplier.push_back( ublas::subrange(p_multiplier, l_begin, l_begin+p_data[i].size1()) );
+            l_begin += p_data[i].size1();
+        }
+        
+        return l_multiplier;
+    }
+    
+    
+    /** calculates one neural gas step of the full prototype matrix. Each process creates for each data block the
+     * weighted sum of its data points and the sum of the adaption values for every prototype (the commutativity of the
+     * dot product within the matrix-matrix-product is used). Only these partial sums are reduced, the reduction of a block
+     * is started non-blocking, so the distance calculation of the next block runs during the communication
+     * @param p_mpi MPI object for communication
+     * @param p_data data blocks
+     * @param p_multiplier multiplier blocks (empty if no multiplier is used)
+     * @param p_prototypes full prototype matrix
+     * @param p_lambda adaption values
+     * @return new full prototype matrix
+     **/
+    template<typename T> inline ublas::matrix<T> neuralgas<T>::reducePrototypes( const mpi::communicator& p_mpi, const std::vector< ublas::matrix<T> >& p_data, const std::vector< ublas::vector<T> >& p_multiplier, const ublas::matrix<T>& p_prototypes, const ublas::vector<T>& p_lambda ) const
+    {
+        // each block is stored with the weighted sum in the first columns and the norm in the last column
+        const std::size_t l_columns = p_prototypes.size2()+1;
+        std::vector< ublas::matrix<T> > l_send( p_data.size(), ublas::matrix<T>(p_prototypes.size1(), l_columns, 0) );
+        std::vector< ublas::matrix<T> > l_receive( p_data.size(), ublas::matrix<T>(p_prototypes.size1(), l_columns, 0) );
+        std::vector< mpi::request > l_request( p_data.size() );
+        
+        for(std::size_t i=0; i < p_data.size(); ++i) {
+            
+            if (p_data[i].size1() > 0) {
+                ublas::matrix<T> l_adaptmatrix( p_prototypes.size1(), p_data[i].size1() );
+                
+                // calculate for every prototype the distance
+                #pragma omp parallel for shared(l_adaptmatrix)
+                for(std::size_t n=0; n < p_prototypes.size1(); ++n)
+                    ublas::row(l_adaptmatrix, n)  = m_distance.getDistance( p_data[i], ublas::row(p_prototypes, n) );
+                
+                // for every column ranks values and create adapts
+                #pragma omp parallel for shared(l_adaptmatrix)
+                for(std::size_t n=0; n < l_adaptmatrix.size2(); ++n) {
+                    ublas::vector<T> l_column                = ublas::column(l_adaptmatrix, n);
+                    const ublas::vector<std::size_t> l_rank  = tools::vector::rank(l_column);
+                    
+                    for(std::size_t j=0; j < l_rank.size(); ++j)
+                        l_adaptmatrix(j,n) = p_lambda(l_rank(j));
+                }
+                
+                // add multiplier
+                if (!p_multiplier.empty()) {
+                    #pragma omp parallel for shared(l_adaptmatrix)
+                    for(std::size_t n=0; n < l_adaptmatrix.size1(); ++n)
+                        ublas::row(l_adaptmatrix, n) = ublas::element_prod( ublas::row(l_adaptmatrix, n), p_multiplier[i] );
+                }
+                
+                // create partial sums
+                ublas::subrange(l_send[i], 0, p_prototypes.size1(), 0, p_prototypes.size2()) = ublas::prod( l_adaptmatrix, p_data[i] );
+                
+                #pragma omp parallel for shared(l_send)
+                for(std::size_t n=0; n < l_adaptmatrix.size1(); ++n)
+                    l_send[i](n, p_prototypes.size2()) = ublas::sum( ublas::row(l_adaptmatrix, n) );
+            }
+            
+            // start the reduction of the block and continue with the next one
+            l_request[i] = mpi::iall_reduce( p_mpi, &(l_send[i].data()[0]), static_cast<int>(l_send[i].data().size()), &(l_receive[i].data()[0]), std::plus<T>() );
+        }
         
-        // collect the norm and prototype data in each process
-		std::vector< ublas::vector<T> > l_collectnorm;
-        std::vector< ublas::matrix<T> > l_collectprototypes;
+        mpi::wait_all( l_request.begin(), l_request.end() );
         
-        mpi::all_to_all( p_mpi, l_norm, l_collectnorm );
-        mpi::all_to_all( p_mpi, l_prototypes, l_collectprototypes );
         
+        // sum the blocks and normalize the prototypes
+        ublas::matrix<T> l_sum = std::accumulate( l_receive.begin(), l_receive.end(), ublas::matrix<T>(p_prototypes.size1(), l_columns, 0) );
+        ublas::matrix<T> l_prototypes = ublas::subrange(l_sum, 0, p_prototypes.size1(), 0, p_prototypes.size2());
         
-        // both std::vectors will be summerized
-        m_prototypes = std::accumulate( l_collectprototypes.begin(), l_collectprototypes.end(), ublas::matrix<T>(m_prototypes.size1(), m_prototypes.size2(), 0) );
-        const ublas::vector<T> l_sumnorm    = std::accumulate( l_collectnorm.begin(), l_collectnorm.end(), ublas::vector<T>(l_collectnorm[0].size(), 0) );
+        for(std::size_t i=0; i < l_prototypes.size1(); ++i)
+            if (!tools::function::isNumericalZero(l_sum(i, p_prototypes.size2())))
+                ublas::row(l_prototypes, i) /= l_sum(i, p_prototypes.size2());
         
-        // normalize the prototypes
-        for(std::size_t i=0; i < l_sumnorm.size(); ++i)
-            if (!tools::function::isNumericalZero(l_sumnorm(i)))
-                ublas::row(m_prototypes, i) /= l_sumnorm(i);
+        return l_prototypes;
+    }
+    
+    
+    /** sets the local prototypes of the process from the full prototype matrix
+     * @param p_mpi MPI object for communication
+     * @param p_prototypes full prototype matrix
+     **/
+    template<typename T> inline void neuralgas<T>::setLocalPrototypes( const mpi::communicator& p_mpi, const ublas::matrix<T>& p_prototypes )
+    {
+        const std::pair<std::size_t,std::size_t>& l_info = m_processprototypinfo[static_cast<std::size_t>(p_mpi.rank())];
+        m_prototypes = ublas::subrange(p_prototypes, l_info.first, l_info.first+l_info.second, 0, p_prototypes.size2());
     }
     
     
@@ -626,18 +721,6 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
     }
     
     
-    /** returns the number of all prototypes
-     * @param p_mpi MPI object for communication
-     * @return number of prototypes
-     **/
-    template<typename T> inline std::size_t neuralgas<T>::getNumberPrototypes( const mpi::communicator& p_mpi ) const
-    {
-        std::size_t l_count = 0;
-        mpi::all_reduce(p_mpi, m_prototypes.size1(), l_count, std::plus<std::size_t>());
-        return l_count;
-    }
-    
-    
     /** train the data on the cluster
      * @param p_mpi MPI object for communication
      * @param p_data datapoints
@@ -683,11 +766,12 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
         }
         
         
-        // run neural gas       
+        // run neural gas (the data is split into blocks for overlapping the communication)
         const T l_multi = 0.01/l_lambdaMPI;
-        ublas::vector<T> l_normvec( getNumberPrototypes(p_mpi), 0 );
-        ublas::vector<T> l_lambda(l_normvec.size());
-        ublas::matrix<T> l_adaptmatrix( l_normvec.size(), p_data.size1() );
+        const std::vector< ublas::matrix<T> > l_data = splitData( p_mpi, p_data );
+        const std::vector< ublas::vector<T> > l_multiplier;
+        ublas::matrix<T> l_prototypes = gatherAllPrototypes( p_mpi );
+        ublas::vector<T> l_lambda(l_prototypes.size1());
         
         for(std::size_t i=0; (i < l_iterationsMPI); ++i) {
             
@@ -697,10 +781,6 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
             #pragma omp parallel for shared(l_lambda)
             for(std::size_t n=0; n < l_lambda.size(); ++n)
                 l_lambda(n) = std::exp( -static_cast<T>(n) / l_lambdahelp );
-
-            
-            // we get all prototypes of every process
-            ublas::matrix<T> l_prototypes = gatherAllPrototypes( p_mpi );
             
             
             // determine quantization error for logging
@@ -710,37 +790,9 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
             }
             
             
-            // calculate for every prototype the distance (of the actually prototypes).
-            // within the adapt matrix, we must specify the position of the prototypes 
-            #pragma omp parallel for shared(l_adaptmatrix)
-            for(std::size_t n=0; n < l_prototypes.size1(); ++n)
-                ublas::row(l_adaptmatrix, n)  = m_distance.getDistance( p_data, ublas::row(l_prototypes, n) ) ;
-            
-            
-            // for every column ranks values and create adapts
-            // we need rank and not randIndex, because we 
-            // use the value of the ranking for getting the 
-            // adapt value
-            #pragma omp parallel for shared(l_adaptmatrix)
-            for(std::size_t n=0; n < l_adaptmatrix.size2(); ++n) {
-                ublas::vector<T> l_column                = ublas::column(l_adaptmatrix, n);
-                const ublas::vector<std::size_t> l_rank  = tools::vector::rank(l_column);
-                
-                for(std::size_t j=0; j < l_rank.size(); ++j)
-                    l_adaptmatrix(j,n) = l_lambda(l_rank(j));
-            }
-            
-            
-            // create local prototypes
-            l_prototypes = ublas::prod( l_adaptmatrix, p_data );
-            
-            
-            // normalize prototypes
-            #pragma omp parallel for shared(l_normvec)
-            for(std::size_t n=0; n < l_prototypes.size1(); ++n)
-                l_normvec(n) = ublas::sum( ublas::row(l_adaptmatrix, n) );
-            
-            synchronizePrototypes(p_mpi, l_prototypes, l_normvec);
+            // every process gets the full prototype matrix of the reduced sums, so the prototypes need not be gathered
+            l_prototypes = reducePrototypes( p_mpi, l_data, l_multiplier, l_prototypes, l_lambda );
+            setLocalPrototypes( p_mpi, l_prototypes );
         }
     }
     
@@ -913,7 +965,8 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
      **/
     template<typename T> inline void neuralgas<T>::trainpatch( const mpi::communicator& p_mpi, const ublas::matrix<T>& p_data, const std::size_t& p_iterations )
     {
-        trainpatch( p_mpi, p_data, p_iterations, m_prototypes.size1() * 0.5);
+        // if the process has no prototypes, than lambda need not be zero, so we set it to a minimal numerical value, so the exception is not thrown
+        trainpatch( p_mpi, p_data, p_iterations, ((m_prototypes.size1() == 0) ? std::numeric_limits<T>::epsilon() :  m_prototypes.size1() * 0.5) );
     }
     
     /** synchronize the weights of each prototype
@@ -1005,11 +1058,12 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
         }
         
         
-        // run neural gas       
+        // run neural gas (the data is split into blocks for overlapping the communication)
         const T l_multi = 0.01/l_lambdaMPI;
-        ublas::vector<T> l_normvec( getNumberPrototypes(p_mpi), 0 );
-        ublas::vector<T> l_lambda(l_normvec.size());
-        ublas::matrix<T> l_adaptmatrix( l_normvec.size(), l_data.size1() );
+        const std::vector< ublas::matrix<T> > l_datablocks       = splitData( p_mpi, l_data );
+        const std::vector< ublas::vector<T> > l_multiplierblocks = splitMultiplier( l_datablocks, l_multiplier );
+        ublas::matrix<T> l_prototypes = gatherAllPrototypes( p_mpi );
+        ublas::vector<T> l_lambda(l_prototypes.size1());
         
         for(std::size_t i=0; (i < l_iterationsMPI); ++i) {
             
@@ -1019,53 +1073,18 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
             #pragma omp parallel for shared(l_lambda)
             for(std::size_t n=0; n < l_lambda.size(); ++n)
                 l_lambda(n) = std::exp( -static_cast<T>(n) / l_lambdahelp );
-
-            
-            // we get all prototypes of every process
-            ublas::matrix<T> l_prototypes = gatherAllPrototypes( p_mpi );
             
             
             // determine quantization error for logging
             if (m_logging) {
                 m_logprototypes.push_back( m_prototypes );
-                m_quantizationerror.push_back( calculateQuantizationError(l_data, m_prototypes) );
-            }
-            
-            
-            // calculate for every prototype the distance
-            #pragma omp parallel for shared(l_adaptmatrix)
-            for(std::size_t n=0; n < l_prototypes.size1(); ++n)
-                ublas::row(l_adaptmatrix, n)  = m_distance.getDistance( l_data, ublas::row(l_prototypes, n) ) ;
-            
-            
-            // for every column ranks values and create adapts
-            // we need rank and not randIndex, because we 
-            // use the value of the ranking for getting the 
-            // adapt value
-            #pragma omp parallel for shared(l_adaptmatrix)
-            for(std::size_t n=0; n < l_adaptmatrix.size2(); ++n) {
-                ublas::vector<T> l_column                = ublas::column(l_adaptmatrix, n);
-                const ublas::vector<std::size_t> l_rank  = tools::vector::rank(l_column);
-                
-                for(std::size_t j=0; j < l_rank.size(); ++j)
-                    l_adaptmatrix(j,n) = l_lambda(l_rank(j));
+                m_quantizationerror.push_back( calculateQuantizationError(l_data, l_prototypes) );
             }
             
             
-            // add multiplier
-            #pragma omp parallel for shared(l_adaptmatrix)
-            for(std::size_t n=0; n < l_adaptmatrix.size1(); ++n)
-                ublas::row(l_adaptmatrix, n) = ublas::element_prod( ublas::row(l_adaptmatrix, n), l_multiplier );
-            
-            // create local prototypes
-            l_prototypes = ublas::prod( l_adaptmatrix, l_data );
-            
-            
-            // normalize prototypes and sync them on each process
-            #pragma omp parallel for shared(l_normvec)
-            for(std::size_t n=0; n < l_prototypes.size1(); ++n)
-                l_normvec(n) = ublas::sum( ublas::row(l_adaptmatrix, n) );
-            synchronizePrototypes(p_mpi, l_prototypes, l_normvec);
+            // every process gets the full prototype matrix of the reduced sums, so the prototypes need not be gathered
+            l_prototypes = reducePrototypes( p_mpi, l_datablocks, l_multiplierblocks, l_prototypes, l_lambda );
+            setLocalPrototypes( p_mpi, l_prototypes );
         }
         
         // determine size of receptive fields, but we use only the data points
@@ -0,0 +1,511 @@
+/**
+ @cond
+ ############################################################################
+ # LGPL License                                                             #
+ #                                                                          #
+ # This file is part of the Machine Learning Framework.                     #
+ # Copyright (c) 2010-2012, Philipp Kraus, <philipp.kraus@flashpixx.de>     #
+ # This program is free software: you can redistribute it and/or modify     #
+ # it under the terms of the GNU Lesser General Public License as           #
+ # published by the Free Software Foundation, either version 3 of the       #
+ # License, or (at your option) any later version.                          #
+ #                                                                          #
+ # This program is distributed in the hope that it will be useful,          #
+ # but WITHOUT ANY WARRANTY; without even the implied warranty of           #
+ # MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            #
+ # GNU Lesser General Public License for more details.                      #
+ #                                                                          #
+ # You should have received a copy of the GNU Lesser General Public License #
+ # along with this program. If not, see <http://www.gnu.org/licenses/>.     #
+ ############################################################################
+ @endcond
+ **/
+
+#ifdef MACHINELEARNING_FILES
+
+#ifndef __MACHINELEARNING_CLUSTERING_NONSUPERVISED_PATCHTRAINER_HPP
+#define __MACHINELEARNING_CLUSTERING_NONSUPERVISED_PATCHTRAINER_HPP
+
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+#include <boost/numeric/ublas/matrix.hpp>
+#include "clustering.hpp"
+#include "../../errorhandling/exception.hpp"
+#include "../../tools/tools.h"
+
+
+
+namespace machinelearning { namespace clustering { namespace nonsupervised {
+
+    #ifndef SWIG
+    namespace ublas = boost::numeric::ublas;
+    #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
+    namespace mpi   = machinelearning::tools::communication;
+    #endif
+    #endif
+
+
+    /** abstract class for a source of patches. The read method is called
+     * by the prefetch thread of the patch trainer, so it must not share any
+     * state with the calling thread during the training
+     **/
+    template<typename T> class patchsource
+    {
+        #ifndef SWIG
+        BOOST_STATIC_ASSERT( !boost::is_integral<T>::value );
+        #endif
+
+
+        public :
+
+            /** returns the number of patches **/
+            virtual std::size_t size( void ) const = 0;
+
+            /** reads the patch data (row orientated) **/
+            virtual ublas::matrix<T> read( const std::size_t& ) const = 0;
+
+            virtual ~patchsource( void ) {};
+    };
+
+
+
+    /** patch source for a list of CSV files, each file is one patch **/
+    template<typename T> class csvpatchsource : public patchsource<T>
+    {
+
+        public :
+
+            csvpatchsource( const std::vector<std::string>&, const std::string& = ",; \t", const bool& = false );
+            std::size_t size( void ) const;
+            ublas::matrix<T> read( const std::size_t& ) const;
+
+
+        private :
+
+            /** list of files **/
+            const std::vector<std::string> m_files;
+            /** separator characters **/
+            const std::string m_separator;
+            /** files have a size header **/
+            const bool m_header;
+
+    };
+
+
+
+    #ifdef MACHINELEARNING_FILES_HDF
+
+    /** patch source for a HDF file, each patch can be a full dataset or a row
+     * block of a dataset, so a large dataset must not be read completely
+     **/
+    template<typename T> class hdfpatchsource : public patchsource<T>
+    {
+
+        public :
+
+            hdfpatchsource( const std::string&, const std::vector<std::string>&, const tools::files::hdf::datatype& = tools::files::hdf::NATIVE_DOUBLE );
+            hdfpatchsource( const std::string&, const std::string&, const std::size_t&, const tools::files::hdf::datatype& = tools::files::hdf::NATIVE_DOUBLE );
+            hdfpatchsource( const std::string&, const std::string&, const std::vector< std::pair<std::size_t,std::size_t> >&, const tools::files::hdf::datatype& = tools::files::hdf::NATIVE_DOUBLE );
+            std::size_t size( void ) const;
+            ublas::matrix<T> read( const std::size_t& ) const;
+
+
+        private :
+
+            /** patch definition with dataset path, first row and number of rows (zero rows reads the full dataset) **/
+            struct patch
+            {
+                std::string path;
+                std::size_t row;
+                std::size_t rows;
+            };
+
+            /** HDF file **/
+            const tools::files::hdf m_file;
+            /** datatype of the datasets **/
+            const tools::files::hdf::datatype m_datatype;
+            /** patch definitions **/
+            std::vector<patch> m_patches;
+
+    };
+
+    #endif
+
+
+
+    /** class for running patch clustering with a patch source. The next patch
+     * is read and parsed on a background thread while the current patch is trained,
+     * so the I/O is overlapped with the computation. The prototypes and their weights
+     * are stored within the clustering object between the patches.
+     * @note the clustering object and the source must not be used by another thread during the training
+     **/
+    template<typename T> class patchtrainer
+    {
+
+        public :
+
+            patchtrainer( const patchsource<T>& );
+            std::size_t getPatchCount( void ) const;
+            std::size_t getPatchIndex( void ) const;
+            bool hasNext( void ) const;
+            void reset( void );
+            void trainpatch( patchclustering<T>&, const std::size_t& );
+            void train( patchclustering<T>&, const std::size_t& );
+
+            #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
+            void trainpatch( const mpi::communicator&, mpipatchclustering<T>&, const std::size_t& );
+            void train( const mpi::communicator&, mpipatchclustering<T>&, const std::size_t& );
+            #endif
+
+
+        private :
+
+            /** patch source **/
+            const patchsource<T>& m_source;
+            /** index of the next patch **/
+            std::size_t m_index;
+            /** patch data of the next patch **/
+            ublas::matrix<T> m_patch;
+            /** bool if the data of the next patch is read **/
+            bool m_loaded;
+            /** prefetched data **/
+            ublas::matrix<T> m_prefetch;
+            /** error message of the prefetch thread **/
+            std::string m_error;
+
+            void prefetch( const std::size_t& );
+            void load( void );
+            void next( void );
+
+    };
+
+
+
+    /** constructor
+     * @param p_files list of files
+     * @param p_separator characters for sperator (default , ; \\t blank)
+     * @param p_header first element in each file is the size of the matrix
+     **/
+    template<typename T> inline csvpatchsource<T>::csvpatchsource( const std::vector<std::string>& p_files, const std::string& p_separator, const bool& p_header ) :
+        m_files( p_files ),
+        m_separator( p_separator ),
+        m_header( p_header )
+    {
+        if (p_files.empty())
+            throw exception::runtime(_("file list can not be empty"), *this);
+    }
+
+
+    /** returns the number of patches
+     * @return number of files
+     **/
+    template<typename T> inline std::size_t csvpatchsource<T>::size( void ) const
+    {
+        return m_files.size();
+    }
+
+
+    /** reads a patch
+     * @param p_index patch index
+     * @return data matrix
+     **/
+    template<typename T> inline ublas::matrix<T> csvpatchsource<T>::read( const std::size_t& p_index ) const
+    {
+        if (p_index >= m_files.size())
+            throw exception::runtime(_("patch index out of range"), *this);
+
+        tools::files::csv l_csv;
+        return l_csv.readBlasMatrix<T>( m_files[p_index], m_separator, m_header );
+    }
+
+
+
+    #ifdef MACHINELEARNING_FILES_HDF
+
+    /** constructor, each dataset is one patch
+     * @param p_file HDF file
+     * @param p_paths dataset paths
+     * @param p_datatype datatype of the datasets
+     **/
+    template<typename T> inline hdfpatchsource<T>::hdfpatchsource( const std::string& p_file, const std::vector<std::string>& p_paths, const tools::files::hdf::datatype& p_datatype ) :
+        m_file( p_file ),
+        m_datatype( p_datatype ),
+        m_patches()
+    {
+        if (p_paths.empty())
+            throw exception::runtime(_("path list can not be empty"), *this);
+
+        for(std::size_t i=0; i < p_paths.size(); ++i) {
+            patch l_patch = { p_paths[i], 0, 0 };
+            m_patches.push_back(l_patch);
+        }
+    }
+
+
+    /** constructor, the dataset is split into row blocks with an equal size (the last block can be smaller)
+     * @param p_file HDF file
+     * @param p_path dataset path
+     * @param p_rows number of rows of each patch
+     * @param p_datatype datatype of the dataset
+     **/
+    template<typename T> inline hdfpatchsource<T>::hdfpatchsource( const std::string& p_file, const std::string& p_path, const std::size_t& p_rows, const tools::files::hdf::datatype& p_datatype ) :
+        m_file( p_file ),
+        m_datatype( p_datatype ),
+        m_patches()
+    {
+        if (p_rows == 0)
+            throw exception::runtime(_("number of rows must be greater than zero"), *this);
+
+        const std::size_t l_rows = m_file.getBlasMatrixSize(p_path).first;
+        for(std::size_t i=0; i < l_rows; i += p_rows) {
+            patch l_patch = { p_path, i, std::min(p_rows, l_rows-i) };
+            m_patches.push_back(l_patch);
+        }
+    }
+
+
+    /** constructor, each row range of the dataset is one patch
+     * @param p_file HDF file
+     * @param p_path dataset path
+     * @param p_ranges std::vector with pairs of first row and number of rows
+     * @param p_datatype datatype of the dataset
+     **/
+    template<typename T> inline hdfpatchsource<T>::hdfpatchsource( const std::string& p_file, const std::string& p_path, const std::vector< std::pair<std::size_t,std::size_t> >& p_ranges, const tools::files::hdf::datatype& p_datatype ) :
+        m_file( p_file ),
+        m_datatype( p_datatype ),
+        m_patches()
+    {
+        if (p_ranges.empty())
+            throw exception::runtime(_("range list can not be empty"), *this);
+
+        for(std::size_t i=0; i < p_ranges.size(); ++i) {
+            if (p_ranges[i].second == 0)
+                throw exception::runtime(_("number of rows must be greater than zero"), *this);
+
+            patch l_patch = { p_path, p_ranges[i].first, p_ranges[i].second };
+            m_patches.push_back(l_patch);
+        }
+    }
+
+
+    /** returns the number of patches
+     * @return number of patches
+     **/
+    template<typename T> inline std::size_t hdfpatchsource<T>::size( void ) const
+    {
+        return m_patches.size();
+    }
+
+
+    /** reads a patch
+     * @param p_index patch index
+     * @return data matrix
+     **/
+    template<typename T> inline ublas::matrix<T> hdfpatchsource<T>::read( const std::size_t& p_index ) const
+    {
+        if (p_index >= m_patches.size())
+            throw exception::runtime(_("patch index out of range"), *this);
+
+        if (m_patches[p_index].rows == 0)
+            return m_file.readBlasMatrix<T>( m_patches[p_index].path, m_datatype );
+
+        return m_file.readBlasMatrix<T>( m_patches[p_index].path, m_patches[p_index].row, m_patches[p_index].rows, m_datatype );
+    }
+
+    #endif
+
+
+
+    /** constructor
+     * @param p_source patch source
+     **/
+    template<typename T> inline patchtrainer<T>::patchtrainer( const patchsource<T>& p_source ) :
+        m_source( p_source ),
+        m_index( 0 ),
+        m_patch(),
+        m_loaded( false ),
+        m_prefetch(),
+        m_error()
+    {
+        if (p_source.size() == 0)
+            throw exception::runtime(_("patch source can not be empty"), *this);
+    }
+
+
+    /** returns the number of patches
+     * @return number of patches
+     **/
+    template<typename T> inline std::size_t patchtrainer<T>::getPatchCount( void ) const
+    {
+        return m_source.size();
+    }
+
+
+    /** returns the index of the next patch
+     * @return index
+     **/
+    template<typename T> inline std::size_t patchtrainer<T>::getPatchIndex( void ) const
+    {
+        return m_index;
+    }
+
+
+    /** returns the bool if a patch is left
+     * @return bool
+     **/
+    template<typename T> inline bool patchtrainer<T>::hasNext( void ) const
+    {
+        return m_index < m_source.size();
+    }
+
+
+    /** restarts on the first patch **/
+    template<typename T> inline void patchtrainer<T>::reset( void )
+    {
+        m_index  = 0;
+        m_loaded = false;
+        m_patch.resize(0, 0, false);
+    }
+
+
+    /** thread method, that reads the patch data
+     * @param p_index patch index
+     **/
+    template<typename T> inline void patchtrainer<T>::prefetch( const std::size_t& p_index )
+    {
+        try {
+            m_prefetch = m_source.read(p_index);
+        } catch (const std::exception& e) {
+            m_error = e.what();
+        } catch (...) {
+            m_error = _("unknown error on reading the patch");
+        }
+    }
+
+
+    /** reads the next patch synchronously, if it is not prefetched **/
+    template<typename T> inline void patchtrainer<T>::load( void )
+    {
+        if (!hasNext())
+            throw exception::runtime(_("no patch is left"), *this);
+
+        if (!m_loaded) {
+            m_patch  = m_source.read(m_index);
+            m_loaded = true;
+        }
+    }
+
+
+    /** moves the prefetched data to the next patch and checks the error of the prefetch thread **/
+    template<typename T> inline void patchtrainer<T>::next( void )
+    {
+        m_index++;
+        m_loaded = false;
+
+        if (!m_error.empty()) {
+            const std::string l_error = m_error;
+            m_error.clear();
+            throw exception::runtime(l_error, *this);
+        }
+
+        if (hasNext()) {
+            m_patch.swap(m_prefetch);
+            m_prefetch.resize(0, 0, false);
+            m_loaded = true;
+        }
+    }
+
+
+    /** trains the next patch and reads the following patch on a background thread
+     * @param p_cluster patch clustering object
+     * @param p_iterations number of iterations
+     **/
+    template<typename T> inline void patchtrainer<T>::trainpatch( patchclustering<T>& p_cluster, const std::size_t& p_iterations )
+    {
+        load();
+
+        if (m_index+1 < m_source.size()) {
+            boost::thread l_thread( boost::bind( &patchtrainer<T>::prefetch, this, m_index+1 ) );
+
+            try {
+                p_cluster.trainpatch( m_patch, p_iterations );
+            } catch (...) {
+                l_thread.join();
+                throw;
+            }
+            l_thread.join();
+        } else
+            p_cluster.trainpatch( m_patch, p_iterations );
+
+        next();
+    }
+
+
+    /** trains all patches, that are left
+     * @param p_cluster patch clustering object
+     * @param p_iterations number of iterations
+     **/
+    template<typename T> inline void patchtrainer<T>::train( patchclustering<T>& p_cluster, const std::size_t& p_iterations )
+    {
+        while (hasNext())
+            trainpatch( p_cluster, p_iterations );
+    }
+
+
+
+    //======= MPI ==================================================================================================================================
+    #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
+
+    /** trains the next patch and reads the following patch on a background thread. Each process
+     * uses its own patch source, so all sources must have the same number of patches
+     * @param p_mpi MPI object for communication
+     * @param p_cluster patch clustering object
+     * @param p_iterations number of iterations
+     **/
+    template<typename T> inline void patchtrainer<T>::trainpatch( const mpi::communicator& p_mpi, mpipatchclustering<T>& p_cluster, const std::size_t& p_iterations )
+    {
+        load();
+
+        if (m_index+1 < m_source.size()) {
+            boost::thread l_thread( boost::bind( &patchtrainer<T>::prefetch, this, m_index+1 ) );
+
+            try {
+                p_cluster.trainpatch( p_mpi, m_patch, p_iterations );
+            } catch (...) {
+                l_thread.join();
+                throw;
+            }
+            l_thread.join();
+        } else
+            p_cluster.trainpatch( p_mpi, m_patch, p_iterations );
+
+        next();
+    }
+
+
+    /** trains all patches, that are left
+     * @param p_mpi MPI object for communication
+     * @param p_cluster patch clustering object
+     * @param p_iterations number of iterations
+     **/
+    template<typename T> inline void patchtrainer<T>::train( const mpi::communicator& p_mpi, mpipatchclustering<T>& p_cluster, const std::size_t& p_iterations )
+    {
+        const std::size_t l_min = mpi::all_reduce(p_mpi, m_source.size(), mpi::minimum<std::size_t>());
+        const std::size_t l_max = mpi::all_reduce(p_mpi, m_source.size(), mpi::maximum<std::size_t>());
+        if (l_min != l_max)
+            throw exception::runtime(_("number of patches must be equal on each process"), *this);
+
+        while (hasNext())
+            trainpatch( p_mpi, p_cluster, p_iterations );
+    }
+
+    #endif
+
+}}}
+#endif
+#endif
@@ -31,10 +31,6 @@
 #include <boost/numeric/ublas/matrix.hpp>
 #include <boost/numeric/ublas/vector.hpp>
 
-#ifdef MACHINELEARNING_MPI
-#include <boost/mpi.hpp>
-#endif
-
 #include "clustering.hpp"
 #include "../../errorhandling/exception.hpp"
 #include "../../tools/tools.h"
@@ -46,8 +42,8 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
     
     #ifndef SWIG
     namespace ublas = boost::numeric::ublas;
-    #ifdef MACHINELEARNING_MPI
-    namespace mpi   = boost::mpi;
+    #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
+    namespace mpi   = machinelearning::tools::communication;
     #endif
     #endif
     
@@ -90,7 +86,7 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
      * @endcode
      **/
     template<typename T> class relational_neuralgas : public clustering<T> 
-        #ifdef MACHINELEARNING_MPI 
+        #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
         , public mpiclustering<T>
         #endif
     {
@@ -111,7 +107,7 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
             ublas::indirect_array<> use( const ublas::matrix<T>& ) const;
         
         
-            #ifdef MACHINELEARNING_MPI
+            #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
             void train( const mpi::communicator&, const ublas::matrix<T>&, const std::size_t& );
             void train( const mpi::communicator&, const ublas::matrix<T>&, const std::size_t&, const T& );
             ublas::matrix<T> getPrototypes( const mpi::communicator& ) const;
@@ -136,7 +132,7 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
             T calculateQuantizationError( const ublas::matrix<T>& ) const;
             ublas::matrix<T> calcDistance( const ublas::matrix<T>&, const ublas::matrix<T>& ) const;
         
-            #ifdef MACHINELEARNING_MPI
+            #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
             /** vector with information to every process and width of the prototype / data matrix **/
             std::vector< std::pair<std::size_t,std::size_t> > m_processdatainfo;        
             /** vector with information to every process and prototype**/
@@ -161,7 +157,7 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
         m_logging( false ),
         m_logprototypes( std::vector< ublas::matrix<T> >() ),
         m_quantizationerror( std::vector<T>() )
-        #ifdef MACHINELEARNING_MPI
+        #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
         , m_processdatainfo(),
         m_processprototypinfo()
         #endif
@@ -399,7 +395,7 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
     }
     
     //======= MPI ==================================================================================================================================
-    #ifdef MACHINELEARNING_MPI
+    #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
     
     /** gathering prototypes of every process and return the full prototypes matrix (row oriantated)
      * @param p_mpi MPI object for communication
@@ -27,6 +27,7 @@
 #include <omp.h>
 
 #include <boost/numeric/ublas/matrix.hpp>
+#include <boost/numeric/ublas/matrix_sparse.hpp>
 #include <boost/numeric/ublas/vector.hpp>
 #include <boost/numeric/bindings/blas.hpp>
 
@@ -47,8 +48,10 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
     
     /** class for normalized spectral clustering. This class calculates only the graph laplacian
      * and creates the general eigenvector decomposition. A neuralgas algorithm with euclidian
-     * distancesis used for clustering the data
-     * @todo set all routines to sparse matrix if arpack can be used with boost
+     * distancesis used for clustering the data. A sparse (symmetric) adjacency matrix, eg a kNN graph,
+     * is decomposed with a Lanczos iteration, which calculates only the needed eigenvectors. The eigenvectors
+     * of the training are stored, so new points are embedded with the Nyström extension (the use method
+     * gets the affinity matrix between the new points [rows] and the training points [columns])
      * @todo create eigengap heurstic
      **/
     template<typename T> class spectralclustering : public clustering<T>
@@ -65,18 +68,30 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
             std::size_t getPrototypeCount( void ) const;
             std::vector<T> getLoggedQuantizationError( void ) const;
             ublas::indirect_array<> use( const ublas::matrix<T>& ) const;
+            #ifndef SWIG
+            void train( const ublas::compressed_matrix<T>&, const std::size_t& );
+            ublas::indirect_array<> use( const ublas::compressed_matrix<T>& ) const;
+            #endif
             
             //static std::size_t getEigenGap( const ublas::matrix<T>& ) const;
 
 
         private :
         
-            ublas::matrix<T> getEigenGraphLaplacian( const ublas::matrix<T>& p_adjacency ) const;
+            ublas::matrix<T> getEigenGraphLaplacian( const ublas::matrix<T>&, ublas::vector<T>& ) const;
+            #ifndef SWIG
+            ublas::matrix<T> getEigenGraphLaplacian( const ublas::compressed_matrix<T>&, ublas::vector<T>& ) const;
+            #endif
+            ublas::matrix<T> getNystroemEmbedding( const ublas::matrix<T>&, const ublas::vector<T>& ) const;
         
             /** distance object for clustering (we use euclidan distances) **/
             const distances::norm::euclid<T> m_distance;
             /** neural gas for clustering the graph laplacian **/
             kmeans<T> m_kmeans;
+            /** eigenvectors of the training graph laplacian (rows = training points) **/
+            ublas::matrix<T> m_eigenvector;
+            /** eigenvalues of the random-walk matrix D^-1 W for each eigenvector **/
+            ublas::vector<T> m_eigenvalue;
         
     };
     
@@ -86,7 +101,9 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
      **/
     template<typename T> inline spectralclustering<T>::spectralclustering( const std::size_t& p_prototypes ) :
         m_distance( distances::norm::euclid<T>() ),
-        m_kmeans( kmeans<T>( m_distance, p_prototypes, p_prototypes) )
+        m_kmeans( kmeans<T>( m_distance, p_prototypes, p_prototypes) ),
+        m_eigenvector(),
+        m_eigenvalue()
     {}
     
     
@@ -158,9 +175,10 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
     
     /** creates the cluster matrix of the graph laplacian
      * @param p_adjacency adjacency matrix
+     * @param p_eigenvalue vector for the eigenvalues of the random-walk matrix [initialisation is not needed]
      * @return data matrix for the k-means clustering
      **/
-    template<typename T> inline ublas::matrix<T> spectralclustering<T>::getEigenGraphLaplacian( const ublas::matrix<T>& p_adjacency ) const
+    template<typename T> inline ublas::matrix<T> spectralclustering<T>::getEigenGraphLaplacian( const ublas::matrix<T>& p_adjacency, ublas::vector<T>& p_eigenvalue ) const
     {
         // get the normalized graph laplacian
         const ublas::matrix<T> l_laplacian = tools::lapack::normalizedGraphLaplacian( p_adjacency );
@@ -173,31 +191,146 @@ namespace machinelearning { namespace clustering { namespace nonsupervised {
         // ranking eigenvalues and get the k smallest for the eigenvectors
         const ublas::indirect_array<> l_rank = tools::vector::rankIndex<T>(l_eigenvalue);
         ublas::matrix<T> l_eigenmatrix( p_adjacency.size1(), m_kmeans.getPrototypeCount() );
+        p_eigenvalue.resize( l_eigenmatrix.size2(), false );
 
         for(std::size_t i=0; i < l_eigenmatrix.size2(); ++i)
+        {
             ublas::column(l_eigenmatrix, i) = ublas::column(l_eigenvector, l_rank(i));
+            p_eigenvalue(i)                 = static_cast<T>(1) - l_eigenvalue(l_rank(i));
+        }
         
         return l_eigenmatrix;
     }
         
     
+    /** creates the cluster matrix of the graph laplacian of a sparse adjacency matrix. The smallest eigenvalues
+     * of the normalized laplacian L = I - D^-1 W are the largest eigenvalues of the symmetric matrix D^-1/2 W D^-1/2,
+     * which are calculated with the Lanczos iteration. The eigenvectors are transformed back with D^-1/2
+     * @param p_adjacency symmetric sparse adjacency matrix
+     * @param p_eigenvalue vector for the eigenvalues of the random-walk matrix [initialisation is not needed]
+     * @return data matrix for the k-means clustering
+     **/
+    template<typename T> inline ublas::matrix<T> spectralclustering<T>::getEigenGraphLaplacian( const ublas::compressed_matrix<T>& p_adjacency, ublas::vector<T>& p_eigenvalue ) const
+    {
+        if (p_adjacency.size1() != p_adjacency.size2())
+            throw exception::runtime(_("matrix must be square"), *this);
+        
+        // inverse square root of the vertex degree
+        ublas::vector<T> l_scale( p_adjacency.size1(), 0 );
+        for(typename ublas::compressed_matrix<T>::const_iterator1 it = p_adjacency.begin1(); it != p_adjacency.end1(); ++it)
+            for(typename ublas::compressed_matrix<T>::const_iterator2 jt = it.begin(); jt != it.end(); ++jt)
+                l_scale(jt.index1()) += *jt;
+        for(std::size_t i=0; i < l_scale.size(); ++i)
+            l_scale(i) = tools::function::isNumericalZero(l_scale(i)) ? 0 : static_cast<T>(1) / std::sqrt(l_scale(i));
+        
+        // symmetric normalized adjacency D^-1/2 W D^-1/2 (iterators run in row order, so the elements can be appended)
+        ublas::compressed_matrix<T> l_normalized( p_adjacency.size1(), p_adjacency.size2(), p_adjacency.nnz() );
+        for(typename ublas::compressed_matrix<T>::const_iterator1 it = p_adjacency.begin1(); it != p_adjacency.end1(); ++it)
+            for(typename ublas::compressed_matrix<T>::const_iterator2 jt = it.begin(); jt != it.end(); ++jt)
+                l_normalized.push_back( jt.index1(), jt.index2(), l_scale(jt.index1()) * (*jt) * l_scale(jt.index2()) );
+        
+        // determine the k largest eigenvalues and -vectors (D^-1/2 W D^-1/2 and D^-1 W have the same eigenvalues)
+        ublas::matrix<T> l_eigenvector;
+        tools::lapack::lanczos( l_normalized, m_kmeans.getPrototypeCount(), p_eigenvalue, l_eigenvector );
+        
+        // eigenvectors of the normalized graph laplacian
+        for(std::size_t i=0; i < l_eigenvector.size2(); ++i)
+        {
+            ublas::column(l_eigenvector, i) = ublas::element_prod( ublas::column(l_eigenvector, i), l_scale );
+            
+            const T l_norm = blas::nrm2( static_cast< ublas::vector<T> >(ublas::column(l_eigenvector, i)) );
+            if (!tools::function::isNumericalZero(l_norm))
+                ublas::column(l_eigenvector, i) /= l_norm;
+        }
+        
+        return l_eigenvector;
+    }
+    
+    
     /** cluster the graph with the <strong>normalized</strong> graph laplacian
      * @param p_adjacency adjacency / distance matrix
      * @param p_iterations number of iterations
      **/
     template<typename T> inline void spectralclustering<T>::train( const ublas::matrix<T>& p_adjacency, const std::size_t& p_iterations )
     {
-        m_kmeans.train( getEigenGraphLaplacian(p_adjacency), p_iterations );
+        m_eigenvector = getEigenGraphLaplacian(p_adjacency, m_eigenvalue);
+        m_kmeans.train( m_eigenvector, p_iterations );
+    }
+    
+    
+    /** cluster the graph with the <strong>normalized</strong> graph laplacian
+     * @param p_adjacency symmetric sparse adjacency matrix
+     * @param p_iterations number of iterations
+     **/
+    template<typename T> inline void spectralclustering<T>::train( const ublas::compressed_matrix<T>& p_adjacency, const std::size_t& p_iterations )
+    {
+        m_eigenvector = getEigenGraphLaplacian(p_adjacency, m_eigenvalue);
+        m_kmeans.train( m_eigenvector, p_iterations );
+    }
+    
+    
+    /** embeds points with the Nyström extension of the stored eigenvectors. Each eigenvector of the
+     * random-walk matrix satisfies psi = 1/mu * D^-1 W psi, so a new point x gets the value
+     * psi(x) = 1/(mu d(x)) * sum_j w(x,j) psi(j) with d(x) = sum_j w(x,j)
+     * @param p_product product of the affinities with the stored eigenvectors (rows = points)
+     * @param p_degree degree (sum of the affinities) of each point
+     * @return data matrix for the k-means
+     **/
+    template<typename T> inline ublas::matrix<T> spectralclustering<T>::getNystroemEmbedding( const ublas::matrix<T>& p_product, const ublas::vector<T>& p_degree ) const
+    {
+        ublas::matrix<T> l_embedding( p_product );
+        
+        #pragma omp parallel for shared(l_embedding)
+        for(std::size_t i=0; i < l_embedding.size1(); ++i)
+            for(std::size_t j=0; j < l_embedding.size2(); ++j)
+            {
+                const T l_scale = p_degree(i) * m_eigenvalue(j);
+                l_embedding(i,j) = tools::function::isNumericalZero(l_scale) ? 0 : l_embedding(i,j) / l_scale;
+            }
+        
+        return l_embedding;
     }
     
     
-    /** returns the index for each datapoint to the prototype
-     * @param p_data input matrix
+    /** returns the index for each datapoint to the prototype. The points are embedded
+     * with the Nyström extension, so the eigensystem is not recomputed
+     * @param p_data affinity matrix between the points (rows) and the training points (columns), the
+     * training adjacency matrix returns the training assignment
      * @return array with index values
      **/
     template<typename T> inline ublas::indirect_array<> spectralclustering<T>::use( const ublas::matrix<T>& p_data ) const
     {
-        return m_kmeans.use( getEigenGraphLaplacian(p_data) );
+        if (m_eigenvector.size1() == 0)
+            throw exception::runtime(_("spectral clustering must be trained before use"), *this);
+        if (p_data.size2() != m_eigenvector.size1())
+            throw exception::runtime(_("number of columns must be equal to the number of training points"), *this);
+        
+        return m_kmeans.use( getNystroemEmbedding(ublas::prod(p_data, m_eigenvector), tools::matrix::sum(p_data)) );
+    }
+    
+    
+    /** returns the index for each datapoint to the prototype. The points are embedded
+     * with the Nyström extension, so the eigensystem is not recomputed
+     * @param p_data sparse affinity matrix between the points (rows) and the training points (columns)
+     * @return array with index values
+     **/
+    template<typename T> inline ublas::indirect_array<> spectralclustering<T>::use( const ublas::compressed_matrix<T>& p_data ) const
+    {
+        if (m_eigenvector.size1() == 0)
+            throw exception::runtime(_("spectral clustering must be trained before use"), *this);
+        if (p_data.size2() != m_eigenvector.size1())
+            throw exception::runtime(_("number of columns must be equal to the number of training points"), *this);
+        
+        ublas::matrix<T> l_product( p_data.size1(), m_eigenvector.size2(), 0 );
+        ublas::vector<T> l_degree( p_data.size1(), 0 );
+        for(typename ublas::compressed_matrix<T>::const_iterator1 it = p_data.begin1(); it != p_data.end1(); ++it)
+            for(typename ublas::compressed_matrix<T>::const_iterator2 jt = it.begin(); jt != it.end(); ++jt)
+            {
+                l_degree(jt.index1()) += *jt;
+                ublas::row(l_product, jt.index1()) += (*jt) * ublas::row(m_eigenvector, jt.index2());
+            }
+        
+        return m_kmeans.use( getNystroemEmbedding(l_product, l_degree) );
     }
     
         
@@ -28,6 +28,9 @@
 #include <boost/static_assert.hpp>
 #include <boost/numeric/ublas/matrix.hpp>
 #include <boost/numeric/ublas/vector.hpp>
+#ifdef MACHINELEARNING_MPI
+#include <boost/mpi.hpp>
+#endif
 
 #include "../../errorhandling/exception.hpp"
 #include "../../distances/distances.h"
@@ -40,6 +43,9 @@ namespace machinelearning {  namespace clustering {
             
             #ifndef SWIG
             namespace ublas = boost::numeric::ublas;
+            #ifdef MACHINELEARNING_MPI
+            namespace mpi   = boost::mpi;
+            #endif
             #endif
             
             
@@ -91,6 +97,42 @@ namespace machinelearning {  namespace clustering {
                 
             };
             
+            
+            
+            #ifdef MACHINELEARNING_MPI
+            
+            /** abstract class for supervised clustering with MPI interface **/
+            template<typename T, typename L> class mpiclustering
+            {
+                BOOST_STATIC_ASSERT( !boost::is_integral<T>::value );
+                
+                public :
+                
+                    /** MPI method for training prototypes **/
+                    virtual void train( const mpi::communicator&, const ublas::matrix<T>&, const std::vector<L>&, const std::size_t& ) = 0;
+                    
+                    /** MPI method which returns prototypes **/
+                    virtual ublas::matrix<T> getPrototypes( const mpi::communicator& ) const = 0;
+                    
+                    /** MPI method which returns the labels of the prototypes **/
+                    virtual std::vector<L> getPrototypesLabel( const mpi::communicator& ) const = 0;
+                    
+                    /** MPI method for returning history of trained prototypes **/
+                    virtual std::vector< ublas::matrix<T> > getLoggedPrototypes( const mpi::communicator& ) const = 0;
+                    
+                    /** MPI method for returning the quantizationerror **/
+                    virtual std::vector<T> getLoggedQuantizationError( const mpi::communicator& ) const = 0;
+                    
+                    /** MPI calculate prototype index for datapoints **/
+                    virtual ublas::indirect_array<> use( const mpi::communicator&, const ublas::matrix<T>& ) const = 0;
+                    
+                    /** MPI call for determine the distance without returning and input values, only for MPI connection **/
+                    virtual void use( const mpi::communicator& ) const = 0;
+                
+            };
+            
+            #endif
+            
         }
     
     }
@@ -29,6 +29,11 @@
 
 #include <boost/numeric/ublas/matrix.hpp>
 #include <boost/numeric/ublas/vector.hpp>
+#ifdef MACHINELEARNING_MPI
+#include <cmath>
+#include <limits>
+#include <boost/mpi.hpp>
+#endif
 
 #include "clustering.hpp"
 #include "../../errorhandling/exception.hpp"
@@ -41,6 +46,9 @@ namespace machinelearning { namespace clustering { namespace supervised {
     
     #ifndef SWIG
     namespace ublas   = boost::numeric::ublas;
+    #ifdef MACHINELEARNING_MPI
+    namespace mpi     = boost::mpi;
+    #endif
     #endif
     
     
@@ -48,8 +56,17 @@ namespace machinelearning { namespace clustering { namespace supervised {
      * RLVQ is not the best solution for overlapping cluster,
      * the class is created like a template class for free types
      * of the label structure
+     * @note The MPI methods use the data of each process as a shard of the whole data, every process owns
+     * the prototypes of its labels. The MPI training is a batch variant of the RLVQ: the prototypes are fixed
+     * during an iteration, each process sums the (signed) winner deltas and the number of winner points of its
+     * data and only these sums are reduced. The sums are applied with the step size, that the online update
+     * reaches with the same number of points. Because the batch update does not move the prototypes
+     * step by step into their class, the prototypes are initialized with the means of their label data
     **/
     template<typename T, typename L> class rlvq : public clustering<T, L> 
+        #ifdef MACHINELEARNING_MPI 
+        , public mpiclustering<T, L>
+        #endif
     {
         
         public:
@@ -68,6 +85,18 @@ namespace machinelearning { namespace clustering { namespace supervised {
             std::vector<T> getLoggedQuantizationError( void ) const;
             ublas::indirect_array<> use( const ublas::matrix<T>& ) const;
         
+            #ifdef MACHINELEARNING_MPI
+            void train( const mpi::communicator&, const ublas::matrix<T>&, const std::vector<L>&, const std::size_t& );
+            void train( const mpi::communicator&, const ublas::matrix<T>&, const std::vector<L>&, const std::size_t&, const T& );
+            void train( const mpi::communicator&, const ublas::matrix<T>&, const std::vector<L>&, const std::size_t&, const T&, const T& );
+            ublas::matrix<T> getPrototypes( const mpi::communicator& ) const;
+            std::vector<L> getPrototypesLabel( const mpi::communicator& ) const;
+            std::vector< ublas::matrix<T> > getLoggedPrototypes( const mpi::communicator& ) const;
+            std::vector<T> getLoggedQuantizationError( const mpi::communicator& ) const;
+            ublas::indirect_array<> use( const mpi::communicator&, const ublas::matrix<T>& ) const;
+            void use( const mpi::communicator& ) const;
+            #endif
+        
         
         private :
         
@@ -84,7 +113,17 @@ namespace machinelearning { namespace clustering { namespace supervised {
             /** std::vector with quantisation error in each iteration **/
             std::vector<T> m_quantizationerror;
         
-            T calculateQuantizationError( const ublas::matrix<T>& ) const;
+            T calculateQuantizationError( const ublas::matrix<T>&, const ublas::matrix<T>& ) const;
+            ublas::indirect_array<> getWinner( const ublas::matrix<T>&, const ublas::matrix<T>& ) const;
+        
+            #ifdef MACHINELEARNING_MPI
+            /** map with information to every process and prototype**/
+            std::vector< std::pair<std::size_t,std::size_t> > m_processprototypinfo;
+            
+            ublas::matrix<T> gatherAllPrototypes( const mpi::communicator& ) const;
+            std::vector<L> gatherAllLabels( const mpi::communicator& ) const;
+            void setProcessPrototypeInfo( const mpi::communicator& );
+            #endif
     };
    
     
@@ -100,6 +139,9 @@ namespace machinelearning { namespace clustering { namespace supervised {
         m_logging( false ),
         m_logprototypes( std::vector< ublas::matrix<T> >() ),
         m_quantizationerror( std::vector< T >() )
+        #ifdef MACHINELEARNING_MPI
+        , m_processprototypinfo()
+        #endif
     {
         if (p_prototypesize == 0)
             throw exception::runtime(_("prototype size must be greater than zero"), *this);
@@ -242,7 +284,7 @@ namespace machinelearning { namespace clustering { namespace supervised {
             // determine quantization error for logging
             if (m_logging) {
                 m_logprototypes.push_back( m_prototypes );
-                m_quantizationerror.push_back( calculateQuantizationError(p_data) );
+                m_quantizationerror.push_back( calculateQuantizationError(p_data, m_prototypes) );
             }
             
             #pragma omp parallel for shared(l_lambda)
@@ -278,15 +320,16 @@ namespace machinelearning { namespace clustering { namespace supervised {
     
     /** calculate the quantization error
      * @param p_data matrix with data points
+     * @param p_prototypes prototype matrix
      * @return quantization error
      **/
-    template<typename T, typename L> inline T rlvq<T, L>::calculateQuantizationError( const ublas::matrix<T>& p_data ) const
+    template<typename T, typename L> inline T rlvq<T, L>::calculateQuantizationError( const ublas::matrix<T>& p_data, const ublas::matrix<T>& p_prototypes ) const
     {
-        ublas::matrix<T> l_distances( m_prototypes.size1(), p_data.size1() );
+        ublas::matrix<T> l_distances( p_prototypes.size1(), p_data.size1() );
         
         #pragma omp parallel for shared(l_distances)
-        for(std::size_t i=0; i < m_prototypes.size1(); ++i)
-            ublas::row(l_distances, i) = m_distance.getDistance( p_data, ublas::row(m_prototypes, i) );
+        for(std::size_t i=0; i < p_prototypes.size1(); ++i)
+            ublas::row(l_distances, i) = m_distance.getDistance( p_data, ublas::row(p_prototypes, i) );
         
         return 0.5 * ublas::sum(  m_distance.getAbs(tools::matrix::min(l_distances, tools::matrix::column))  );  
     }
@@ -302,12 +345,23 @@ namespace machinelearning { namespace clustering { namespace supervised {
         if (p_data.size2() != m_prototypes.size2())
             throw exception::runtime( _("data and prototype dimension are not equal"), *this );
         
+        return getWinner( p_data, m_prototypes );
+    }
+    
+    
+    /** determines for each datapoint the index of the nearest prototype
+     * @param p_data datamatrix
+     * @param p_prototypes prototype matrix
+     * @return index position for every datapoint and its prototype / label
+    **/
+    template<typename T, typename L> inline ublas::indirect_array<> rlvq<T, L>::getWinner( const ublas::matrix<T>& p_data, const ublas::matrix<T>& p_prototypes ) const
+    {
         ublas::indirect_array<> l_idx(p_data.size1());
         #pragma omp parallel for shared(l_idx)
         for(std::size_t i=0; i < p_data.size1(); ++i) {
             
             // calculate distance from datapoint to all prototyps and rank position
-            ublas::vector<T> l_distance       = m_distance.getDistance( m_prototypes, ublas::row(p_data, i)  );
+            ublas::vector<T> l_distance       = m_distance.getDistance( p_prototypes, ublas::row(p_data, i)  );
             ublas::indirect_array<> l_rank    = tools::vector::rankIndex( l_distance );
             
             // add index
@@ -317,5 +371,328 @@ namespace machinelearning { namespace clustering { namespace supervised {
     }
 
 
+    
+    //======= MPI ==================================================================================================================================
+    #ifdef MACHINELEARNING_MPI
+    
+    /** gathering prototypes of every process and return the full prototypes matrix (row oriantated)
+     * @param p_mpi MPI object for communication
+     * @return full prototypes matrix
+     **/
+    template<typename T, typename L> inline ublas::matrix<T> rlvq<T, L>::gatherAllPrototypes( const mpi::communicator& p_mpi ) const
+    {
+        // gathering in this way, that every process get all prototypes
+        std::vector< ublas::matrix<T> > l_prototypedata;
+        mpi::all_gather(p_mpi, m_prototypes, l_prototypedata);
+        
+        // create full prototype matrix with processprotos
+        ublas::matrix<T> l_prototypes = l_prototypedata[0];
+        for(std::size_t i=1; i < l_prototypedata.size(); ++i) {
+            l_prototypes.resize( l_prototypes.size1()+l_prototypedata[i].size1(), l_prototypes.size2());
+            
+            ublas::matrix_range< ublas::matrix<T> > l_range(l_prototypes, 
+                                                            ublas::range( l_prototypes.size1()-l_prototypedata[i].size1(), l_prototypes.size1() ), 
+                                                            ublas::range( 0, l_prototypes.size2() )
+                                                            );
+            l_range.assign(l_prototypedata[i]);
+        }
+        
+        return l_prototypes;
+    }
+    
+    
+    /** gathering the prototype labels of every process in the same order like the prototypes
+     * @param p_mpi MPI object for communication
+     * @return full label vector
+     **/
+    template<typename T, typename L> inline std::vector<L> rlvq<T, L>::gatherAllLabels( const mpi::communicator& p_mpi ) const
+    {
+        std::vector< std::vector<L> > l_labeldata;
+        mpi::all_gather(p_mpi, m_neuronlabels, l_labeldata);
+        
+        std::vector<L> l_labels;
+        for(std::size_t i=0; i < l_labeldata.size(); ++i)
+            l_labels.insert( l_labels.end(), l_labeldata[i].begin(), l_labeldata[i].end() );
+        
+        return l_labels;
+    }
+    
+    
+    /** sets the std::vector with the begin position and size of the prototypes matrix. Is required for the extraction of prototypes
+     * of the full matrix for each process
+     * @param p_mpi MPI object for communication
+     **/
+    template<typename T, typename L> inline void rlvq<T, L>::setProcessPrototypeInfo( const mpi::communicator& p_mpi )
+    {
+        m_processprototypinfo.clear();
+        // gathering the number of prototypes
+        std::vector< std::size_t > l_processdata;
+        mpi::all_gather(p_mpi, m_prototypes.size1(), l_processdata);
+        
+        // create map
+        std::size_t l_sum = 0;
+        for(std::size_t i=0; i < l_processdata.size(); ++i) {
+            m_processprototypinfo.push_back( std::pair<std::size_t,std::size_t>(l_sum, l_processdata[i]) );
+            l_sum += l_processdata[i];
+        }
+    }
+    
+    
+    /** trains the prototypes from the data on the cluster
+     * @param p_mpi MPI object for communication
+     * @param p_data Matrix with data (rows are the vectors)
+     * @param p_labels vector for labels
+     * @param p_iterations iterations
+     **/
+    template<typename T, typename L> inline void rlvq<T, L>::train( const mpi::communicator& p_mpi, const ublas::matrix<T>& p_data, const std::vector<L>& p_labels, const std::size_t& p_iterations )
+    {
+        train(p_mpi, p_data, p_labels, p_iterations, 0.01/mpi::all_reduce(p_mpi, m_prototypes.size1(), std::plus<std::size_t>()));
+    }
+    
+    
+    /** trains the prototypes from the data on the cluster
+     * @param p_mpi MPI object for communication
+     * @param p_data Matrix with data (rows are the vectors)
+     * @param p_labels vector for labels
+     * @param p_iterations iterations
+     * @param p_lambda multiplicator for adaption for prototypes
+     **/
+    template<typename T, typename L> inline void rlvq<T, L>::train( const mpi::communicator& p_mpi, const ublas::matrix<T>& p_data, const std::vector<L>& p_labels, const std::size_t& p_iterations, const T& p_lambda )
+    {
+        train(p_mpi, p_data, p_labels, p_iterations, p_lambda, 0.1*p_lambda);
+    }
+    
+    
+    /** trains the prototypes from the data on the cluster. Each process determines the winner of its data points
+     * and sums the signed deltas, the absolute deltas and the number of points for each prototype, so only
+     * a prototype x (2*dimension+1) matrix is reduced on each iteration
+     * @param p_mpi MPI object for communication
+     * @param p_data Matrix with data (rows are the vectors)
+     * @param p_labels vector for labels
+     * @param p_iterations iterations
+     * @param p_lambda multiplicator for adaption for prototypes
+     * @param p_eta multiplicator for adaption for the dimension weights
+    **/
+    template<typename T, typename L> inline void rlvq<T, L>::train( const mpi::communicator& p_mpi, const ublas::matrix<T>& p_data, const std::vector<L>& p_labels, const std::size_t& p_iterations, const T& p_lambda, const T& p_eta )
+    {
+        if (p_iterations == 0)
+            throw exception::runtime(_("iterations must be greater than zero"), *this);
+        if (p_labels.size() != p_data.size1())
+            throw exception::runtime(_("matrix rows and label size are not equal"), *this);
+        if (p_data.size2() != m_prototypes.size2())
+            throw exception::runtime(_("data and prototype dimension are not equal"), *this);
+        if (p_lambda <= 0)
+            throw exception::runtime(_("lambda must be greater than zero"), *this);
+        if (p_eta <= 0)
+            throw exception::runtime(_("eta must be greater than zero"), *this);
+        
+        // we use the max. of all values of each process
+        const std::size_t l_iterationsMPI = mpi::all_reduce(p_mpi, p_iterations, mpi::maximum<std::size_t>());
+        const T l_lambdaMPI               = mpi::all_reduce(p_mpi, p_lambda, mpi::maximum<T>());
+        const T l_etaMPI                  = mpi::all_reduce(p_mpi, p_eta, mpi::maximum<T>());
+        m_logging                         = mpi::all_reduce(p_mpi, m_logging, std::multiplies<bool>());
+        setProcessPrototypeInfo(p_mpi);
+        
+        ublas::matrix<T> l_prototypes     = gatherAllPrototypes( p_mpi );
+        const std::vector<L> l_labels     = gatherAllLabels( p_mpi );
+        if (mpi::all_reduce(p_mpi, p_data.size1(), std::plus<std::size_t>()) < l_prototypes.size1())
+            throw exception::runtime(_("number of datapoints are less than prototypes"), *this);
+        
+        // for every prototype create a own lambda, initialisate with 1 and normalize prototypes
+        ublas::matrix<T> l_lambda(l_prototypes.size1(), p_data.size2(), 1);
+        m_distance.normalize( l_lambda );
+        
+        // creates logging
+        if (m_logging) {
+            m_logprototypes     = std::vector< ublas::matrix<T> >();
+            m_quantizationerror = std::vector< T >();
+            m_logprototypes.reserve(l_iterationsMPI);
+            m_quantizationerror.reserve(l_iterationsMPI);
+        }
+        
+        
+        // the sum matrix stores the signed deltas, the signed absolute deltas and the number of points in the last column
+        const std::size_t l_dim = l_prototypes.size2();
+        ublas::matrix<T> l_sum( l_prototypes.size1(), 2*l_dim+1 );
+        ublas::matrix<T> l_reduce( l_prototypes.size1(), 2*l_dim+1 );
+        ublas::indirect_array<> l_winner( p_data.size1() );
+        
+        // the batch update is dominated by the repulsion, if a prototype wins the data of many labels, so the
+        // prototypes are initialized with the mean of the data points, that are nearest to a prototype with the same label
+        #pragma omp parallel for shared(l_winner)
+        for (std::size_t j=0; j < p_data.size1(); ++j) {
+            ublas::vector<T> l_distance = m_distance.getDistance( l_prototypes, ublas::row(p_data, j) );
+            for(std::size_t n=0; n < l_distance.size(); ++n)
+                if (l_labels[n] != p_labels[j])
+                    l_distance(n) = std::numeric_limits<T>::max();
+            
+            const ublas::indirect_array<> l_rank = tools::vector::rankIndex( l_distance );
+            l_winner[j] = (l_labels[l_rank(0)] == p_labels[j]) ? l_rank(0) : l_prototypes.size1();
+        }
+        
+        l_sum.clear();
+        for (std::size_t j=0; j < p_data.size1(); ++j) {
+            if (l_winner(j) == l_prototypes.size1())
+                continue;
+            
+            for(std::size_t n=0; n < l_dim; ++n)
+                l_sum(l_winner(j), n) += p_data(j, n);
+            l_sum(l_winner(j), 2*l_dim) += static_cast<T>(1);
+        }
+        
+        mpi::all_reduce( p_mpi, &(l_sum.data()[0]), static_cast<int>(l_sum.data().size()), &(l_reduce.data()[0]), std::plus<T>() );
+        for(std::size_t n=0; n < l_prototypes.size1(); ++n)
+            if (!tools::function::isNumericalZero(l_reduce(n, 2*l_dim)))
+                for(std::size_t k=0; k < l_dim; ++k)
+                    l_prototypes(n, k) = l_reduce(n, k) / l_reduce(n, 2*l_dim);
+        
+        
+        for(std::size_t i=0; i < l_iterationsMPI; ++i) {
+            
+            // determine quantization error for logging
+            if (m_logging) {
+                const std::pair<std::size_t,std::size_t>& l_info = m_processprototypinfo[static_cast<std::size_t>(p_mpi.rank())];
+                m_logprototypes.push_back( ublas::subrange(l_prototypes, l_info.first, l_info.first+l_info.second, 0, l_prototypes.size2()) );
+                m_quantizationerror.push_back( calculateQuantizationError(p_data, l_prototypes) );
+            }
+            
+            // calculate weighted distance and rank vector elements, the first element is the index of the winner prototype
+            #pragma omp parallel for shared(l_winner)
+            for (std::size_t j=0; j < p_data.size1(); ++j) {
+                ublas::vector<T> l_distance          = m_distance.getWeightedDistance( l_prototypes, ublas::row(p_data, j), l_lambda );
+                const ublas::indirect_array<> l_rank = tools::vector::rankIndex( l_distance );
+                l_winner[j] = l_rank(0);
+            }
+            
+            // sum the deltas of the local data, the sign is given by the label checking
+            l_sum.clear();
+            for (std::size_t j=0; j < p_data.size1(); ++j) {
+                const std::size_t l_idx          = l_winner(j);
+                const T l_sign                   = (l_labels[l_idx] == p_labels[j]) ? static_cast<T>(1) : static_cast<T>(-1);
+                const ublas::vector<T> l_delta   = ublas::row(p_data, j) - ublas::row(l_prototypes, l_idx);
+                const ublas::vector<T> l_absdelta = m_distance.getAbs(l_delta);
+                
+                for(std::size_t n=0; n < l_dim; ++n) {
+                    l_sum(l_idx, n)       += l_sign * l_delta(n);
+                    l_sum(l_idx, l_dim+n) += l_sign * l_absdelta(n);
+                }
+                l_sum(l_idx, 2*l_dim) += static_cast<T>(1);
+            }
+            
+            // reduce the sums
+            mpi::all_reduce( p_mpi, &(l_sum.data()[0]), static_cast<int>(l_sum.data().size()), &(l_reduce.data()[0]), std::plus<T>() );
+            
+            // adapt prototypes and lambda, the mean delta is weighted with the step size of n online steps
+            #pragma omp parallel for shared(l_prototypes, l_lambda)
+            for(std::size_t n=0; n < l_prototypes.size1(); ++n) {
+                const T l_count = l_reduce(n, 2*l_dim);
+                if (tools::function::isNumericalZero(l_count))
+                    continue;
+                
+                const T l_prototypestep = (1 - std::pow(1-l_lambdaMPI, l_count)) / l_count;
+                const T l_lambdastep    = (1 - std::pow(1-l_etaMPI, l_count)) / l_count * l_lambdaMPI;
+                
+                const ublas::vector<T> l_delta    = ublas::subrange( static_cast< ublas::vector<T> >(ublas::row(l_reduce, n)), 0, l_dim );
+                const ublas::vector<T> l_absdelta = ublas::subrange( static_cast< ublas::vector<T> >(ublas::row(l_reduce, n)), l_dim, 2*l_dim );
+                
+                ublas::row(l_prototypes, n) += l_prototypestep * l_delta;
+                ublas::row(l_lambda, n)     -= l_lambdastep * ublas::element_prod(ublas::row(l_lambda, n), l_absdelta);
+                ublas::row(l_lambda, n)     /= m_distance.getLength( static_cast< ublas::vector<T> >(ublas::row(l_lambda, n)) );
+            }
+            
+            // set local prototypes
+            const std::pair<std::size_t,std::size_t>& l_info = m_processprototypinfo[static_cast<std::size_t>(p_mpi.rank())];
+            m_prototypes = ublas::subrange(l_prototypes, l_info.first, l_info.first+l_info.second, 0, l_prototypes.size2());
+        }
+    }
+    
+    
+    /** return all prototypes of the cluster
+     * @param p_mpi MPI object for communication
+     * @return matrix (rows = prototypes)
+     **/
+    template<typename T, typename L> inline ublas::matrix<T> rlvq<T, L>::getPrototypes( const mpi::communicator& p_mpi ) const
+    {
+        return gatherAllPrototypes( p_mpi );
+    }
+    
+    
+    /** returns the labels of all prototypes of the cluster
+     * @param p_mpi MPI object for communication
+     * @return vector with label information
+    **/
+    template<typename T, typename L> inline std::vector<L> rlvq<T, L>::getPrototypesLabel( const mpi::communicator& p_mpi ) const
+    {
+        return gatherAllLabels( p_mpi );
+    }
+    
+    
+    /** returns all logged prototypes in all processes
+     * @param p_mpi MPI object for communication
+     * @return std::vector with all logged prototypes
+     **/
+    template<typename T, typename L> inline std::vector< ublas::matrix<T> > rlvq<T, L>::getLoggedPrototypes( const mpi::communicator& p_mpi ) const
+    {
+        // we must gather every logged prototype and create the full prototype matrix
+        std::vector< std::vector< ublas::matrix<T> > > l_gatherProto;
+        mpi::all_gather(p_mpi, m_logprototypes, l_gatherProto);
+        
+        // now we create the full prototype matrix for every log
+        std::vector< ublas::matrix<T> > l_logProto = l_gatherProto[0];
+        for(std::size_t i=1; i < l_gatherProto.size(); ++i)
+            for(std::size_t n=0; n < l_gatherProto[i].size(); ++n) {
+                l_logProto[n].resize( l_logProto[n].size1()+l_gatherProto[i][n].size1(), l_logProto[n].size2());
+                
+                ublas::matrix_range< ublas::matrix<T> > l_range(l_logProto[n], 
+                                                                ublas::range( l_logProto[n].size1()-l_gatherProto[i][n].size1(), l_logProto[n].size1() ), 
+                                                                ublas::range( 0, l_logProto[n].size2() )
+                                                                );
+                l_range.assign(l_gatherProto[i][n]);
+            }
+        
+        return l_logProto;
+    }
+    
+    
+    /** returns the logged quantisation error
+     * @param p_mpi MPI object for communication
+     * @return std::vector with quantization error
+     **/
+    template<typename T, typename L> inline std::vector<T> rlvq<T, L>::getLoggedQuantizationError( const mpi::communicator& p_mpi ) const
+    {
+        // each process stores the error of its data, so the errors are summed
+        std::vector<T> l_error( m_quantizationerror.size(), 0 );
+        if (!l_error.empty())
+            mpi::all_reduce( p_mpi, &m_quantizationerror[0], static_cast<int>(m_quantizationerror.size()), &l_error[0], std::plus<T>() );
+        
+        return l_error;
+    }
+    
+    
+    /** labels unkown data (row orientated) with the prototypes of the cluster
+     * @param p_mpi MPI object for communication
+     * @param p_data unkwon datamatrix
+     * @return index position for every datapoint and its prototype / label (index of the full prototype matrix)
+    **/
+    template<typename T, typename L> inline ublas::indirect_array<> rlvq<T, L>::use( const mpi::communicator& p_mpi, const ublas::matrix<T>& p_data ) const
+    {
+        if (p_data.size2() != m_prototypes.size2())
+            throw exception::runtime( _("data and prototype dimension are not equal"), *this );
+        
+        return getWinner( p_data, gatherAllPrototypes(p_mpi) );
+    }
+    
+    
+    /** blank method for receiving all prototypes. The method can be used in combination with the use-method and the matrix parameter, so
+     * only one process can calculate the distances between prototypes and its data, all other process must call only this methode
+     * @param p_mpi MPI object for communication 
+     **/
+    template<typename T, typename L> inline void rlvq<T, L>::use( const mpi::communicator& p_mpi ) const
+    {
+        gatherAllPrototypes( p_mpi );
+    }
+    
+    #endif
+
 }}}
 #endif
@@ -25,18 +25,17 @@
 #define __MACHINELEARNING_DIMENSIONREDUCE_NONSUPERVISED_LLE_HPP
 
 
+#include <vector>
 #include <boost/numeric/ublas/vector.hpp>
 #include <boost/numeric/ublas/matrix.hpp>
 #include <boost/numeric/ublas/matrix_sparse.hpp>
+#include <boost/numeric/ublas/matrix_proxy.hpp>
 
 #include "reduce.hpp"
 #include "../../neighborhood/neighborhood.h"
 #include "../../errorhandling/exception.hpp"
 #include "../../tools/tools.h"
 
-#include <iostream>
-#include <boost/numeric/ublas/io.hpp>
-
 
 namespace machinelearning { namespace dimensionreduce { namespace nonsupervised {
     
@@ -87,9 +86,9 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
     }
     
     
-    /** caluate and project the input data
-     * @todo project matrix change to a sparse matrix if arpack can used with boost
-     * @bug it is uncomplete
+    /** caluate and project the input data. The local weights are solved in parallel, the
+     * matrix (I-W)'(I-W) is created row-wise in parallel and only the smallest eigenvectors
+     * are calculated
      * @param p_data input datamatrix
      * @return matrix with mapped points
      **/
@@ -97,24 +96,28 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
     {
         if (p_data.size2() <= m_dim)
             throw exception::runtime(_("data points are less than target dimension"), *this);
+        if (p_data.size1() <= m_dim+1)
+            throw exception::runtime(_("number of data points must be greater than target dimension"), *this);
         
         // if number of neighborhood greate than data dimension (column size)
         // regularize weight-matrix
+        const std::size_t l_neighborcount = m_neighborhood.getNeighborCount();
         const T l_tolerance = 1.0/10000.0;
-        const ublas::matrix<T> l_regular = tools::matrix::diag<T>( ublas::vector<T>(m_neighborhood.getNeighborCount(), l_tolerance) );
-        const bool l_regularize = m_neighborhood.getNeighborCount() > p_data.size2();
+        const ublas::matrix<T> l_regular = tools::matrix::diag<T>( ublas::vector<T>(l_neighborcount, l_tolerance) );
+        const bool l_regularize = l_neighborcount > p_data.size2();
         
         // calculate neighborhood index and create some structires
-        const ublas::scalar_vector<T> l_ones(m_neighborhood.getNeighborCount(), 1);
+        const ublas::scalar_vector<T> l_ones(l_neighborcount, 1);
         const ublas::matrix<std::size_t> l_neighborhood = m_neighborhood.get( p_data );
-        ublas::matrix<T> l_weight(p_data.size1(), m_neighborhood.getNeighborCount());
+        ublas::matrix<T> l_weight(p_data.size1(), l_neighborcount);
         
-        // calculate weight matrix
+        // calculate weight matrix (each local system is independent)
+        #pragma omp parallel for shared(l_weight)
         for(std::size_t i=0; i < p_data.size1(); ++i) {
         
             // subtract every point from their neighbors (centering neighbors to the point)
-            ublas::matrix<T> l_local( m_neighborhood.getNeighborCount(), p_data.size2() );
-            for(std::size_t j=0; j < m_neighborhood.getNeighborCount(); ++j)
+            ublas::matrix<T> l_local( l_neighborcount, p_data.size2() );
+            for(std::size_t j=0; j < l_neighborcount; ++j)
                 ublas::row(l_local, j) = ublas::row(p_data, l_neighborhood(i, j)) - ublas::row(p_data, i);
                     
             // symmetrize matrix (add tolerance)
@@ -130,33 +133,45 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
         }
  
         
-        // create weight matrix (I-W)' * (I-W) for the data
-        ublas::mapped_matrix<T> l_project = tools::matrix::eye<T>(p_data.size1());
-        for(std::size_t i=0; i < l_weight.size1(); ++i) {
-            
-            const ublas::vector<std::size_t> l_ndidx = ublas::row(l_neighborhood, i);
-            const ublas::vector<T> l_pointweights    = ublas::row(l_weight, i);
-            const ublas::matrix<T> l_mat             = ublas::outer_prod(l_pointweights, l_pointweights);
+        // create the reverse neighborhood (data points, which have the point as neighbor)
+        std::vector< std::vector< std::pair<std::size_t, std::size_t> > > l_reverse( p_data.size1() );
+        for(std::size_t i=0; i < l_neighborhood.size1(); ++i)
+            for(std::size_t j=0; j < l_neighborcount; ++j)
+                l_reverse[l_neighborhood(i, j)].push_back( std::pair<std::size_t, std::size_t>(i, j) );
+        
+        // create the rows of the matrix (I-W)' * (I-W) = I - W - W' + W'W independently, every row
+        // is build by the neighbors of the point and the points, which have the point as neighbor
+        ublas::matrix<T> l_project( p_data.size1(), p_data.size1(), static_cast<T>(0) );
+        
+        #pragma omp parallel for shared(l_project)
+        for(std::size_t i=0; i < p_data.size1(); ++i) {
+            l_project(i, i) += static_cast<T>(1);
+            for(std::size_t j=0; j < l_neighborcount; ++j)
+                l_project(i, l_neighborhood(i, j)) -= l_weight(i, j);
             
-            for(std::size_t j=0; j < l_pointweights.size(); ++j) {
-                l_project(i, l_ndidx(j)) -= l_pointweights(j);
-                l_project(l_ndidx(j), i) -= l_pointweights(j);
+            for(std::size_t j=0; j < l_reverse[i].size(); ++j) {
+                const std::size_t l_point = l_reverse[i][j].first;
+                const T l_pointweight     = l_weight(l_point, l_reverse[i][j].second);
                 
-                for(std::size_t n=0; n < l_pointweights.size(); ++n)
-                    l_project(l_ndidx(j),l_ndidx(n))    += l_mat(j, n);
+                l_project(i, l_point) -= l_pointweight;
+                for(std::size_t n=0; n < l_neighborcount; ++n)
+                    l_project(i, l_neighborhood(l_point, n)) += l_pointweight * l_weight(l_point, n);
             }
         }
         
-        // calculate the eigenvalues & -vectors
+        
+        // calculate the smallest eigenvalues & -vectors, the first eigenvector is the constant
+        // vector with eigenvalue zero, so the embedding are the following eigenvectors. The
+        // eigenvalues are close to zero and their gaps are many magnitudes smaller than the largest
+        // eigenvalue, so a Krylov iteration (Lanczos) on the shifted matrix does not converge without
+        // a shift-invert factorization. The matrix is decomposed dense and only the eigenpairs of the
+        // index range are calculated
         ublas::vector<T> l_eigenvalues;
         ublas::matrix<T> l_eigenvectors;
-        tools::lapack::eigen<T>(l_project, l_eigenvalues, l_eigenvectors);
-         
-        std::cout << l_eigenvalues << std::endl;
+        tools::lapack::symmetricEigen<T>( l_project, 1, m_dim+1, l_eigenvalues, l_eigenvectors );
         
         return l_eigenvectors;
-        
     }
-
+    
 }}}
 #endif
@@ -26,14 +26,13 @@
 
 #include <omp.h>
 
+#include <cmath>
 #include <limits>
+#include <vector>
+#include <algorithm>
 #include <boost/static_assert.hpp>
 #include <boost/numeric/ublas/matrix.hpp>
 
-#ifdef MACHINELEARNING_MPI
-#include <boost/mpi.hpp>
-#endif
-
 #include "reduce.hpp"
 #include "../../errorhandling/exception.hpp"
 #include "../../tools/tools.h"
@@ -43,15 +42,19 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
     
     #ifndef SWIG
     namespace ublas  = boost::numeric::ublas;
-    #ifdef MACHINELEARNING_MPI
-    namespace mpi   = boost::mpi;
+    #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
+    namespace mpi   = machinelearning::tools::communication;
     #endif
     #endif
     
     
-    /** create the multidimensional scaling (MDS) with different algorithms **/
+    /** create the multidimensional scaling (MDS) with different algorithms. The landmark and pivot
+     * projection use only the dissimilarities between L landmark points (rows) and all N points (columns),
+     * so for large data the full dissimilarity matrix is not needed (e.g. the matrix can be created
+     * with distances::ncd::unsquare( landmarks, data ) )
+     **/
     template<typename T> class mds : public reduce<T>
-        #ifdef MACHINELEARNING_MPI
+        #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
         , public reducempi<T>
         #endif
     {
@@ -65,7 +68,10 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
             enum project {
                 metric              = 0,
                 sammon              = 1,
-                hit                 = 2
+                hit                 = 2,
+                landmark            = 3,
+                pivot               = 4,
+                smacof              = 5
             };
             
             enum centeroption {
@@ -82,15 +88,18 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
             void setStep( const std::size_t& );
             void setRate( const T& );
             void setCentering( const centeroption& );
+            #ifndef SWIG
+            void setLandmarks( const std::vector<std::size_t>& );
+            #endif
         
-            #ifdef MACHINELEARNING_MPI
+            #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
             ublas::matrix<T> map( const mpi::communicator&, const ublas::matrix<T>& );
             #endif
         
         
         private :
         
-            /** number of iterations for sammon and hit **/
+            /** number of iterations for sammon, hit and smacof **/
             std::size_t m_iteration;
             /** stepsize for sammon **/
             std::size_t m_step;
@@ -102,20 +111,28 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
             const project m_type;
             /** centering **/
             centeroption m_centering;
+            /** column indices of the landmarks within the data **/
+            std::vector<std::size_t> m_landmarks;
             
             
             ublas::matrix<T> project_metric( const ublas::matrix<T>& ) const;
             ublas::matrix<T> project_sammon( const ublas::matrix<T>& ) const;
             ublas::matrix<T> project_hit( const ublas::matrix<T>& ) const;
+            ublas::matrix<T> project_landmark( const ublas::matrix<T>& ) const;
+            ublas::matrix<T> project_pivot( const ublas::matrix<T>& ) const;
+        
+            ublas::matrix<T> project_smacof( const ublas::matrix<T>& ) const;
         
-            ublas::matrix<T> sammon_distance( const ublas::matrix<T>& ) const;
-            T sammon_calculateQuantizationError( const ublas::matrix<T>&, const ublas::matrix<T>& ) const;
-            void hit_setZeros(const std::vector< std::pair<std::size_t, std::size_t> >&, ublas::matrix<T>& ) const;
+            T sammon_error( const ublas::matrix<T>&, const ublas::matrix<T>& ) const;
+            void sammon_gradient( const ublas::matrix<T>&, const ublas::matrix<T>&, ublas::matrix<T>&, ublas::matrix<T>& ) const;
+            T smacof_guttman( const ublas::matrix<T>&, const ublas::matrix<T>&, ublas::matrix<T>& ) const;
+            ublas::matrix<T> landmark_doublecentering( const ublas::matrix<T>& ) const;
+            static std::size_t tilesize( const std::size_t& );
         
-            #ifdef MACHINELEARNING_MPI
+            #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
             ublas::matrix<T> project_hit( const mpi::communicator&, const ublas::matrix<T>& ) const;
-            ublas::vector<T> hit_connectVector( const mpi::communicator&, const ublas::vector<T>& ) const;
-            std::size_t hit_matrixPosition( const mpi::communicator&, const std::size_t& ) const;
+            void hit_correlation( const ublas::matrix<T>&, const std::size_t&, const std::size_t&, const T*, const T*, const std::size_t&, const T&, T* ) const;
+            void hit_update( const ublas::matrix<T>&, const T*, const T*, const std::size_t&, const T&, T* ) const;
             #endif
         
     };
@@ -131,7 +148,8 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
         m_rate( 1 ),
         m_dim( p_dim ),
         m_type( p_type ),
-        m_centering( none )
+        m_centering( none ),
+        m_landmarks()
     {
         if (p_dim == 0)
             throw exception::runtime(_("dimension must be greater than zero"), *this);
@@ -182,11 +200,33 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
     }
     
     
+    /** sets the column indices of the landmarks for the landmark projection. If no indices are set,
+     * the first L columns of the LxN dissimilarity matrix are the landmarks
+     * @param p_landmarks column indices
+     **/
+    template<typename T> inline void mds<T>::setLandmarks( const std::vector<std::size_t>& p_landmarks )
+    {
+        m_landmarks = p_landmarks;
+    }
+    
+    
     /** caluate and project the input data
-     * @param p_data input datamatrix (dissimilarity matrix)
+     * @param p_data input datamatrix (dissimilarity matrix, for the landmark and pivot projection the LxN
+     * dissimilarities between the landmarks and all points)
      **/
     template<typename T> inline ublas::matrix<T> mds<T>::map( const ublas::matrix<T>& p_data )
     {
+        // landmark and pivot projection use their own centering of the squared dissimilarities
+        if ( (m_type == landmark) || (m_type == pivot) )
+        {
+            if (p_data.size1() > p_data.size2())
+                throw exception::runtime(_("number of landmarks must not be greater than the number of data points"), *this);
+            if (p_data.size1() <= m_dim)
+                throw exception::runtime(_("number of landmarks are less than target dimension"), *this);
+            
+            return (m_type == landmark) ? project_landmark(p_data) : project_pivot(p_data);
+        }
+        
         if (p_data.size1() != p_data.size2())
             throw exception::runtime( _("matrix must be square"), *this );
         if (p_data.size2() <= m_dim)
@@ -220,6 +260,9 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
                 
             case hit :
                 return project_hit(l_data);
+                
+            case smacof :
+                return project_smacof(l_data);
                        
             default :
                 throw exception::runtime(_("project option is unkown"), *this);
@@ -235,29 +278,141 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
      **/
     template<typename T> inline ublas::matrix<T> mds<T>::project_metric( const ublas::matrix<T>& p_data ) const
     {
-        // calculate the eigenvalues & -vectors
+        if (p_data.size1() < m_dim)
+            throw exception::runtime(_("number of data points are less than target dimension"), *this);
+        
+        // calculate only the largest eigenvalues & -vectors of the symmetric matrix (the index range of the
+        // ascending spectrum returns the largest eigenvector in the last column)
         ublas::vector<T> l_eigenvalues;
         ublas::matrix<T> l_eigenvectors;
-        tools::lapack::eigen<T>(p_data, l_eigenvalues, l_eigenvectors);
-        
-        // rank the eigenvalues
-        const ublas::indirect_array<> l_rank = tools::vector::rankIndex( l_eigenvalues );
+        tools::lapack::symmetricEigen<T>(p_data, p_data.size1()-m_dim, p_data.size1(), l_eigenvalues, l_eigenvectors);
         
-        // create projection (largest eigenvectors correspondends with the largest eigenvalues -> last values in rank)
-        ublas::matrix<T> l_project( l_eigenvectors.size2(), m_dim );
+        // scale the eigenvectors with the square root of the eigenvalues
         ublas::matrix<T> l_values(m_dim, m_dim, 0);
-        for(std::size_t i=0; i < m_dim; ++i) {
-            ublas::column(l_project, m_dim-i-1) = ublas::column(l_eigenvectors, l_rank(l_rank.size()-i-1));
-            l_values(m_dim-i-1, m_dim-i-1) = std::pow(l_eigenvalues(l_rank(l_rank.size()-i-1)), static_cast<T>(0.5));
+        for(std::size_t i=0; i < m_dim; ++i)
+            l_values(i, i) = std::pow(l_eigenvalues(i), static_cast<T>(0.5));
+        
+        return ublas::prod(l_eigenvectors, l_values);
+    }
+    
+    
+    /** calculate the landmark MDS (de Silva & Tenenbaum, 2004). The classical MDS is calculated on the
+     * landmarks only and all points are triangulated by their dissimilarities to the landmarks
+     * @param p_data LxN dissimilarity matrix between the landmarks and all points
+     * @return mapped data
+     **/
+    template<typename T> inline ublas::matrix<T> mds<T>::project_landmark( const ublas::matrix<T>& p_data ) const
+    {
+        const std::size_t l_count = p_data.size1();
+        if ( (!m_landmarks.empty()) && (m_landmarks.size() != l_count) )
+            throw exception::runtime(_("number of landmark indices must be equal to the number of landmarks"), *this);
+        
+        // squared dissimilarities and the landmark matrix
+        ublas::matrix<T> l_squared(l_count, p_data.size2());
+        ublas::matrix<T> l_landmark(l_count, l_count);
+        
+        #pragma omp parallel for shared(l_squared)
+        for(std::size_t i=0; i < l_count; ++i)
+            for(std::size_t j=0; j < p_data.size2(); ++j)
+                l_squared(i,j) = p_data(i,j) * p_data(i,j);
+        
+        for(std::size_t j=0; j < l_count; ++j)
+        {
+            const std::size_t l_index = m_landmarks.empty() ? j : m_landmarks[j];
+            if (l_index >= p_data.size2())
+                throw exception::runtime(_("landmark index is out of the data"), *this);
+            ublas::column(l_landmark, j) = ublas::column(l_squared, l_index);
+        }
+        
+        // classical MDS on the double centered landmark matrix (the largest eigenvector in the last column)
+        ublas::vector<T> l_eigenvalues;
+        ublas::matrix<T> l_eigenvectors;
+        tools::lapack::symmetricEigen<T>( landmark_doublecentering(l_landmark), l_count-m_dim, l_count, l_eigenvalues, l_eigenvectors );
+        
+        // pseudo inverse of the landmark embedding
+        ublas::matrix<T> l_inverse(m_dim, l_count);
+        for(std::size_t i=0; i < m_dim; ++i)
+        {
+            if (l_eigenvalues(i) <= 0)
+                throw exception::runtime(_("landmark dissimilarities have less positive eigenvalues than target dimension"), *this);
+            ublas::row(l_inverse, i) = ublas::column(l_eigenvectors, i) / std::sqrt(l_eigenvalues(i));
+        }
+        
+        // triangulate all points with the mean of the squared landmark dissimilarities
+        const ublas::vector<T> l_mean = tools::matrix::sum<T>(l_landmark, tools::matrix::row) / static_cast<T>(l_count);
+        
+        #pragma omp parallel for shared(l_squared)
+        for(std::size_t j=0; j < l_squared.size2(); ++j)
+            ublas::column(l_squared, j) -= l_mean;
+        
+        return ublas::trans( static_cast<T>(-0.5) * ublas::prod(l_inverse, l_squared) );
+    }
+    
+    
+    /** calculate the pivot MDS (Brandes & Pich, 2007). The double centered squared dissimilarities between
+     * all points and the pivots (landmarks) are decomposed with their small LxL product
+     * @param p_data LxN dissimilarity matrix between the pivots and all points
+     * @return mapped data
+     **/
+    template<typename T> inline ublas::matrix<T> mds<T>::project_pivot( const ublas::matrix<T>& p_data ) const
+    {
+        // double centered squared dissimilarities (NxL)
+        ublas::matrix<T> l_center(p_data.size2(), p_data.size1());
+        
+        #pragma omp parallel for shared(l_center)
+        for(std::size_t i=0; i < p_data.size2(); ++i)
+            for(std::size_t j=0; j < p_data.size1(); ++j)
+                l_center(i,j) = p_data(j,i) * p_data(j,i);
+        
+        l_center = landmark_doublecentering(l_center);
+        
+        // eigenvectors of the LxL product (the largest eigenvector in the last column)
+        ublas::vector<T> l_eigenvalues;
+        ublas::matrix<T> l_eigenvectors;
+        tools::lapack::symmetricEigen<T>( ublas::prod(ublas::trans(l_center), l_center), p_data.size1()-m_dim, p_data.size1(), l_eigenvalues, l_eigenvectors );
+        
+        // the eigenvalues of the LxL product are the squared singular values of the centered matrix, the
+        // eigenvalues of the full inner product matrix are estimated with the sqrt(N/L) scaled singular values,
+        // so the projection is scaled like the classical MDS
+        const T l_scale = std::pow( static_cast<T>(p_data.size2()) / static_cast<T>(p_data.size1()), static_cast<T>(0.25) );
+        for(std::size_t i=0; i < m_dim; ++i)
+        {
+            if (l_eigenvalues(i) <= 0)
+                throw exception::runtime(_("pivot dissimilarities have less positive eigenvalues than target dimension"), *this);
+            ublas::column(l_eigenvectors, i) *= l_scale / std::pow(l_eigenvalues(i), static_cast<T>(0.25));
         }
         
-        return ublas::prod(l_project, l_values);
+        return ublas::prod(l_center, l_eigenvectors);
+    }
+    
+    
+    /** double centering of squared dissimilarities with the row and column mean, the matrix
+     * need not be square ( -1/2 * (d_ij - mean_i - mean_j + mean) )
+     * @param p_data squared dissimilarities
+     * @return centered matrix
+     **/
+    template<typename T> inline ublas::matrix<T> mds<T>::landmark_doublecentering( const ublas::matrix<T>& p_data ) const
+    {
+        const ublas::vector<T> l_rowmean = tools::matrix::sum<T>(p_data, tools::matrix::row) / static_cast<T>(p_data.size2());
+        const ublas::vector<T> l_colmean = tools::matrix::sum<T>(p_data, tools::matrix::column) / static_cast<T>(p_data.size1());
+        const T l_mean = ublas::sum(l_rowmean) / static_cast<T>(p_data.size1());
+        
+        ublas::matrix<T> l_center(p_data.size1(), p_data.size2());
+        
+        #pragma omp parallel for shared(l_center)
+        for(std::size_t i=0; i < p_data.size1(); ++i)
+            for(std::size_t j=0; j < p_data.size2(); ++j)
+                l_center(i,j) = static_cast<T>(-0.5) * (p_data(i,j) - l_rowmean(i) - l_colmean(j) + l_mean);
+        
+        return l_center;
     }
     
     
     /** calculate the sammon mapping on MDS (with pseudo-newton method for optimization)
      * @note uses code idea of http://ticc.uvt.nl/~lvdrmaaten (in the Matlab code there are duplicated variables). The Matlab code does
      * not return the same points like the function code. The break during the optimization is set by the numerical limits of the data types.
+     * The gradient, the diagonal of the hesse-matrix and the error are calculated in one tiled pass over the point pairs, so no NxN matrix
+     * is created. Pairs with zero dissimilarity are ignored.
      * @param p_data input datamatrix (dissimilarity matrix)
      * @return mapped data
      **/
@@ -268,47 +423,33 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
         if (m_step == 0)
             throw exception::runtime(_("steps must be greater than zero"), *this);
         
-        
-        // create the distance for each row/colum (create distance matrix) of the matrix and sets the diagonal elements to one
-        const ublas::mapped_matrix<T> l_DataEye     = tools::matrix::eye<T>( p_data.size1() );   
-        const ublas::matrix<T> l_data               = p_data + l_DataEye;
-        const ublas::matrix<T> l_dataInv            = tools::matrix::invert(l_data);
-        
-        // target point matrix und one matrix
-        ublas::matrix<T> l_target                   = tools::matrix::random( l_data.size1(), m_dim, tools::random::uniform, static_cast<T>(-1), static_cast<T>(1) );
-        const ublas::mapped_matrix<T> l_TargetOnes  = ublas::scalar_matrix<T>( l_target.size1(), l_target.size2(), static_cast<T>(1) );
-        T l_error                                   = sammon_calculateQuantizationError( l_data - sammon_distance(l_target) + l_DataEye, l_dataInv );
+        // target point matrix and optimization structures (all with target size)
+        ublas::matrix<T> l_target                   = tools::matrix::random( p_data.size1(), m_dim, tools::random::uniform, static_cast<T>(-1), static_cast<T>(1) );
+        ublas::matrix<T> l_targetTmp(l_target.size1(), l_target.size2());
+        ublas::matrix<T> l_gradient(l_target.size1(), l_target.size2());
+        ublas::matrix<T> l_hesse(l_target.size1(), l_target.size2());
+        ublas::matrix<T> l_adapt(l_target.size1(), l_target.size2());
+        T l_error                                   = sammon_error( p_data, l_target );
         
         // optimize
         for(std::size_t i=0; i < m_iteration; ++i) {
-            const ublas::matrix<T> l_Distance        = sammon_distance(l_target) + l_DataEye;           
-            const ublas::matrix<T> l_DistanceInv     = tools::matrix::invert(l_Distance);
-            const ublas::matrix<T> l_DistanceInv3    = tools::matrix::pow(l_DistanceInv, static_cast<T>(3));
-            const ublas::matrix<T> l_target2         = tools::matrix::pow(l_target, static_cast<T>(2));
-            
-            const ublas::matrix<T> l_delta           = l_data - l_Distance;
-            const ublas::matrix<T> l_deltaInv        = l_DistanceInv - l_dataInv;
-            const ublas::matrix<T> l_deltaOne        = ublas::prod( l_deltaInv, l_TargetOnes );
             
             // calculating gradient & hesse-matrix values
-            const ublas::matrix<T> l_gradient        = ublas::prod( l_deltaInv, l_target ) - ublas::element_prod( l_target, l_deltaOne );
-            const ublas::matrix<T> l_hesse           = ublas::prod( l_DistanceInv3, l_target2 ) -  l_deltaOne - static_cast<T>(2) * ublas::element_prod(l_target, ublas::prod(l_DistanceInv3, l_target)) + ublas::element_prod(l_target2, ublas::prod(l_DistanceInv3, l_TargetOnes)); 
+            sammon_gradient( p_data, l_target, l_gradient, l_hesse );
             
             // create adaption
-            ublas::matrix<T> l_adapt(l_target.size1(), l_target.size2(), static_cast<T>(0));
             #pragma omp parallel for shared(l_adapt)
             for(std::size_t n=0; n < l_adapt.size1(); ++n)
                 for(std::size_t j=0; j < l_adapt.size2(); ++j)
-                    if (!tools::function::isNumericalZero(l_hesse(n,j)))
-                        l_adapt(n,j) = -l_gradient(n,j) / std::fabs( l_hesse(n,j) );
+                    l_adapt(n,j) = tools::function::isNumericalZero(l_hesse(n,j)) ? static_cast<T>(0) : -l_gradient(n,j) / std::fabs( l_hesse(n,j) );
             
             // get quantization error & try to optimize in half-steps
-            T l_errornew                         = 0;
-            const ublas::matrix<T> l_targetTmp   = l_target;
+            T l_errornew = 0;
+            ublas::noalias(l_targetTmp) = l_target;
             
             for(std::size_t n=1; n <= m_step; ++n) {
-                l_target             = l_targetTmp + l_adapt;
-                l_errornew           = sammon_calculateQuantizationError( l_data - (sammon_distance(l_target) + l_DataEye), l_dataInv );
+                ublas::noalias(l_target)    = l_targetTmp + l_adapt;
+                l_errornew                  = sammon_error( p_data, l_target );
                 
                 if (l_errornew < l_error)
                     break;
@@ -330,42 +471,216 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
     }
 
     
-    /** creates the error value of sammon optimizing
-     * @param p_delta delta values (differnce between original and target points)
-     * @param p_invert inverted data values
+    /** creates the error value of sammon optimizing ( sum (D_ij - d_ij)^2 / D_ij, D dissimilarity, d distance ) within a tiled pass over the point pairs
+     * @param p_data dissimilarity matrix
+     * @param p_target target points
      * @return error value
      **/
-    template<typename T> inline T mds<T>::sammon_calculateQuantizationError( const ublas::matrix<T>& p_delta, const ublas::matrix<T>& p_invert ) const
+    template<typename T> inline T mds<T>::sammon_error( const ublas::matrix<T>& p_data, const ublas::matrix<T>& p_target ) const
+    {
+        const std::size_t l_tile    = tilesize(p_data.size1());
+        const std::size_t l_size    = p_data.size1();
+        const std::size_t l_dim     = p_target.size2();
+        const T* const l_point      = &p_target.data()[0];
+        T l_error                   = 0;
+        
+        #pragma omp parallel for reduction(+ : l_error)
+        for(std::size_t l_row=0; l_row < l_size; l_row += l_tile)
+            for(std::size_t l_col=0; l_col < l_size; l_col += l_tile)
+                for(std::size_t i=l_row; i < std::min(l_row+l_tile, l_size); ++i)
+                {
+                    const T* const l_pointi = l_point + i*l_dim;
+                    for(std::size_t j=l_col; j < std::min(l_col+l_tile, l_size); ++j)
+                    {
+                        const T l_dissimilarity = p_data(i,j);
+                        if ( (i == j) || (tools::function::isNumericalZero(l_dissimilarity)) )
+                            continue;
+                        
+                        const T* const l_pointj = l_point + j*l_dim;
+                        T l_distance = 0;
+                        for(std::size_t k=0; k < l_dim; ++k)
+                            l_distance += (l_pointi[k] - l_pointj[k]) * (l_pointi[k] - l_pointj[k]);
+                        
+                        const T l_delta = l_dissimilarity - std::sqrt(l_distance);
+                        l_error += l_delta * l_delta / l_dissimilarity;
+                    }
+                }
+        
+        return l_error;
+    }
+    
+    
+    /** calculates the gradient and the diagonal of the hesse-matrix of the sammon error within a tiled pass over
+     * the point pairs. Each tile of rows is calculated by one thread, so the results are written without locks
+     * @param p_data dissimilarity matrix
+     * @param p_target target points
+     * @param p_gradient gradient matrix
+     * @param p_hesse diagonal hesse-matrix values
+     **/
+    template<typename T> inline void mds<T>::sammon_gradient( const ublas::matrix<T>& p_data, const ublas::matrix<T>& p_target, ublas::matrix<T>& p_gradient, ublas::matrix<T>& p_hesse ) const
     {
-        ublas::matrix<T> l_mat = ublas::element_prod( tools::matrix::pow(p_delta, static_cast<T>(2)), p_invert);
-        return ublas::sum( tools::matrix::sum( l_mat ) );
+        const std::size_t l_tile    = tilesize(p_data.size1());
+        const std::size_t l_size    = p_data.size1();
+        const std::size_t l_dim     = p_target.size2();
+        const T* const l_point      = &p_target.data()[0];
+        T* const l_gradient         = &p_gradient.data()[0];
+        T* const l_hesse            = &p_hesse.data()[0];
+        
+        #pragma omp parallel for
+        for(std::size_t l_row=0; l_row < l_size; l_row += l_tile)
+        {
+            const std::size_t l_rowend = std::min(l_row+l_tile, l_size);
+            std::vector<T> l_deltasum(l_rowend-l_row, 0);
+            std::fill( l_gradient+l_row*l_dim, l_gradient+l_rowend*l_dim, static_cast<T>(0) );
+            std::fill( l_hesse+l_row*l_dim, l_hesse+l_rowend*l_dim, static_cast<T>(0) );
+            
+            for(std::size_t l_col=0; l_col < l_size; l_col += l_tile)
+                for(std::size_t i=l_row; i < l_rowend; ++i)
+                {
+                    const T* const l_pointi = l_point + i*l_dim;
+                    T* const l_gradienti    = l_gradient + i*l_dim;
+                    T* const l_hessei       = l_hesse + i*l_dim;
+                    
+                    for(std::size_t j=l_col; j < std::min(l_col+l_tile, l_size); ++j)
+                    {
+                        const T l_dissimilarity = p_data(i,j);
+                        if ( (i == j) || (tools::function::isNumericalZero(l_dissimilarity)) )
+                            continue;
+                        
+                        const T* const l_pointj = l_point + j*l_dim;
+                        T l_distance = 0;
+                        for(std::size_t k=0; k < l_dim; ++k)
+                            l_distance += (l_pointi[k] - l_pointj[k]) * (l_pointi[k] - l_pointj[k]);
+                        l_distance = std::sqrt(l_distance);
+                        if (tools::function::isNumericalZero(l_distance))
+                            continue;
+                        
+                        // delta = 1/d - 1/D, gradient = sum delta (y_j - y_i), hesse = sum 1/d^3 (y_j - y_i)^2 - sum delta
+                        const T l_distanceinv   = static_cast<T>(1) / l_distance;
+                        const T l_delta         = l_distanceinv - static_cast<T>(1) / l_dissimilarity;
+                        const T l_distanceinv3  = l_distanceinv * l_distanceinv * l_distanceinv;
+                        
+                        l_deltasum[i-l_row] += l_delta;
+                        for(std::size_t k=0; k < l_dim; ++k)
+                        {
+                            const T l_diff   = l_pointj[k] - l_pointi[k];
+                            l_gradienti[k]  += l_delta * l_diff;
+                            l_hessei[k]     += l_distanceinv3 * l_diff * l_diff;
+                        }
+                    }
+                }
+            
+            for(std::size_t i=l_row; i < l_rowend; ++i)
+                for(std::size_t k=0; k < l_dim; ++k)
+                    l_hesse[i*l_dim+k] -= l_deltasum[i-l_row];
+        }
     }
     
     
-    /** calculate the distance between every row of the matrix and the other rows
-     * @param p_matrix input matrix
-     * @return distance matrix
+    /** calculates the metric MDS with stress majorization (SMACOF, de Leeuw). Each iteration is a Guttman transform,
+     * which never increases the raw stress ( sum_{i<j} (D_ij - d_ij)^2 ). The transform is calculated within a tiled
+     * pass over the point pairs, so no NxN matrix is created
+     * @param p_data input datamatrix (symmetric dissimilarity matrix)
+     * @return mapped data
      **/
-    template<typename T> inline ublas::matrix<T> mds<T>::sammon_distance( const ublas::matrix<T>& p_matrix ) const
+    template<typename T> inline ublas::matrix<T> mds<T>::project_smacof( const ublas::matrix<T>& p_data ) const
     {
-        ublas::matrix<T> l_sse( p_matrix.size1(), p_matrix.size1(), 0 );
-        if ( p_matrix.size1() == p_matrix.size2() ) {
-            l_sse = tools::matrix::pow(p_matrix, static_cast<T>(2));
-            const ublas::matrix<T> l_mat = ublas::outer_prod(tools::matrix::sum(l_sse), ublas::scalar_vector<T>(p_matrix.size1(),1));
-            l_sse = l_mat + ublas::trans(l_mat) - 2*ublas::prod(p_matrix, ublas::trans(p_matrix));
-            l_sse = tools::matrix::pow(l_sse, static_cast<T>(0.5));                       
-        } else 
-            #pragma omp parallel for shared(l_sse)
-            for(std::size_t i=0; i < l_sse.size1(); ++i)
-                for(std::size_t j=0; j < l_sse.size2(); ++j)
-                    l_sse(i,j) = std::pow(ublas::sum( tools::vector::pow( static_cast< ublas::vector<T> >(ublas::row(p_matrix, j)-ublas::row(p_matrix, i)), static_cast<T>(2)) ), static_cast<T>(0.5));
-        
-        return l_sse;
+        if (m_iteration == 0)
+            throw exception::runtime(_("iterations must be greater than zero"), *this);
+        
+        ublas::matrix<T> l_target = tools::matrix::random( p_data.size1(), m_dim, tools::random::uniform, static_cast<T>(-1), static_cast<T>(1) );
+        ublas::matrix<T> l_update(l_target.size1(), l_target.size2());
+        T l_stress = smacof_guttman( p_data, l_target, l_update );
+        
+        for(std::size_t i=0; i < m_iteration; ++i) {
+            l_target.swap(l_update);
+            
+            // the stress is calculated for the actual points, so the last update is dropped on convergence
+            const T l_stressnew = smacof_guttman( p_data, l_target, l_update );
+            if ( (tools::function::isNumericalZero(l_stressnew)) || (tools::function::isNumericalZero( (l_stress - l_stressnew) / l_stress )) )
+                break;
+            
+            l_stress = l_stressnew;
+        }
+        
+        return l_target;
+    }
+    
+    
+    /** calculates the Guttman transform of the points ( x_i = 1/N sum_{j!=i} D_ij/d_ij (x_i - x_j) ) and the raw stress
+     * of the points within a tiled pass over the point pairs
+     * @param p_data dissimilarity matrix
+     * @param p_target target points
+     * @param p_update transformed points
+     * @return raw stress of the target points
+     **/
+    template<typename T> inline T mds<T>::smacof_guttman( const ublas::matrix<T>& p_data, const ublas::matrix<T>& p_target, ublas::matrix<T>& p_update ) const
+    {
+        const std::size_t l_tile    = tilesize(p_data.size1());
+        const std::size_t l_size    = p_data.size1();
+        const std::size_t l_dim     = p_target.size2();
+        const T* const l_point      = &p_target.data()[0];
+        T* const l_update           = &p_update.data()[0];
+        T l_stress                  = 0;
+        
+        #pragma omp parallel for reduction(+ : l_stress)
+        for(std::size_t l_row=0; l_row < l_size; l_row += l_tile)
+        {
+            const std::size_t l_rowend = std::min(l_row+l_tile, l_size);
+            std::fill( l_update+l_row*l_dim, l_update+l_rowend*l_dim, static_cast<T>(0) );
+            
+            for(std::size_t l_col=0; l_col < l_size; l_col += l_tile)
+                for(std::size_t i=l_row; i < l_rowend; ++i)
+                {
+                    const T* const l_pointi = l_point + i*l_dim;
+                    T* const l_updatei      = l_update + i*l_dim;
+                    
+                    for(std::size_t j=l_col; j < std::min(l_col+l_tile, l_size); ++j)
+                    {
+                        if (i == j)
+                            continue;
+                        
+                        const T* const l_pointj = l_point + j*l_dim;
+                        T l_distance = 0;
+                        for(std::size_t k=0; k < l_dim; ++k)
+                            l_distance += (l_pointi[k] - l_pointj[k]) * (l_pointi[k] - l_pointj[k]);
+                        l_distance = std::sqrt(l_distance);
+                        
+                        // every pair is visited twice
+                        l_stress += static_cast<T>(0.5) * (p_data(i,j) - l_distance) * (p_data(i,j) - l_distance);
+                        if (tools::function::isNumericalZero(l_distance))
+                            continue;
+                        
+                        const T l_ratio = p_data(i,j) / l_distance;
+                        for(std::size_t k=0; k < l_dim; ++k)
+                            l_updatei[k] += l_ratio * (l_pointi[k] - l_pointj[k]);
+                    }
+                }
+            
+            for(std::size_t i=l_row*l_dim; i < l_rowend*l_dim; ++i)
+                l_update[i] /= static_cast<T>(l_size);
+        }
+        
+        return l_stress;
     }
     
 
-    /** caluate the High-Throughput Dimensional Scaling (HIT-MDS)
-     * @todo optimize matrix with temporary assignment
+    /** returns the number of rows / columns of a tile within the passes over the point pairs. The tile
+     * size is at most 256, so a tile of the dissimilarities is held within the cache, and it is reduced for
+     * small data, so each thread gets a tile of rows
+     * @param p_size number of points
+     * @return tile size
+     **/
+    template<typename T> inline std::size_t mds<T>::tilesize( const std::size_t& p_size )
+    {
+        const std::size_t l_threads = static_cast<std::size_t>( std::max(1, omp_get_max_threads()) );
+        return std::max( static_cast<std::size_t>(1), std::min( static_cast<std::size_t>(256), (p_size + l_threads - 1) / l_threads ) );
+    }
+    
+    
+    /** caluate the High-Throughput Dimensional Scaling (HIT-MDS). Each iteration uses two tiled passes over the
+     * point pairs, the first pass creates the correlation statistics, the second one the update of the points,
+     * so no NxN matrix is created (the distances of the points are calculated within the passes)
      * @note the actual position of data points is dependent on the template type of the class, because the accuracy of the type of influence on the optimization
      * @see http://dig.ipk-gatersleben.de/hitmds/hitmds.html
      * @param p_data input datamatrix (dissimilarity matrix)
@@ -373,97 +688,107 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
      **/
     template<typename T> inline ublas::matrix<T> mds<T>::project_hit( const ublas::matrix<T>& p_data ) const
     {
-        ublas::matrix<T> l_target = tools::matrix::random( p_data.size1(), m_dim, tools::random::uniform, static_cast<T>(-1), static_cast<T>(1) );
-  
-        // count zero elements
-        std::vector< std::pair<std::size_t, std::size_t> > l_zeros;
-        #pragma omp parallel for shared(l_zeros)
-        for(std::size_t i=0; i < p_data.size1(); ++i)
-            for(std::size_t j=0; j < p_data.size2(); ++j)
-                if (tools::function::isNumericalZero(p_data(i,j)))
-                    #pragma omp critical
-                    l_zeros.push_back( std::pair<std::size_t, std::size_t>(i,j) );
+        const std::size_t l_tile    = tilesize(p_data.size1());
+        const std::size_t l_size    = p_data.size1();
+        ublas::matrix<T> l_target   = tools::matrix::random( l_size, m_dim, tools::random::uniform, static_cast<T>(-1), static_cast<T>(1) );
+        ublas::matrix<T> l_update(l_size, m_dim);
+        const T* const l_point      = &l_target.data()[0];
+        T* const l_updatepoint      = &l_update.data()[0];
+        
+        // count non-zero elements (zero elements are not used in the optimization)
+        std::size_t l_nonzero       = 0;
+        std::size_t l_nonzerodiag   = 0;
+        T l_datasum                 = 0;
         
-        // create init matrix and values
-        if (l_zeros.size() == p_data.size1() * p_data.size2())
+        #pragma omp parallel for reduction(+ : l_nonzero, l_nonzerodiag, l_datasum)
+        for(std::size_t i=0; i < l_size; ++i)
+            for(std::size_t j=0; j < l_size; ++j)
+                if (!tools::function::isNumericalZero(p_data(i,j)))
+                {
+                    l_nonzero++;
+                    l_datasum += p_data(i,j);
+                    if (i == j)
+                        l_nonzerodiag++;
+                }
+        
+        if (l_nonzero == 0)
             throw exception::runtime(_("data matrix has only zero entries"), *this);
         
-        ublas::matrix<T> l_data = p_data;
-        const T l_datainv       = static_cast<T>(1) / (l_data.size1() * l_data.size2() - l_zeros.size());
-        const T l_mnD           = l_datainv * ublas::sum( tools::matrix::sum(l_data) );
-        
-        #pragma omp parallel for shared(l_data)
-        for(std::size_t i=0; i < l_data.size1(); ++i)
-            for(std::size_t j=0; j < l_data.size2(); ++j)
-                if (i != j)
-                    l_data(i,j) -= l_mnD;
-        hit_setZeros(l_zeros, l_data);
-
+        // the data is centered with the mean value (except the diagonal elements)
+        const T l_datainv           = static_cast<T>(1) / l_nonzero;
+        const T l_mnD               = l_datainv * l_datasum;
+        const T l_datacentersum     = l_datasum - l_mnD * (l_nonzero - l_nonzerodiag);
+        
         
         // optimize
         for(std::size_t i=0; i < m_iteration; ++i) {
             
-            // create pairs of differences between optimized points and data
-            ublas::matrix<T> l_tmp(l_data.size1(), l_data.size2(), static_cast<T>(0));
-            for(std::size_t j=0; j < m_dim; ++j) {
-                // create a matrix with columns of the j-th column
-                ublas::matrix<T> l_col = tools::matrix::repeat( static_cast< ublas::vector<T> >(ublas::column(l_target, j)), tools::matrix::column );
-                
-                l_col -= ublas::trans(l_col);
-                l_tmp += ublas::element_prod(l_col, l_col);
-            }
-            
-            // optimize cost function
-            hit_setZeros(l_zeros, l_tmp);
-            for(std::size_t j=0; j < l_tmp.size1(); ++j)
-                for(std::size_t n=0; n < l_tmp.size2(); ++n)
-                    l_tmp(j,n) = std::sqrt( l_tmp(j,n) );
-            
-            const T l_mnT = l_datainv * ublas::sum( tools::matrix::sum(l_tmp) );
+            // first pass: sum of distances, squared distances and products of distances with centered data
+            T l_distsum         = 0;
+            T l_distsqrsum      = 0;
+            T l_distdatasum     = 0;
             
-            #pragma omp parallel for shared(l_tmp)
-            for(std::size_t j=0; j < l_tmp.size1(); ++j)
-                for(std::size_t n=0; n < l_tmp.size2(); ++n)
-                    l_tmp(j,n) -= l_mnT;
-            hit_setZeros(l_zeros, l_tmp);
+            #pragma omp parallel for reduction(+ : l_distsum, l_distsqrsum, l_distdatasum)
+            for(std::size_t l_row=0; l_row < l_size; l_row += l_tile)
+                for(std::size_t l_col=0; l_col < l_size; l_col += l_tile)
+                    for(std::size_t j=l_row; j < std::min(l_row+l_tile, l_size); ++j)
+                    {
+                        const T* const l_pointj = l_point + j*m_dim;
+                        for(std::size_t n=l_col; n < std::min(l_col+l_tile, l_size); ++n)
+                        {
+                            if (tools::function::isNumericalZero(p_data(j,n)))
+                                continue;
+                            
+                            const T* const l_pointn = l_point + n*m_dim;
+                            T l_dist = 0;
+                            for(std::size_t k=0; k < m_dim; ++k)
+                                l_dist += (l_pointj[k] - l_pointn[k]) * (l_pointj[k] - l_pointn[k]);
+                            l_dist = std::sqrt(l_dist);
+                            
+                            l_distsum       += l_dist;
+                            l_distsqrsum    += l_dist * l_dist;
+                            l_distdatasum   += l_dist * ((j == n) ? p_data(j,n) : p_data(j,n) - l_mnD);
+                        }
+                    }
             
-            // create adaption values
-            const ublas::matrix<T> l_el1 = ublas::element_prod(l_tmp, l_data);
-            const ublas::matrix<T> l_el2 = ublas::element_prod(l_tmp, l_tmp);
-            
-            T l_miT = ublas::sum( tools::matrix::sum( l_el1 ) ); 
-            T l_moT = ublas::sum( tools::matrix::sum( l_el2 ) );
+            // correlation values of the centered distances (sum (dist-mnT) * data and sum (dist-mnT)^2)
+            const T l_mnT   = l_datainv * l_distsum;
+            T l_miT         = l_distdatasum - l_mnT * l_datacentersum;
+            T l_moT         = l_distsqrsum - l_mnT * l_distsum;
  
             const T l_F  = static_cast<T>(2) / (std::fabs(l_miT) + std::fabs(l_moT));
             l_miT       *= l_F;
             l_moT       *= l_F;
             
             
-            // calculate update strength parts
-            ublas::matrix<T> l_strength = l_tmp * l_miT - l_data * l_moT;
-            
-            #pragma omp parallel for shared(l_tmp)
-            for(std::size_t j=0; j < l_tmp.size1(); ++j)
-                for(std::size_t n=0; n < l_tmp.size2(); ++n)
-                    l_tmp(j,n) += static_cast<T>(0.1) + l_mnT;
-            
-            l_strength = ublas::element_div(l_strength, l_tmp);
-          
-
-            // calculate update strength of the points
-            ublas::matrix<T> l_adapt = tools::matrix::repeat( static_cast< ublas::vector<T> >(ublas::column(l_target, m_dim-1)), tools::matrix::column );
-            l_adapt = ublas::element_prod( l_adapt-ublas::trans(l_adapt), l_strength);
-          
-            // create update matrix
-            ublas::matrix<T> l_update(l_target.size1(), l_target.size2(), static_cast<T>(0));
-            ublas::column(l_update, m_dim-1) = tools::matrix::sum(l_adapt, tools::matrix::column);
-
-            for(std::size_t j=0; j < m_dim-1; ++j) {
-                // create a matrix with columns of the j-th column
-                ublas::matrix<T> l_col = tools::matrix::repeat( static_cast< ublas::vector<T> >(ublas::column(l_target, j)), tools::matrix::column );
+            // second pass: update strength of the points, each thread creates the update of a tile of points
+            #pragma omp parallel for
+            for(std::size_t l_col=0; l_col < l_size; l_col += l_tile)
+            {
+                const std::size_t l_colend = std::min(l_col+l_tile, l_size);
+                std::fill( l_updatepoint+l_col*m_dim, l_updatepoint+l_colend*m_dim, static_cast<T>(0) );
                 
-                l_col  = ublas::element_prod(l_col-ublas::trans(l_col), l_strength);
-                ublas::column(l_update, j) = tools::matrix::sum(l_col, tools::matrix::column);
+                for(std::size_t l_row=0; l_row < l_size; l_row += l_tile)
+                    for(std::size_t j=l_row; j < std::min(l_row+l_tile, l_size); ++j)
+                    {
+                        const T* const l_pointj = l_point + j*m_dim;
+                        for(std::size_t n=l_col; n < l_colend; ++n)
+                        {
+                            if ( (j == n) || (tools::function::isNumericalZero(p_data(j,n))) )
+                                continue;
+                            
+                            const T* const l_pointn = l_point + n*m_dim;
+                            T l_dist = 0;
+                            for(std::size_t k=0; k < m_dim; ++k)
+                                l_dist += (l_pointj[k] - l_pointn[k]) * (l_pointj[k] - l_pointn[k]);
+                            l_dist = std::sqrt(l_dist);
+                            
+                            const T l_strength = ((l_dist - l_mnT) * l_miT - (p_data(j,n) - l_mnD) * l_moT) / (l_dist + static_cast<T>(0.1));
+                            T* const l_updaten = l_updatepoint + n*m_dim;
+                            for(std::size_t k=0; k < m_dim; ++k)
+                                l_updaten[k] += (l_pointj[k] - l_pointn[k]) * l_strength;
+                        }
+                    }
             }
             
             // create new target points
@@ -479,19 +804,7 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
     }
     
     
-    /** sets all elements which are in the vector to zero values
-     * @param p_zeros pair vector with indices
-     * @param p_matrix referenz of a matrix
-    **/
-    template<typename T> inline void mds<T>::hit_setZeros(const std::vector< std::pair<std::size_t, std::size_t> >& p_zeros, ublas::matrix<T>& p_matrix ) const
-    {
-        for(std::size_t i=0; i < p_zeros.size(); ++i)
-            p_matrix( p_zeros[i].first, p_zeros[i].second ) = static_cast<T>(0);
-    }
-    
-    
-    //======= MPI ==================================================================================================================================
-    #ifdef MACHINELEARNING_MPI
+    #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
     
     
     /** caluate and project the input data
@@ -526,12 +839,16 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
     }
     
     
-    /** caluate the High-Throughput Dimensional Scaling (HIT-MDS) with MPI
-     * @todo optimize matrix with temporary assignment
+    /** caluate the High-Throughput Dimensional Scaling (HIT-MDS) with MPI. Each process holds the columns of
+     * the dissimilarity matrix of its points, so the update of the local points is calculated without communication.
+     * Only the embedding (N x dimension) is gathered and three values are reduced on each iteration. The gathering
+     * of the embedding runs non-blocking during the calculation of the local block. The update of a point is a linear
+     * combination of three sums, which do not depend on the reduced correlation values, so the sums are calculated
+     * while the reduction runs non-blocking
      * @note the actual position of data points is dependent on the template type of the class, because the accuracy of the type of influence on the optimization
      * @see http://dig.ipk-gatersleben.de/hitmds/hitmds.html
      * @param p_mpi MPI object for communication
-     * @param p_data input datamatrix (dissimilarity matrix)
+     * @param p_data input datamatrix (columns of the dissimilarity matrix)
      * @return mapped data
      **/
     template<typename T> inline ublas::matrix<T> mds<T>::project_hit( const mpi::communicator& p_mpi, const ublas::matrix<T>& p_data ) const
@@ -541,204 +858,206 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
         const std::size_t l_dimensionMPI  = mpi::all_reduce(p_mpi, m_dim, mpi::maximum<std::size_t>());
         const T l_rateMPI                 = mpi::all_reduce(p_mpi, m_rate, mpi::maximum<T>());
         
-        // detect start position within the full matrix, for setting diagonal values
-        const std::size_t l_columnstart = hit_matrixPosition( p_mpi, p_data.size2() );
+        if (mpi::all_reduce(p_mpi, m_dim, mpi::minimum<std::size_t>()) != l_dimensionMPI)
+            throw exception::runtime(_("target dimension must be equal on all processes"), *this);
+        
+        // detect the position of the local points within the embedding (the embedding is stored row-wise, so
+        // the points of each process are a continuous block)
+        std::vector<std::size_t> l_columns;
+        mpi::all_gather(p_mpi, p_data.size2(), l_columns);
+        
+        std::vector<int> l_counts( l_columns.size() );
+        std::vector<int> l_displacements( l_columns.size(), 0 );
+        for(std::size_t i=0; i < l_columns.size(); ++i)
+        {
+            l_counts[i] = static_cast<int>(l_columns[i] * l_dimensionMPI);
+            if (i > 0)
+                l_displacements[i] = l_displacements[i-1] + l_counts[i-1];
+        }
+        const std::size_t l_columnstart = static_cast<std::size_t>(l_displacements[static_cast<std::size_t>(p_mpi.rank())]) / l_dimensionMPI;
         
         ublas::matrix<T> l_target = tools::matrix::random( p_data.size2(), l_dimensionMPI, tools::random::uniform, static_cast<T>(-1), static_cast<T>(1) );
+        ublas::matrix<T> l_embedding( p_data.size1(), l_dimensionMPI );
+        const std::size_t l_localsize = p_data.size2() * l_dimensionMPI;
+        std::vector<T> l_update( 3 * l_localsize );
         
-        // count zero elements
-        std::vector< std::pair<std::size_t, std::size_t> > l_zeros;
-        #pragma omp parallel for shared(l_zeros)
-        for(std::size_t i=0; i < p_data.size1(); ++i)
-            for(std::size_t j=0; j < p_data.size2(); ++j)
-                if (tools::function::isNumericalZero(p_data(i,j)))
-                    #pragma omp critical
-                    l_zeros.push_back( std::pair<std::size_t, std::size_t>(i,j) );
-        
-        // create init matrix and values
-        std::size_t l_numzeros = 0;
-        mpi::all_reduce(p_mpi, l_zeros.size(), l_numzeros, std::plus<std::size_t>());
-        if (l_numzeros == p_data.size1() * p_data.size1())
+        
+        // count non-zero elements (zero elements are not used in the optimization)
+        std::size_t l_nonzero[2]    = { 0, 0 };
+        T l_datasum                 = 0;
+        for(std::size_t j=0; j < p_data.size1(); ++j)
+            for(std::size_t n=0; n < p_data.size2(); ++n)
+                if (!tools::function::isNumericalZero(p_data(j,n)))
+                {
+                    l_nonzero[0]++;
+                    l_datasum += p_data(j,n);
+                    if (j == n+l_columnstart)
+                        l_nonzero[1]++;
+                }
+        
+        std::size_t l_nonzeroMPI[2] = { 0, 0 };
+        mpi::all_reduce(p_mpi, l_nonzero, 2, l_nonzeroMPI, std::plus<std::size_t>());
+        const T l_datasumMPI = mpi::all_reduce(p_mpi, l_datasum, std::plus<T>());
+        
+        if (l_nonzeroMPI[0] == 0)
             throw exception::runtime(_("data matrix has only zero entries"), *this);
     
-        ublas::matrix<T> l_data = p_data;
-        const T l_datainv       = static_cast<T>(1) / (l_data.size1() * l_data.size1() - l_numzeros);
-    
-        T l_help                = static_cast<T>(0);
-        mpi::all_reduce(p_mpi, ublas::sum( tools::matrix::sum(l_data) ), l_help, std::plus<T>());
-        const T l_mnD           = l_datainv * l_help;
-        
-        #pragma omp parallel for shared(l_data)
-        for(std::size_t i=0; i < l_data.size1(); ++i)
-            for(std::size_t j=0; j < l_data.size2(); ++j)
-                if (i != j+l_columnstart)
-                    l_data(i,j) -= l_mnD;
-        hit_setZeros(l_zeros, l_data);
+        // the data is centered with the mean value (except the diagonal elements)
+        const T l_datainv           = static_cast<T>(1) / l_nonzeroMPI[0];
+        const T l_mnD               = l_datainv * l_datasumMPI;
+        const T l_datacentersum     = l_datasumMPI - l_mnD * (l_nonzeroMPI[0] - l_nonzeroMPI[1]);
         
         
         // optimize
+        mpi::request l_gather = mpi::iall_gatherv(p_mpi, &l_target.data()[0], l_counts[static_cast<std::size_t>(p_mpi.rank())], &l_embedding.data()[0], l_counts, l_displacements);
         for(std::size_t i=0; i < l_iterationsMPI; ++i) {
             
-            // create pairs of differences between optimized points and data (the temp matrix has the size of the input matrix columns)
-            ublas::matrix<T> l_tmp(l_data.size2(), l_data.size1(), static_cast<T>(0));
-            for(std::size_t j=0; j < l_dimensionMPI; ++j) {
-                
-                // reads over all processes the column of the target matrix and extract the relevant elements
-                const ublas::vector<T> l_fullrow = hit_connectVector( p_mpi, static_cast< ublas::vector<T> >(ublas::column(l_target, j)) );
-                
-                // create a matrix with columns of the j-th column
-                ublas::matrix<T> l_col      = tools::matrix::repeat( static_cast< ublas::vector<T> >(ublas::column(l_target, j)), l_data.size1(), tools::matrix::column );
-                
-                // do subtract (equiv the subtract with transpose)
-                for(std::size_t n=0; n < l_col.size1(); ++n)
-                    ublas::row(l_col, n) -= l_fullrow;
-
-                l_tmp += ublas::element_prod(l_col, l_col);
-            }
-            
-            // transpose l_temp because we need the same oriantation like l_data (input matrix)
-            l_tmp = ublas::trans(l_tmp);
-            
-            // optimize cost function
-            hit_setZeros(l_zeros, l_tmp);
-            for(std::size_t j=0; j < l_tmp.size1(); ++j)
-                for(std::size_t n=0; n < l_tmp.size2(); ++n)
-                    l_tmp(j,n) = std::sqrt( l_tmp(j,n) );
-            
-            // the sum must be weighted with the full data size, because the square matrix l_tmp is only the part of the matrix.
-            l_help = static_cast<T>(0);
-            mpi::all_reduce(p_mpi, ublas::sum( tools::matrix::sum(l_tmp) ), l_help, std::plus<T>());
-            const T l_mnT = l_datainv * l_help;
+            // sum of distances, squared distances and products of distances with centered data, the local block is
+            // calculated with the local points, during the embedding is gathered
+            T l_sum[3]      = { 0, 0, 0 };
+            T l_sumMPI[3]   = { 0, 0, 0 };
             
-            #pragma omp parallel for shared(l_tmp)
-            for(std::size_t j=0; j < l_tmp.size1(); ++j)
-                for(std::size_t n=0; n < l_tmp.size2(); ++n)
-                    l_tmp(j,n) -= l_mnT;
-            hit_setZeros(l_zeros, l_tmp);
+            hit_correlation( p_data, l_columnstart, l_columnstart+p_data.size2(), &l_target.data()[0], &l_target.data()[0], l_columnstart, l_mnD, l_sum );
+            l_gather.wait();
+            hit_correlation( p_data, 0, l_columnstart, &l_embedding.data()[0], &l_target.data()[0], l_columnstart, l_mnD, l_sum );
+            if (l_columnstart+p_data.size2() < p_data.size1())
+                hit_correlation( p_data, l_columnstart+p_data.size2(), p_data.size1(), &l_embedding.data()[(l_columnstart+p_data.size2())*l_dimensionMPI], &l_target.data()[0], l_columnstart, l_mnD, l_sum );
             
+            // the update sums of the local points are calculated during the reduction
+            mpi::request l_reduce = mpi::iall_reduce(p_mpi, l_sum, 3, l_sumMPI, std::plus<T>());
+            hit_update( p_data, &l_embedding.data()[0], &l_target.data()[0], l_columnstart, l_mnD, &l_update[0] );
+            l_reduce.wait();
             
-            // create adaption values
-            const ublas::matrix<T> l_el1 = ublas::element_prod(l_tmp, l_data);
-            const ublas::matrix<T> l_el2 = ublas::element_prod(l_tmp, l_tmp);
-            
-            T l_miT = static_cast<T>(0);
-            T l_moT = static_cast<T>(0);
-            mpi::all_reduce(p_mpi, ublas::sum( tools::matrix::sum( l_el1 ) ), l_miT, std::plus<T>());
-            mpi::all_reduce(p_mpi, ublas::sum( tools::matrix::sum( l_el2 ) ), l_moT, std::plus<T>());
+            // correlation values of the centered distances (sum (dist-mnT) * data and sum (dist-mnT)^2)
+            const T l_mnT   = l_datainv * l_sumMPI[0];
+            T l_miT         = l_sumMPI[2] - l_mnT * l_datacentersum;
+            T l_moT         = l_sumMPI[1] - l_mnT * l_sumMPI[0];
             
             const T l_F  = static_cast<T>(2) / (std::fabs(l_miT) + std::fabs(l_moT));
             l_miT       *= l_F;
             l_moT       *= l_F;
             
-            // calculate update strength parts
-            ublas::matrix<T> l_strength = l_tmp * l_miT - l_data * l_moT;
-            
-            #pragma omp parallel for shared(l_tmp)
-            for(std::size_t j=0; j < l_tmp.size1(); ++j)
-                for(std::size_t n=0; n < l_tmp.size2(); ++n)
-                    l_tmp(j,n) += static_cast<T>(0.1) + l_mnT;
-            
-            l_strength = ublas::element_div(l_strength, l_tmp);
-
-    
-            // calculate update strength of the points - reads over all processes the column of the target matrix
-            const ublas::vector<T> l_fulllastrow = hit_connectVector( p_mpi, static_cast< ublas::vector<T> >(ublas::column(l_target, l_dimensionMPI-1)) );
-            
-            // create a matrix with columns of the j-th column
-            ublas::matrix<T> l_adapt         = tools::matrix::repeat( static_cast< ublas::vector<T> >(ublas::column(l_target, l_dimensionMPI-1)), l_data.size1(), tools::matrix::column );
-            
-            // do subtract (equiv the subtract with transpose)
-            for(std::size_t n=0; n < l_adapt.size1(); ++n)
-                ublas::row(l_adapt, n) -= l_fulllastrow;
-            
-            // strength matrix must be rotate
-            l_strength = ublas::trans(l_strength);
-            
-            // transpose l_temp because we need the same oriantation like l_adapt
-            l_adapt = ublas::element_prod(l_adapt, l_strength);
-            
-            
-            // we sum over all columns of the adapt matrix and sum over each element
-            // and cut the elements, which are needed for the local matrix
-            ublas::vector<T> l_lastcolumn( l_data.size1(), static_cast<T>(0) );
-            mpi::all_reduce(p_mpi, tools::matrix::sum(l_adapt, tools::matrix::column), l_lastcolumn, std::plus< ublas::vector<T> >());
-            ublas::vector_range< ublas::vector<T> > l_updatelastcolumn( l_lastcolumn, ublas::range( l_columnstart, l_columnstart+l_data.size2() ) );
+            // create new target points with the update miT * A - mnT * miT * B - moT * C of the three sums
+            const T l_rate = l_rateMPI * (l_iterationsMPI-i) * static_cast<T>(0.25) * (static_cast<T>(1) + (l_iterationsMPI-i)%2) / l_iterationsMPI;
+            T* const l_point = &l_target.data()[0];
             
-            // create update matrix
-            ublas::matrix<T> l_update(l_target.size1(), l_target.size2(), static_cast<T>(0));
-            ublas::column(l_update, l_dimensionMPI-1) =  l_updatelastcolumn;
-
-            for(std::size_t j=0; j < l_dimensionMPI-1; ++j) {
-                const ublas::vector<T> l_fullrow = hit_connectVector( p_mpi, static_cast< ublas::vector<T> >(ublas::column(l_target, j)) );
-                
-                // create a matrix with columns of the j-th column
-                ublas::matrix<T> l_col = tools::matrix::repeat( static_cast< ublas::vector<T> >(ublas::column(l_target, j)), l_data.size1(), tools::matrix::column );
-                
-                // do subtract (equiv the subtract with transpose)
-                for(std::size_t n=0; n < l_col.size1(); ++n)
-                    ublas::row(l_col, n) -= l_fullrow;
-    
-                l_col  = ublas::element_prod(l_col, l_strength);
-                
-                // we create the column data of the update matrix over all processes
-                ublas::vector<T> l_columnvector( l_data.size1(), static_cast<T>(0) );
-                mpi::all_reduce(p_mpi, tools::matrix::sum(l_col, tools::matrix::column), l_columnvector, std::plus< ublas::vector<T> >());
-                ublas::vector_range< ublas::vector<T> > l_updatecol( l_columnvector, ublas::range( l_columnstart, l_columnstart+l_data.size2() ) );
-                
-                ublas::column(l_update, j) = l_updatecol;
+            #pragma omp parallel for
+            for(std::size_t j=0; j < l_localsize; ++j)
+            {
+                const T l_pointupdate = l_miT * l_update[j] - l_mnT * l_miT * l_update[l_localsize+j] - l_moT * l_update[2*l_localsize+j];
+                l_point[j] += l_rate * l_pointupdate / std::sqrt(std::fabs(l_pointupdate)+static_cast<T>(0.001));
             }
             
-            // create new target points
-            const T l_rate = l_rateMPI * (l_iterationsMPI-i) * static_cast<T>(0.25) * (static_cast<T>(1) + (l_iterationsMPI-i)%2) / l_iterationsMPI;
-            
-            #pragma omp parallel for shared(l_target)
-            for(std::size_t j=0; j < l_target.size1(); ++j)
-                for(std::size_t n=0; n < l_target.size2(); ++n)
-                    l_target(j,n) += l_rate * l_update(j,n) / std::sqrt(std::fabs(l_update(j,n))+static_cast<T>(0.001));
+            // gathering of the new embedding runs until the local block of the next iteration is calculated
+            if (i+1 < l_iterationsMPI)
+                l_gather = mpi::iall_gatherv(p_mpi, &l_target.data()[0], l_counts[static_cast<std::size_t>(p_mpi.rank())], &l_embedding.data()[0], l_counts, l_displacements);
         }
+        l_gather.wait();
         
         return l_target;
     }
     
     
-    /** connects a vector over all processes and return the full vector
-     * @param p_mpi MPI object for communication
-     * @param p_vec input vector
-     * @return full vecotr
+    /** calculates the sum of distances, squared distances and the products of distances with the centered
+     * data of the rows [begin, end) and the local columns
+     * @param p_data local columns of the dissimilarity matrix
+     * @param p_begin first row
+     * @param p_end last row (excluded)
+     * @param p_point embedding of the rows (first element is the point of the first row)
+     * @param p_local embedding of the local points
+     * @param p_columnstart position of the first local point within the embedding
+     * @param p_mnD mean of the data
+     * @param p_sum array with the three sums
      **/
-    template<typename T> inline ublas::vector<T> mds<T>::hit_connectVector( const mpi::communicator& p_mpi, const ublas::vector<T>& p_vec ) const
+    template<typename T> inline void mds<T>::hit_correlation( const ublas::matrix<T>& p_data, const std::size_t& p_begin, const std::size_t& p_end, const T* p_point, const T* p_local, const std::size_t& p_columnstart, const T& p_mnD, T* p_sum ) const
     {
-        // gathering vector data
-        std::vector< ublas::vector<T> > l_data;
-        mpi::all_gather(p_mpi, p_vec, l_data);
+        const std::size_t l_tile    = tilesize(p_end-p_begin);
+        const std::size_t l_dim     = m_dim;
+        T l_distsum                 = 0;
+        T l_distsqrsum              = 0;
+        T l_distdatasum             = 0;
         
-        ublas::vector<T> l_vec = l_data[0];
-        for(std::size_t i=1; i < l_data.size(); ++i) {
-            l_vec.resize( l_vec.size() + l_data[i].size() );
-            
-            ublas::vector_range< ublas::vector<T> > l_range( l_vec, ublas::range( l_vec.size()-l_data[i].size(), l_vec.size() ) );
-            l_range.assign( l_data[i] );
-        }    
+        #pragma omp parallel for reduction(+ : l_distsum, l_distsqrsum, l_distdatasum)
+        for(std::size_t l_row=p_begin; l_row < p_end; l_row += l_tile)
+            for(std::size_t l_col=0; l_col < p_data.size2(); l_col += l_tile)
+                for(std::size_t j=l_row; j < std::min(l_row+l_tile, p_end); ++j)
+                {
+                    const T* const l_pointj = p_point + (j-p_begin)*l_dim;
+                    for(std::size_t n=l_col; n < std::min(l_col+l_tile, p_data.size2()); ++n)
+                    {
+                        if (tools::function::isNumericalZero(p_data(j,n)))
+                            continue;
+                        
+                        const T* const l_pointn = p_local + n*l_dim;
+                        T l_dist = 0;
+                        for(std::size_t k=0; k < l_dim; ++k)
+                            l_dist += (l_pointj[k] - l_pointn[k]) * (l_pointj[k] - l_pointn[k]);
+                        l_dist = std::sqrt(l_dist);
+                        
+                        l_distsum       += l_dist;
+                        l_distsqrsum    += l_dist * l_dist;
+                        l_distdatasum   += l_dist * ((j == n+p_columnstart) ? p_data(j,n) : p_data(j,n) - p_mnD);
+                    }
+                }
         
-        return l_vec;
+        p_sum[0] += l_distsum;
+        p_sum[1] += l_distsqrsum;
+        p_sum[2] += l_distdatasum;
     }
     
     
-    /** returns the position within the matrix (over all processes)
-     * @param p_mpi MPI object for communication
-     * @param p_col column position if the matrix part on the local process
-     * @return colum position of the local matrix
+    /** calculates the three sums of the update of the local points, each thread creates the sums of a tile of points.
+     * The update strength ((d - mnT) miT - (D - mnD) moT) / (d + 0.1) is split, so the update of a point is
+     * miT * A - mnT * miT * B - moT * C with A = sum diff d / (d + 0.1), B = sum diff / (d + 0.1) and C = sum diff (D - mnD) / (d + 0.1)
+     * @param p_data local columns of the dissimilarity matrix
+     * @param p_point full embedding
+     * @param p_local embedding of the local points
+     * @param p_columnstart position of the first local point within the embedding
+     * @param p_mnD mean of the data
+     * @param p_update array of the three sums of the local points (A, B and C are continuous blocks with the size of the local embedding)
      **/
-    template<typename T> inline std::size_t mds<T>::hit_matrixPosition( const mpi::communicator& p_mpi, const std::size_t& p_col ) const
+    template<typename T> inline void mds<T>::hit_update( const ublas::matrix<T>& p_data, const T* p_point, const T* p_local, const std::size_t& p_columnstart, const T& p_mnD, T* p_update ) const
     {
-        std::size_t l_col = 0;
-        std::vector<std::size_t> l_columndata;
-        mpi::all_gather(p_mpi, p_col, l_columndata);
-
-        for(std::size_t i=0; i < static_cast<std::size_t>(p_mpi.rank()); ++i)
-            l_col += l_columndata[i];
+        const std::size_t l_tile    = tilesize(p_data.size2());
+        const std::size_t l_dim     = m_dim;
+        const std::size_t l_size    = p_data.size2() * l_dim;
         
-        return l_col;
+        #pragma omp parallel for
+        for(std::size_t l_col=0; l_col < p_data.size2(); l_col += l_tile)
+        {
+            const std::size_t l_colend = std::min(l_col+l_tile, p_data.size2());
+            for(std::size_t k=0; k < 3; ++k)
+                std::fill( p_update+k*l_size+l_col*l_dim, p_update+k*l_size+l_colend*l_dim, static_cast<T>(0) );
+            
+            for(std::size_t l_row=0; l_row < p_data.size1(); l_row += l_tile)
+                for(std::size_t j=l_row; j < std::min(l_row+l_tile, p_data.size1()); ++j)
+                {
+                    const T* const l_pointj = p_point + j*l_dim;
+                    for(std::size_t n=l_col; n < l_colend; ++n)
+                    {
+                        if ( (j == n+p_columnstart) || (tools::function::isNumericalZero(p_data(j,n))) )
+                            continue;
+                        
+                        const T* const l_pointn = p_local + n*l_dim;
+                        T l_dist = 0;
+                        for(std::size_t k=0; k < l_dim; ++k)
+                            l_dist += (l_pointj[k] - l_pointn[k]) * (l_pointj[k] - l_pointn[k]);
+                        l_dist = std::sqrt(l_dist);
+                        
+                        const T l_inv       = static_cast<T>(1) / (l_dist + static_cast<T>(0.1));
+                        const T l_distance  = l_dist * l_inv;
+                        const T l_data      = (p_data(j,n) - p_mnD) * l_inv;
+                        T* const l_updaten  = p_update + n*l_dim;
+                        for(std::size_t k=0; k < l_dim; ++k)
+                        {
+                            const T l_diff               = l_pointj[k] - l_pointn[k];
+                            l_updaten[k]                += l_diff * l_distance;
+                            l_updaten[l_size+k]         += l_diff * l_inv;
+                            l_updaten[2*l_size+k]       += l_diff * l_data;
+                        }
+                    }
+                }
+        }
     }
     
     #endif
@@ -24,6 +24,8 @@
 #ifndef __MACHINELEARNING_DIMENSIONREDUCE_NONSUPERVISED_PCA_HPP
 #define __MACHINELEARNING_DIMENSIONREDUCE_NONSUPERVISED_PCA_HPP
 
+#include <cmath>
+#include <limits>
 #include <boost/static_assert.hpp>
 #include <boost/numeric/ublas/matrix.hpp>
 
@@ -39,7 +41,11 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
     #endif
     
     
-    /** create the principal component analysis (PCA) **/
+    /** create the principal component analysis (PCA). The randomized option uses a randomized SVD of the
+     * centered data, so the covariance matrix is not created (useful for large data with high dimension).
+     * The projection can be fitted once and used for other data, or it can be updated incrementally with
+     * data chunks (e.g. row blocks of a CSV or HDF file), so the data need not be stored
+     **/
     template<typename T> class pca : public reduce<T>
     {
         #ifndef SWIG
@@ -48,11 +54,24 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
         
         
         public :
+        
+            enum decomposition {
+                full                = 0,
+                randomized          = 1
+            };
+            
             
-            pca( const std::size_t& );
+            pca( const std::size_t&, const decomposition& = full );
             ublas::matrix<T> map( const ublas::matrix<T>& );
+            void fit( const ublas::matrix<T>& );
+            void update( const ublas::matrix<T>& );
+            ublas::matrix<T> transform( const ublas::matrix<T>& ) const;
             std::size_t getDimension( void ) const;
             ublas::matrix<T> getProject( void ) const;
+            ublas::vector<T> getMean( void ) const;
+            std::size_t getDataCount( void ) const;
+            void setOversampling( const std::size_t& );
+            void setIteration( const std::size_t& );
         
         
         private :
@@ -61,6 +80,20 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
             const std::size_t m_dim;
             /** matrix with project vectors **/
             ublas::matrix<T> m_project;
+            /** mean of the data **/
+            ublas::vector<T> m_mean;
+            /** singular values of the centered data (needed for the update) **/
+            ublas::vector<T> m_singular;
+            /** number of data points of the fit **/
+            std::size_t m_count;
+            /** decomposition type **/
+            const decomposition m_type;
+            /** number of additional random samples for the randomized decomposition **/
+            std::size_t m_oversampling;
+            /** number of power iterations for the randomized decomposition **/
+            std::size_t m_iteration;
+        
+            ublas::matrix<T> center( const ublas::matrix<T>&, const ublas::vector<T>& ) const;
         
     };
     
@@ -68,10 +101,17 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
     
     /** constructor
      * @param p_dim target dimension
+     * @param p_type decomposition type
     **/
-    template<typename T> inline pca<T>::pca( const std::size_t& p_dim ) :
+    template<typename T> inline pca<T>::pca( const std::size_t& p_dim, const decomposition& p_type ) :
         m_dim( p_dim ),
-        m_project()
+        m_project(),
+        m_mean(),
+        m_singular(),
+        m_count( 0 ),
+        m_type( p_type ),
+        m_oversampling( 10 ),
+        m_iteration( 2 )
     {
         if (p_dim == 0)
             throw exception::runtime(_("dimension must be greater than zero"), *this);
@@ -87,6 +127,26 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
     }
     
     
+    /** sets the number of additional random samples of the randomized decomposition
+     * (more samples increase the accuracy)
+     * @param p_oversampling number of samples
+     **/
+    template<typename T> inline void pca<T>::setOversampling( const std::size_t& p_oversampling )
+    {
+        m_oversampling = p_oversampling;
+    }
+    
+    
+    /** sets the number of power iterations of the randomized decomposition
+     * (more iterations increase the accuracy on slow decaying spectra)
+     * @param p_iteration number of iterations
+     **/
+    template<typename T> inline void pca<T>::setIteration( const std::size_t& p_iteration )
+    {
+        m_iteration = p_iteration;
+    }
+    
+    
     /** returns the vectors, which projects the data
      * @return matrix with vectors
      **/
@@ -96,10 +156,38 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
     }
     
     
+    /** returns the mean of the fitted data
+     * @return mean vector
+     **/
+    template<typename T> ublas::vector<T> pca<T>::getMean( void ) const
+    {
+        return m_mean;
+    }
+    
+    
+    /** returns the number of data points, that are used for the fit
+     * @return number of data points
+     **/
+    template<typename T> std::size_t pca<T>::getDataCount( void ) const
+    {
+        return m_count;
+    }
+    
+    
     /** caluate and project the input data
      * @param p_data input datamatrix
     **/
     template<typename T> inline ublas::matrix<T> pca<T>::map( const ublas::matrix<T>& p_data )
+    {
+        fit( p_data );
+        return transform( p_data );
+    }
+    
+    
+    /** calculates the projection of the input data (a previous fit is replaced)
+     * @param p_data input datamatrix
+     **/
+    template<typename T> inline void pca<T>::fit( const ublas::matrix<T>& p_data )
     {
         if (p_data.size1() == 0)
             throw exception::runtime(_("row size must be greater than zero"), *this);
@@ -109,29 +197,126 @@ namespace machinelearning { namespace dimensionreduce { namespace nonsupervised
             throw exception::runtime(_("datapoint dimension are less than target dimension"), *this);
         
         // centering the data
-        ublas::matrix<T> l_center = tools::matrix::centering<T>(p_data);
+        const ublas::vector<T> l_mean = tools::matrix::sum<T>(p_data, tools::matrix::column) / static_cast<T>(p_data.size1());
+        const ublas::matrix<T> l_center = center(p_data, l_mean);
+        
+        // the right singular vectors of the centered data are the eigenvectors of the covariance matrix
+        if (m_type == randomized)
+        {
+            ublas::matrix<T> l_left;
+            tools::lapack::randomizedSvd<T>(l_center, m_dim, m_singular, l_left, m_project, m_oversampling, m_iteration);
+            
+        } else {
+        
+            // creates if needed the covarianz matrix or create matrix product
+            ublas::matrix<T> l_data;
+            if (l_center.size2() < l_center.size1())
+                l_data = tools::matrix::cov<T>(l_center);
+            else
+                l_data =  (1.0 / l_center.size1()) * ublas::prod(ublas::trans(l_center), l_center);
+            
+            // calculate only the largest eigenvalues & -vectors of the symmetric matrix, the
+            // eigenvectors are the projection (descending order of the eigenvalues)
+            ublas::vector<T> l_eigenvalues;
+            tools::lapack::symmetricEigen<T>(l_data, m_dim, tools::lapack::largest, l_eigenvalues, m_project);
+            
+            // the singular values are the norm of the projected data
+            const ublas::matrix<T> l_projected = ublas::prod(l_center, m_project);
+            m_singular.resize(m_dim, false);
+            for(std::size_t i=0; i < m_dim; ++i)
+                m_singular(i) = ublas::norm_2( ublas::column(l_projected, i) );
+        }
         
-        // creates if needed the covarianz matrix or create matrix product
+        m_mean  = l_mean;
+        m_count = p_data.size1();
+    }
+    
+    
+    /** updates the projection with a data chunk (incremental PCA of Ross, Lim, Lin & Yang, 2008). The
+     * singular values & vectors of the previous data are merged with the chunk and a mean correction,
+     * so only the target dimension of the previous data is stored. The first update without a fit
+     * initializes the projection
+     * @param p_data data chunk
+     **/
+    template<typename T> inline void pca<T>::update( const ublas::matrix<T>& p_data )
+    {
+        if (p_data.size1() == 0)
+            throw exception::runtime(_("row size must be greater than zero"), *this);
+        if (p_data.size2() <= m_dim)
+            throw exception::runtime(_("datapoint dimension are less than target dimension"), *this);
+        if ( (m_count > 0) && (p_data.size2() != m_mean.size()) )
+            throw exception::runtime(_("column size of the data chunk must be equal to the fitted data"), *this);
+        
+        const ublas::vector<T> l_mean = tools::matrix::sum<T>(p_data, tools::matrix::column) / static_cast<T>(p_data.size1());
+        
+        // stacked matrix of the previous singular vectors, the centered chunk and the mean correction
         ublas::matrix<T> l_data;
-        if (l_center.size2() < l_center.size1())
-            l_data = tools::matrix::cov<T>(l_center);
+        if (m_count == 0) {
+            // the centered chunk has got a rank of the number of rows minus one
+            if (p_data.size1() <= m_dim)
+                throw exception::runtime(_("number of rows of the first data chunk must be greater than target dimension"), *this);
+            
+            l_data = center(p_data, l_mean);
+            
+        } else {
+            
+            l_data.resize( m_dim + p_data.size1() + 1, p_data.size2(), false );
+            for(std::size_t i=0; i < m_dim; ++i)
+                ublas::row(l_data, i) = m_singular(i) * ublas::column(m_project, i);
+            ublas::subrange(l_data, m_dim, m_dim + p_data.size1(), 0, l_data.size2()) = center(p_data, l_mean);
+            ublas::row(l_data, l_data.size1()-1) = std::sqrt( static_cast<T>(m_count) * static_cast<T>(p_data.size1()) / static_cast<T>(m_count + p_data.size1()) ) * (m_mean - l_mean);
+        }
+        
+        ublas::matrix<T> l_left;
+        ublas::matrix<T> l_project;
+        ublas::vector<T> l_singular;
+        tools::lapack::svd<T>(l_data, m_dim, l_singular, l_left, l_project);
+        
+        // a basis with a numerically zero singular value projects onto a direction, that is not within the data
+        if (l_singular(m_dim-1) <= std::numeric_limits<T>::epsilon() * std::max(l_data.size1(), l_data.size2()) * l_singular(0))
+            throw exception::runtime(_("rank of the data is less than target dimension"), *this);
+        
+        m_singular = l_singular;
+        m_project  = l_project;
+        
+        // update mean and number of data points
+        if (m_count == 0)
+            m_mean = l_mean;
         else
-            l_data =  (1.0 / l_center.size1()) * ublas::prod(ublas::trans(l_center), l_center);
-        
-        // calculate the eigenvalues & -vectors
-        ublas::vector<T> l_eigenvalues;
-        ublas::matrix<T> l_eigenvectors;
-        tools::lapack::eigen<T>(l_data, l_eigenvalues, l_eigenvectors);
-               
-        // rank the eigenvalues
-        const ublas::indirect_array<> l_rank = tools::vector::rankIndex( l_eigenvalues );
-                
-        // create projection (largest eigenvectors correspondends with the largest eigenvalues -> last values in rank)
-        m_project = ublas::matrix<T>( l_eigenvectors.size2(), m_dim );
-        for(std::size_t i=0; i < m_dim; ++i)
-            ublas::column(m_project, i) = ublas::column(l_eigenvectors, l_rank(l_rank.size()-i-1));
-        
-        return ublas::prod(l_center, m_project);
+            m_mean = (static_cast<T>(m_count) * m_mean + static_cast<T>(p_data.size1()) * l_mean) / static_cast<T>(m_count + p_data.size1());
+        m_count += p_data.size1();
+    }
+    
+    
+    /** projects data with the fitted projection
+     * @param p_data input datamatrix
+     * @return projected data
+     **/
+    template<typename T> inline ublas::matrix<T> pca<T>::transform( const ublas::matrix<T>& p_data ) const
+    {
+        if (m_count == 0)
+            throw exception::runtime(_("projection is not fitted"), *this);
+        if (p_data.size2() != m_mean.size())
+            throw exception::runtime(_("column size of the data must be equal to the fitted data"), *this);
+        
+        return ublas::prod(center(p_data, m_mean), m_project);
+    }
+    
+    
+    /** centers the data with a mean vector
+     * @param p_data input datamatrix
+     * @param p_mean mean vector
+     * @return centered data
+     **/
+    template<typename T> inline ublas::matrix<T> pca<T>::center( const ublas::matrix<T>& p_data, const ublas::vector<T>& p_mean ) const
+    {
+        ublas::matrix<T> l_center(p_data);
+        
+        #pragma omp parallel for shared(l_center)
+        for(std::size_t i=0; i < l_center.size1(); ++i)
+            ublas::row(l_center, i) -= p_mean;
+        
+        return l_center;
     }
     
 }}}
@@ -29,10 +29,6 @@
 #include <boost/static_assert.hpp>
 #include <boost/numeric/ublas/matrix.hpp>
 
-#ifdef MACHINELEARNING_MPI
-#include <boost/mpi.hpp>
-#endif
-
 #include "../../errorhandling/exception.hpp"
 #include "../../tools/tools.h"
 
@@ -44,8 +40,8 @@ namespace machinelearning { namespace dimensionreduce {
         
         #ifndef SWIG
         namespace ublas = boost::numeric::ublas;
-        #ifdef MACHINELEARNING_MPI
-        namespace mpi   = boost::mpi;
+        #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
+        namespace mpi   = machinelearning::tools::communication;
         #endif
         #endif
         
@@ -69,7 +65,7 @@ namespace machinelearning { namespace dimensionreduce {
         };
         
         
-        #ifdef MACHINELEARNING_MPI
+        #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
         
         /** abstract class for nonsupervised dimension reducing classes with MPI support **/      
         template<typename T> class reducempi
@@ -28,8 +28,13 @@
 #include <omp.h>
 
 #include <map>
+#include <set>
+#include <cmath>
+#include <vector>
+#include <limits>
 #include <boost/numeric/ublas/matrix.hpp>
 #include <boost/numeric/ublas/vector.hpp>
+#include <boost/numeric/ublas/matrix_proxy.hpp>
 
 #include "reduce.hpp"
 #include "../../errorhandling/exception.hpp"
@@ -43,7 +48,12 @@ namespace machinelearning { namespace dimensionreduce { namespace supervised {
     #endif
     
     
-    /** class for projection the (Fisher) lineare discriminant analysis (LDA) **/
+    /** class for projection the (Fisher) lineare discriminant analysis (LDA). The within-class scatter
+     * and the class means are accumulated in one pass over the data, so the data can be passed in
+     * labeled chunks (e.g. row blocks of a HDF file) and need not be stored. The projection is
+     * solved as a symmetric-definite eigenproblem of the between-class and within-class scatter
+     * on the first use of the projection after the data is changed
+     **/
     template<typename T, typename L> class lda : public reduce<T,L>
     {
         
@@ -51,16 +61,31 @@ namespace machinelearning { namespace dimensionreduce { namespace supervised {
         
             lda( const std::size_t& );
             ublas::matrix<T> map( const ublas::matrix<T>&, const std::vector<L>& );
+            void fit( const ublas::matrix<T>&, const std::vector<L>& );
+            void update( const ublas::matrix<T>&, const std::vector<L>& );
+            ublas::matrix<T> transform( const ublas::matrix<T>& ) const;
             std::size_t getDimension( void ) const;
             ublas::matrix<T> getProject( void ) const;
+            std::size_t getDataCount( void ) const;
         
         
         private :
         
             /** target dimension **/
             const std::size_t m_dim;
-            /** project vectors **/
-            ublas::matrix<T> m_project;
+            /** project vectors (calculated on the first use after a change of the data) **/
+            mutable ublas::matrix<T> m_project;
+            /** flag, that the scatter matrices are changed after the projection is calculated **/
+            mutable bool m_changed;
+            /** number of data points of every class **/
+            std::map<L, std::size_t> m_count;
+            /** mean of every class **/
+            std::map<L, ublas::vector<T> > m_mean;
+            /** within-class scatter (upper triangle) **/
+            ublas::matrix<T> m_scatter;
+        
+            void merge( std::map<L, std::size_t>&, std::map<L, ublas::vector<T> >&, ublas::matrix<T>&, const std::map<L, std::size_t>&, const std::map<L, ublas::vector<T> >&, const ublas::matrix<T>& ) const;
+            void solve( void ) const;
     };
     
     
@@ -69,7 +94,11 @@ namespace machinelearning { namespace dimensionreduce { namespace supervised {
     **/
     template<typename T, typename L> inline lda<T,L>::lda( const std::size_t& p_dim) :
         m_dim(p_dim),
-        m_project()
+        m_project(),
+        m_changed( false ),
+        m_count(),
+        m_mean(),
+        m_scatter()
     {
         if (p_dim == 0)
             throw exception::runtime(_("dimension must be greater than zero"), *this);
@@ -90,75 +119,223 @@ namespace machinelearning { namespace dimensionreduce { namespace supervised {
      **/
     template<typename T, typename L> ublas::matrix<T> lda<T,L>::getProject( void ) const
     {
+        solve();
         return m_project;
     }
     
     
+    /** returns the number of data points, that are used for the fit
+     * @return number of data points
+     **/
+    template<typename T, typename L> std::size_t lda<T,L>::getDataCount( void ) const
+    {
+        std::size_t l_count = 0;
+        for(typename std::map<L, std::size_t>::const_iterator it = m_count.begin(); it != m_count.end(); ++it)
+            l_count += it->second;
+        return l_count;
+    }
+    
+    
     /** caluate and project the input data
      * @param p_data input datamatrix
      * @param p_label labeling for matrix rows
      * @return matrix with mapped points
-     * @todo change matrix copy with ublas ranges
      **/
     template<typename T, typename L> inline ublas::matrix<T> lda<T, L>::map( const ublas::matrix<T>& p_data, const std::vector<L>& p_label )
     {
+        fit( p_data, p_label );
+        return transform( p_data );
+    }
+    
+    
+    /** calculates the projection of the input data (a previous fit is replaced)
+     * @param p_data input datamatrix
+     * @param p_label labeling for matrix rows
+     **/
+    template<typename T, typename L> inline void lda<T, L>::fit( const ublas::matrix<T>& p_data, const std::vector<L>& p_label )
+    {
+        // the data is checked before the previous fit is removed, we can only reduce to length(classes)-1
         if (p_data.size1() != p_label.size())
             throw exception::runtime(_("matrix rows and label size are not equal"), *this);
+        if (p_data.size2() <= m_dim)
+            throw exception::runtime(_("datapoint dimension are less than target dimension"), *this);
+        if (m_dim >= std::set<L>(p_label.begin(), p_label.end()).size())
+            throw exception::runtime(_("target dimension must be less than unique data classes"), *this);
         
-        // create a unique label vector
-        std::vector<L> l_uniquelabel = tools::vector::unique<L>(p_label);
+        m_count.clear();
+        m_mean.clear();
+        m_scatter = ublas::matrix<T>();
+        m_project = ublas::matrix<T>();
         
-        // we can only reduce to length(classes)-1
-        if (m_dim >= l_uniquelabel.size())
-            throw exception::runtime(_("target dimension must be less than unique data classes"), *this);
-        // centering the data
-        ublas::matrix<T> l_center = tools::matrix::centering<T>(p_data);        
+        update( p_data, p_label );
+    }
+    
+    
+    /** updates the scatter matrices with a labeled data chunk. Every thread accumulates the class means and the
+     * within-class scatter of its rows with the Welford update, the partial results are merged with the pairwise
+     * update of Chan, Golub & LeVeque. The projection is calculated on the next use, so chunks can be added
+     * without solving the eigenproblem after each chunk
+     * @param p_data data chunk
+     * @param p_label labeling for the chunk rows
+     **/
+    template<typename T, typename L> inline void lda<T, L>::update( const ublas::matrix<T>& p_data, const std::vector<L>& p_label )
+    {
+        if (p_data.size1() != p_label.size())
+            throw exception::runtime(_("matrix rows and label size are not equal"), *this);
+        if (p_data.size1() == 0)
+            throw exception::runtime(_("row size must be greater than zero"), *this);
+        if (p_data.size2() <= m_dim)
+            throw exception::runtime(_("datapoint dimension are less than target dimension"), *this);
+        if ( (!m_count.empty()) && (p_data.size2() != m_scatter.size1()) )
+            throw exception::runtime(_("column size of the data chunk must be equal to the fitted data"), *this);
         
-        // we create a map for indexing the rows of the matrix with their labels
-        std::multimap<L, std::size_t> l_index;
-        for(std::size_t i=0; i < p_label.size(); ++i)
-            l_index.insert( std::make_pair(p_label[i], i) );
-
-        // calculate covarianz for every class and all data
-        ublas::matrix<T> l_sb = tools::matrix::cov(l_center);
-        ublas::matrix<T> l_sw(l_sb.size1(), l_sb.size2());
-        const T l_classes = static_cast<T>(l_uniquelabel.size()-1);
+        if (m_count.empty())
+            m_scatter = ublas::zero_matrix<T>(p_data.size2(), p_data.size2());
+        
+        std::map<L, std::size_t> l_count;
+        std::map<L, ublas::vector<T> > l_mean;
+        ublas::matrix<T> l_scatter( ublas::zero_matrix<T>(p_data.size2(), p_data.size2()) );
+        
+        #pragma omp parallel shared(l_count, l_mean, l_scatter)
+        {
+            std::map<L, std::size_t> l_localcount;
+            std::map<L, ublas::vector<T> > l_localmean;
+            ublas::matrix<T> l_localscatter( ublas::zero_matrix<T>(p_data.size2(), p_data.size2()) );
+            ublas::vector<T> l_delta( p_data.size2() );
+            
+            #pragma omp for nowait
+            for(std::size_t i=0; i < p_data.size1(); ++i) {
+                
+                std::size_t& l_classcount = l_localcount[p_label[i]];
+                ublas::vector<T>& l_classmean = l_localmean[p_label[i]];
+                if (l_classcount == 0)
+                    l_classmean = ublas::zero_vector<T>(p_data.size2());
+                l_classcount++;
+                
+                // Welford update: delta with the old mean, the scatter is updated with the new mean (only upper triangle)
+                l_delta = ublas::row(p_data, i) - l_classmean;
+                l_classmean += l_delta / static_cast<T>(l_classcount);
+                
+                for(std::size_t j=0; j < l_delta.size(); ++j) {
+                    const T l_value = l_delta(j);
+                    for(std::size_t n=j; n < l_delta.size(); ++n)
+                        l_localscatter(j, n) += l_value * (p_data(i, n) - l_classmean(n));
+                }
+            }
+            
+            #pragma omp critical
+            merge( l_count, l_mean, l_scatter, l_localcount, l_localmean, l_localscatter );
+        }
+        
+        merge( m_count, m_mean, m_scatter, l_count, l_mean, l_scatter );
+        m_changed = true;
+    }
     
-        #pragma omp parallel for shared(l_uniquelabel, l_sw)
-        for(std::size_t i=0; i < l_uniquelabel.size(); ++i) {
+    
+    /** projects data with the fitted projection
+     * @param p_data input datamatrix
+     * @return projected data
+     **/
+    template<typename T, typename L> inline ublas::matrix<T> lda<T, L>::transform( const ublas::matrix<T>& p_data ) const
+    {
+        solve();
+        if (m_project.size2() == 0)
+            throw exception::runtime(_("projection is not fitted"), *this);
+        if (p_data.size2() != m_project.size1())
+            throw exception::runtime(_("column size of the data must be equal to the fitted data"), *this);
+        
+        return ublas::prod(p_data, m_project);
+    }
+    
+    
+    /** merges the class statistics of two data sets. The means are weighted by the number of data points and
+     * the scatter is corrected with the mean differences of the classes
+     * @param p_count number of data points of every class of the target
+     * @param p_mean class means of the target
+     * @param p_scatter within-class scatter of the target (upper triangle)
+     * @param p_addcount number of data points of every class, that are merged
+     * @param p_addmean class means, that are merged
+     * @param p_addscatter within-class scatter, that is merged (upper triangle)
+     **/
+    template<typename T, typename L> inline void lda<T, L>::merge( std::map<L, std::size_t>& p_count, std::map<L, ublas::vector<T> >& p_mean, ublas::matrix<T>& p_scatter, const std::map<L, std::size_t>& p_addcount, const std::map<L, ublas::vector<T> >& p_addmean, const ublas::matrix<T>& p_addscatter ) const
+    {
+        p_scatter += p_addscatter;
+        
+        for(typename std::map<L, std::size_t>::const_iterator it = p_addcount.begin(); it != p_addcount.end(); ++it) {
+            const ublas::vector<T>& l_addmean = p_addmean.find(it->first)->second;
             
-            // extract index from map | typename must be first, because is a exotic structure of C++ :-)
-            // create a matrix whitch holds the rows for every class. Create a matrix with index elements for the rows
-            std::size_t n=0;
-            ublas::matrix<T> l_cluster(  std::distance(l_index.lower_bound(l_uniquelabel[i]), l_index.upper_bound(l_uniquelabel[i])),  l_center.size2()  );
-            for( typename std::multimap<L, std::size_t>::iterator it = l_index.lower_bound(l_uniquelabel[i]); it != l_index.upper_bound(l_uniquelabel[i]); ++it )
-                // -> do this with range
-                ublas::row(l_cluster, n++) = ublas::row(l_center, it->second);
+            typename std::map<L, std::size_t>::iterator l_class = p_count.find(it->first);
+            if (l_class == p_count.end()) {
+                p_count[it->first] = it->second;
+                p_mean[it->first]  = l_addmean;
+                continue;
+            }
             
-            // calculate covarianz for the cluster
-            #pragma omp critical 
-            l_sw     += l_cluster.size1() / l_classes * tools::matrix::cov(l_cluster);
+            ublas::vector<T>& l_mean = p_mean[it->first];
+            const T l_count          = static_cast<T>(l_class->second);
+            const T l_addcount       = static_cast<T>(it->second);
+            const ublas::vector<T> l_delta = l_addmean - l_mean;
+            const T l_weight         = l_count * l_addcount / (l_count + l_addcount);
             
+            for(std::size_t j=0; j < l_delta.size(); ++j)
+                for(std::size_t n=j; n < l_delta.size(); ++n)
+                    p_scatter(j, n) += l_weight * l_delta(j) * l_delta(n);
+            
+            l_mean          += l_delta * (l_addcount / (l_count + l_addcount));
+            l_class->second += it->second;
         }
-
-        // calculate the eigenvalues & -vectors
+    }
+    
+    
+    /** calculates the projection with the between-class and the within-class scatter, if the scatter is changed after
+     * the last calculation. The largest generalized eigenvectors of Sb x = lambda Sw x are the projection, the within-class
+     * scatter is regularized, so that the Cholesky decomposition exists
+     **/
+    template<typename T, typename L> inline void lda<T, L>::solve( void ) const
+    {
+        if (!m_changed)
+            return;
+        
+        // we can only reduce to length(classes)-1
+        if (m_dim >= m_count.size())
+            throw exception::runtime(_("target dimension must be less than unique data classes"), *this);
+        
+        // overall mean and between-class scatter
+        std::size_t l_count = 0;
+        ublas::vector<T> l_mean( ublas::zero_vector<T>(m_scatter.size1()) );
+        for(typename std::map<L, std::size_t>::const_iterator it = m_count.begin(); it != m_count.end(); ++it) {
+            l_mean  += static_cast<T>(it->second) * m_mean.find(it->first)->second;
+            l_count += it->second;
+        }
+        l_mean /= static_cast<T>(l_count);
+        
+        ublas::matrix<T> l_between( ublas::zero_matrix<T>(m_scatter.size1(), m_scatter.size2()) );
+        for(typename std::map<L, std::size_t>::const_iterator it = m_count.begin(); it != m_count.end(); ++it) {
+            const ublas::vector<T> l_delta = m_mean.find(it->first)->second - l_mean;
+            l_between += static_cast<T>(it->second) * ublas::outer_prod(l_delta, l_delta);
+        }
+        
+        // the within-class scatter is singular, if the dimension is greater than the number of data points
+        ublas::matrix<T> l_within(m_scatter);
+        const T l_ridge = std::sqrt(std::numeric_limits<T>::epsilon()) * std::max( tools::matrix::trace<T>(l_within) / static_cast<T>(l_within.size1()), std::numeric_limits<T>::epsilon() );
+        for(std::size_t i=0; i < l_within.size1(); ++i)
+            l_within(i, i) += l_ridge;
+        
+        // calculate the eigenvalues & -vectors (ascending order)
         ublas::vector<T> l_eigenvalues;
         ublas::matrix<T> l_eigenvectors;
-        ublas::matrix<T> l_sdiff = l_sb-l_sw;
-        tools::lapack::eigen<T>(l_sdiff, l_sw, l_eigenvalues, l_eigenvectors);
-       
-        // rank the eigenvalues
-        const ublas::indirect_array<> l_rank = tools::vector::rankIndex( l_eigenvalues );
+        tools::lapack::symmetricEigen<T>(l_between, l_within, l_eigenvalues, l_eigenvectors);
         
-        // create projection (largest eigenvectors correspondends with the largest eigenvalues -> last values in rank)
-        m_project = ublas::matrix<T>( l_eigenvectors.size2(), m_dim );
-        for(std::size_t i=0; i < m_dim; ++i)
-            ublas::column(m_project, i) = ublas::column(l_eigenvectors, l_rank(l_rank.size()-i-1));
+        // create projection (largest eigenvectors correspondends with the largest eigenvalues -> last values)
+        m_project = ublas::matrix<T>( l_eigenvectors.size1(), m_dim );
+        for(std::size_t i=0; i < m_dim; ++i) {
+            ublas::column(m_project, i) = ublas::column(l_eigenvectors, l_eigenvectors.size2()-i-1);
+            ublas::column(m_project, i) /= ublas::norm_2( ublas::column(m_project, i) );
+        }
         
-        return ublas::prod(p_data, m_project);
+        m_changed = false;
     }
     
 
-
 }}}
 #endif
@@ -0,0 +1,89 @@
+/** 
+ @cond
+ ############################################################################
+ # LGPL License                                                             #
+ #                                                                          #
+ # This file is part of the Machine Learning Framework.                     #
+ # Copyright (c) 2010-2012, Philipp Kraus, <philipp.kraus@flashpixx.de>     #
+ # This program is free software: you can redistribute it and/or modify     #
+ # it under the terms of the GNU Lesser General Public License as           #
+ # published by the Free Software Foundation, either version 3 of the       #
+ # License, or (at your option) any later version.                          #
+ #                                                                          #
+ # This program is distributed in the hope that it will be useful,          #
+ # but WITHOUT ANY WARRANTY; without even the implied warranty of           #
+ # MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            #
+ # GNU Lesser General Public License for more details.                      #
+ #                                                                          #
+ # You should have received a copy of the GNU Lesser General Public License #
+ # along with this program. If not, see <http://www.gnu.org/licenses/>.     #
+ ############################################################################
+ @endcond
+ **/
+
+
+
+#ifndef __MACHINELEARNING_DISTANCES_CDM_HPP
+#define __MACHINELEARNING_DISTANCES_CDM_HPP
+
+#include <string>
+
+#include "ncd.hpp"
+
+
+
+
+namespace machinelearning { namespace distances {   
+    
+    
+    /**
+     * class for calculating the compression-based dissimilarity measure (CDM)
+     * CDM(x,y) = C(xy) / ( C(x) + C(y) ), that uses the same compressions,
+     * blocks and caches of the NCD. The values are bounded above by 1, the
+     * lower bound is 0.5 only for an ideal compressor (real compressors can
+     * create smaller values for similar elements), the diagonal of the matrices is zero
+     **/
+    template<typename T> class cdm : public ncd<T>
+    {
+        
+        public:
+            
+            cdm ( void );
+            cdm ( const typename ncd<T>::compresstype& );
+            
+        protected:
+            
+            T measure( const std::size_t&, const std::size_t&, const std::size_t& ) const;
+        
+    };
+    
+    
+    
+    /** default constructor **/
+    template<typename T> inline cdm<T>::cdm( void ) :
+        ncd<T>()
+    {}
+    
+    
+    /** constructor with the compression parameter
+     * @param p_compress enum value that is declared inside the NCD class
+     **/
+    template<typename T> inline cdm<T>::cdm( const typename ncd<T>::compresstype& p_compress ) :
+        ncd<T>( p_compress )
+    {}
+    
+    
+    /** calculates the CDM of the compressed sizes
+     * @param p_pair compressed size of the concatenation
+     * @param p_first compressed size of the first element
+     * @param p_second compressed size of the second element
+     * @return distance value
+     **/
+    template<typename T> inline T cdm<T>::measure( const std::size_t& p_pair, const std::size_t& p_first, const std::size_t& p_second ) const
+    {
+        return static_cast<T>(p_pair) / static_cast<T>(p_first + p_second);
+    }
+    
+    
+}}
+#endif
@@ -43,6 +43,10 @@ namespace machinelearning {
 
 #include "distance.hpp"
 #include "ncd.hpp"
+#include "cdm.hpp"
+#include "sketch.hpp"
+#include "lzjd.hpp"
+#include "minhash.hpp"
 #include "norm/euclid.hpp"
 
 #endif
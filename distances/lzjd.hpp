@@ -0,0 +1,151 @@
+/** 
+ @cond
+ ############################################################################
+ # LGPL License                                                             #
+ #                                                                          #
+ # This file is part of the Machine Learning Framework.                     #
+ # Copyright (c) 2010-2012, Philipp Kraus, <philipp.kraus@flashpixx.de>     #
+ # This program is free software: you can redistribute it and/or modify     #
+ # it under the terms of the GNU Lesser General Public License as           #
+ # published by the Free Software Foundation, either version 3 of the       #
+ # License, or (at your option) any later version.                          #
+ #                                                                          #
+ # This program is distributed in the hope that it will be useful,          #
+ # but WITHOUT ANY WARRANTY; without even the implied warranty of           #
+ # MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            #
+ # GNU Lesser General Public License for more details.                      #
+ #                                                                          #
+ # You should have received a copy of the GNU Lesser General Public License #
+ # along with this program. If not, see <http://www.gnu.org/licenses/>.     #
+ ############################################################################
+ @endcond
+ **/
+
+
+
+#ifndef __MACHINELEARNING_DISTANCES_LZJD_HPP
+#define __MACHINELEARNING_DISTANCES_LZJD_HPP
+
+#include <set>
+#include <vector>
+#include <algorithm>
+
+#include <boost/cstdint.hpp>
+
+#include "../errorhandling/exception.hpp"
+#include "sketch.hpp"
+
+
+
+
+namespace machinelearning { namespace distances {   
+    
+    
+    /**
+     * class for calculating the Lempel-Ziv Jaccard distance (LZJD). The data is split
+     * into the phrases of a LZ78 dictionary and the distance is the Jaccard distance of
+     * the phrase sets, that is approximated by the bottom-k sketch (the k smallest hash
+     * values) of each set
+     * @see http://arxiv.org/abs/1708.03346
+     **/
+    template<typename T> class lzjd : public sketch<T>
+    {
+        
+        public:
+            
+            lzjd ( const std::size_t& = 1024 );
+            
+        protected:
+            
+            std::vector<boost::uint64_t> create( const char*, const std::size_t& ) const;
+            T distance( const std::vector<boost::uint64_t>&, const std::vector<boost::uint64_t>& ) const;
+            
+        private:
+            
+            /** number of hash values of the sketch **/
+            const std::size_t m_size;
+        
+    };
+    
+    
+    
+    /** constructor
+     * @param p_size number of hash values of the sketch
+     **/
+    template<typename T> inline lzjd<T>::lzjd( const std::size_t& p_size ) :
+        m_size( p_size )
+    {
+        if (!p_size)
+            throw exception::runtime(_("sketch size must be greater than zero"), *this);
+    }
+    
+    
+    /** creates the sketch of the phrases. A phrase is extended by the next byte until the
+     * phrase is not within the set, so the phrase is added and a new phrase starts. The
+     * phrases are identified by their FNV-1a hash, that is extended on each byte
+     * @param p_data data
+     * @param p_size number of bytes
+     * @return sorted k smallest hash values of the phrase set
+     **/
+    template<typename T> inline std::vector<boost::uint64_t> lzjd<T>::create( const char* p_data, const std::size_t& p_size ) const
+    {
+        const boost::uint64_t l_basis = tools::function::fnv( p_data, 0 );
+        
+        std::set<boost::uint64_t> l_phrases;
+        boost::uint64_t l_hash = l_basis;
+        for(std::size_t i=0; i < p_size; ++i) {
+            l_hash = tools::function::fnvAppend( l_hash, p_data[i] );
+            if (l_phrases.insert(l_hash).second)
+                l_hash = l_basis;
+        }
+        
+        // the mixed values are a random order of the phrases, so the smallest values are a uniform sample
+        std::vector<boost::uint64_t> l_sketch;
+        l_sketch.reserve( l_phrases.size() );
+        for(std::set<boost::uint64_t>::const_iterator it = l_phrases.begin(); it != l_phrases.end(); ++it)
+            l_sketch.push_back( tools::function::mix(*it) );
+        
+        if (l_sketch.size() > m_size) {
+            std::nth_element( l_sketch.begin(), l_sketch.begin() + m_size, l_sketch.end() );
+            l_sketch.resize( m_size );
+        }
+        std::sort( l_sketch.begin(), l_sketch.end() );
+        
+        return l_sketch;
+    }
+    
+    
+    /** calculates the estimated Jaccard distance of two sketches. The k smallest values of the
+     * union are merged and the values, that are within both sketches, are the estimated intersection
+     * @param p_first first sketch
+     * @param p_second second sketch
+     * @return distance value
+     **/
+    template<typename T> inline T lzjd<T>::distance( const std::vector<boost::uint64_t>& p_first, const std::vector<boost::uint64_t>& p_second ) const
+    {
+        std::size_t l_union        = 0;
+        std::size_t l_intersection = 0;
+        
+        std::vector<boost::uint64_t>::const_iterator l_first  = p_first.begin();
+        std::vector<boost::uint64_t>::const_iterator l_second = p_second.begin();
+        for( ; (l_union < m_size) && ((l_first != p_first.end()) || (l_second != p_second.end())); ++l_union) {
+            if ( (l_second == p_second.end()) || ((l_first != p_first.end()) && (*l_first < *l_second)) )
+                ++l_first;
+            else if ( (l_first == p_first.end()) || (*l_second < *l_first) )
+                ++l_second;
+            else {
+                ++l_first;
+                ++l_second;
+                ++l_intersection;
+            }
+        }
+        
+        if (!l_union)
+            return static_cast<T>(0);
+        
+        return static_cast<T>(1) - static_cast<T>(l_intersection) / static_cast<T>(l_union);
+    }
+    
+    
+}}
+#endif
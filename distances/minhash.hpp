@@ -0,0 +1,144 @@
+/** 
+ @cond
+ ############################################################################
+ # LGPL License                                                             #
+ #                                                                          #
+ # This file is part of the Machine Learning Framework.                     #
+ # Copyright (c) 2010-2012, Philipp Kraus, <philipp.kraus@flashpixx.de>     #
+ # This program is free software: you can redistribute it and/or modify     #
+ # it under the terms of the GNU Lesser General Public License as           #
+ # published by the Free Software Foundation, either version 3 of the       #
+ # License, or (at your option) any later version.                          #
+ #                                                                          #
+ # This program is distributed in the hope that it will be useful,          #
+ # but WITHOUT ANY WARRANTY; without even the implied warranty of           #
+ # MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            #
+ # GNU Lesser General Public License for more details.                      #
+ #                                                                          #
+ # You should have received a copy of the GNU Lesser General Public License #
+ # along with this program. If not, see <http://www.gnu.org/licenses/>.     #
+ ############################################################################
+ @endcond
+ **/
+
+
+
+#ifndef __MACHINELEARNING_DISTANCES_MINHASH_HPP
+#define __MACHINELEARNING_DISTANCES_MINHASH_HPP
+
+#include <limits>
+#include <vector>
+#include <algorithm>
+
+#include <boost/cstdint.hpp>
+
+#include "../errorhandling/exception.hpp"
+#include "sketch.hpp"
+
+
+
+
+namespace machinelearning { namespace distances {   
+    
+    
+    /**
+     * class for calculating the MinHash approximation of the Jaccard distance of the byte
+     * n-gram sets. The sketch uses one permutation hashing: each n-gram is hashed once,
+     * the hash value selects a bin and each bin holds the minimum of its values, the empty
+     * bins are filled with the value of the next bin (densification by rotation)
+     * @see http://arxiv.org/abs/1406.4784
+     **/
+    template<typename T> class minhash : public sketch<T>
+    {
+        
+        public:
+            
+            minhash ( const std::size_t& = 4, const std::size_t& = 256 );
+            
+        protected:
+            
+            std::vector<boost::uint64_t> create( const char*, const std::size_t& ) const;
+            T distance( const std::vector<boost::uint64_t>&, const std::vector<boost::uint64_t>& ) const;
+            
+        private:
+            
+            /** number of bytes of a n-gram **/
+            const std::size_t m_ngram;
+            /** number of bins of the sketch **/
+            const std::size_t m_size;
+        
+    };
+    
+    
+    
+    /** constructor
+     * @param p_ngram number of bytes of a n-gram
+     * @param p_size number of bins of the sketch
+     **/
+    template<typename T> inline minhash<T>::minhash( const std::size_t& p_ngram, const std::size_t& p_size ) :
+        m_ngram( p_ngram ),
+        m_size( p_size )
+    {
+        if (!p_ngram)
+            throw exception::runtime(_("n-gram size must be greater than zero"), *this);
+        if (!p_size)
+            throw exception::runtime(_("sketch size must be greater than zero"), *this);
+    }
+    
+    
+    /** creates the sketch of the n-grams (data, that is shorter than a n-gram, is one n-gram)
+     * @param p_data data
+     * @param p_size number of bytes
+     * @return minimum hash value of each bin
+     **/
+    template<typename T> inline std::vector<boost::uint64_t> minhash<T>::create( const char* p_data, const std::size_t& p_size ) const
+    {
+        const boost::uint64_t l_empty = std::numeric_limits<boost::uint64_t>::max();
+        std::vector<boost::uint64_t> l_sketch( m_size, l_empty );
+        
+        const std::size_t l_ngram = std::min( m_ngram, p_size );
+        for(std::size_t i=0; i + l_ngram <= p_size; ++i) {
+            const boost::uint64_t l_hash = tools::function::mix( tools::function::fnv(p_data + i, l_ngram) );
+            
+            // the high bits select the bin, so the order within a bin is not dependent of the bin
+            const std::size_t l_bin = static_cast<std::size_t>( (l_hash >> 32) * m_size >> 32 );
+            l_sketch[l_bin] = std::min( l_sketch[l_bin], l_hash );
+        }
+        
+        // an empty bin gets the value of the next nonempty bin (circular) with an offset of the distance,
+        // so two sketches have the same value only if the next nonempty bins are equal
+        std::size_t l_next = m_size;
+        for(std::size_t i=0; (i < m_size) && (l_next == m_size); ++i)
+            if (l_sketch[i] != l_empty)
+                l_next = i;
+        
+        std::vector<boost::uint64_t> l_dense( l_sketch );
+        for(std::size_t i=m_size; i > 0; --i) {
+            const std::size_t l_bin = i - 1;
+            if (l_sketch[l_bin] != l_empty)
+                l_next = l_bin;
+            else
+                l_dense[l_bin] = tools::function::mix( l_sketch[l_next] + (l_next + m_size - l_bin) % m_size );
+        }
+        
+        return l_dense;
+    }
+    
+    
+    /** calculates the estimated Jaccard distance of two sketches (the fraction of the different bins)
+     * @param p_first first sketch
+     * @param p_second second sketch
+     * @return distance value
+     **/
+    template<typename T> inline T minhash<T>::distance( const std::vector<boost::uint64_t>& p_first, const std::vector<boost::uint64_t>& p_second ) const
+    {
+        std::size_t l_equal = 0;
+        for(std::size_t i=0; i < p_first.size(); ++i)
+            l_equal += (p_first[i] == p_second[i]) ? 1 : 0;
+        
+        return static_cast<T>(1) - static_cast<T>(l_equal) / static_cast<T>(p_first.size());
+    }
+    
+    
+}}
+#endif
@@ -27,29 +27,38 @@
 #define __MACHINELEARNING_DISTANCES_NCD_HPP
 
 #include <omp.h>
+#include <zlib.h>
+#include <bzlib.h>
+#include <map>
+#include <cmath>
+#include <limits>
 #include <string>
-#include <sstream>
-#include <iostream>
-#include <ostream>
-#include <fstream>
-
-#ifdef MACHINELEARNING_MPI
-#include <boost/mpi.hpp>
-#endif
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <functional>
 
+#include <boost/cstdint.hpp>
 #include <boost/static_assert.hpp>
 #include <boost/numeric/ublas/matrix.hpp>
 #include <boost/numeric/ublas/symmetric.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 
-#include <boost/iostreams/filter/gzip.hpp>
-#include <boost/iostreams/filter/bzip2.hpp>
-
-#include <boost/iostreams/stream.hpp>
-#include <boost/iostreams/device/null.hpp>
-#include <boost/iostreams/filtering_streambuf.hpp>
-#include <boost/iostreams/filter/counter.hpp>
+#ifdef MACHINELEARNING_COMPRESSION
+#include <zstd.h>
+#include <zdict.h>
+#include <lz4.h>
+#include <lz4hc.h>
+#include <lzma.h>
+#include <boost/shared_ptr.hpp>
+#endif
 
 #include "../errorhandling/exception.hpp"
+#include "../tools/function.hpp"
+#include "../tools/communication/communication.h"
+#ifdef MACHINELEARNING_FILES_HDF
+#include "../tools/files/hdf.hpp"
+#endif
 
 
 
@@ -59,15 +68,16 @@ namespace machinelearning { namespace distances {
     #ifndef SWIG
     namespace ublas = boost::numeric::ublas;
     namespace bio   = boost::iostreams;
-    #ifdef MACHINELEARNING_MPI
-    namespace mpi   = boost::mpi;
+    #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
+    namespace mpi   = machinelearning::tools::communication;
     #endif
     #endif
     
     
     /**
      * class for calculating the normalized compression distance (NCD)
-     * with some different algorithms like gzip and bzip2
+     * with some different algorithms like gzip and bzip2 (zstd, LZ4 and xz are
+     * available with the MACHINELEARNING_COMPRESSION flag)
      **/
     template<typename T> class ncd
     {
@@ -82,6 +92,12 @@ namespace machinelearning { namespace distances {
             {
                 gzip, 
                 bzip2
+                #ifdef MACHINELEARNING_COMPRESSION
+                ,
+                zstd,
+                lz4,
+                xz
+                #endif
             };
             
             enum compresslevel
@@ -91,30 +107,262 @@ namespace machinelearning { namespace distances {
                 bestcompression
             };
             
+            #ifndef SWIG
+            /** interface for receiving the distance blocks of the streaming calculation **/
+            class receiver
+            {
+                public :
+                
+                    /** receives a block of distances with the indices of the first row and column (the calls are serialized) **/
+                    virtual void receive( const std::size_t&, const std::size_t&, const ublas::matrix<T>& ) = 0;
+                    
+                    /** returns the number of rows and columns of the blocks (zero uses an automatic size, a fixed size
+                     * places the blocks on a fixed grid, so the blocks are equal on each calculation) **/
+                    virtual std::size_t getBlockSize( void ) const { return 0; }
+                    
+                    /** returns true if the block of the first row and column was received before, so the block is
+                     * not calculated again (the calls are serialized) **/
+                    virtual bool exists( const std::size_t&, const std::size_t& ) const { return false; }
+                
+                    /** destructor **/
+                    virtual ~receiver( void ) {}
+            };
+            
+            #ifdef MACHINELEARNING_FILES_HDF
+            /** receiver, that writes the blocks into a chunked matrix dataset of a HDF file, so the distance
+             * matrix must not fit into the memory. The blocks are aligned to the chunks and the finished blocks are
+             * marked by their first row and column block within a second dataset (path with suffix "_blocks"), so an
+             * interrupted calculation can be resumed with the same file, only the unfinished blocks are calculated again
+             **/
+            class hdfwriter : public receiver
+            {
+                public :
+                
+                    hdfwriter( tools::files::hdf&, const std::string&, const std::size_t&, const std::size_t&, const tools::files::hdf::datatype&, const bool& = false, const std::size_t& = 64 );
+                    void receive( const std::size_t&, const std::size_t&, const ublas::matrix<T>& );
+                    std::size_t getBlockSize( void ) const;
+                    bool exists( const std::size_t&, const std::size_t& ) const;
+                
+                private :
+                
+                    /** target file **/
+                    tools::files::hdf& m_file;
+                    /** path of the distance dataset **/
+                    const std::string m_path;
+                    /** path of the dataset with the finished blocks **/
+                    const std::string m_blockpath;
+                    /** datatype of the distances **/
+                    const tools::files::hdf::datatype m_datatype;
+                    /** the blocks of the upper triangle are mirrored **/
+                    const bool m_symmetric;
+                    /** number of rows and columns of a block **/
+                    const std::size_t m_blocksize;
+            };
+            #endif
+            #endif
+            
             
             ncd ( void );
             ncd ( const compresstype& );
+            virtual ~ncd( void ) {}
             ublas::matrix<T> unsquare ( const std::vector<std::string>&, const std::vector<std::string>&, const bool& = false ) const;
             ublas::matrix<T> unsymmetric ( const std::vector<std::string>&, const bool& = false ) const;
             ublas::symmetric_matrix<T, ublas::upper> symmetric ( const std::vector<std::string>&, const bool& = false ) const;
             T calculate ( const std::string&, const std::string&, const bool& = false ) const;
             void setCompressionLevel( const compresslevel& = defaultcompression );
             
-            #ifdef MACHINELEARNING_MPI
+            #ifndef SWIG
+            void unsquare ( const std::vector<std::string>&, const std::vector<std::string>&, receiver&, const bool& = false ) const;
+            void unsymmetric ( const std::vector<std::string>&, receiver&, const bool& = false ) const;
+            void symmetric ( const std::vector<std::string>&, receiver&, const bool& = false ) const;
+            #endif
+            
+            void setCaching( const bool& );
+            void clearCache( void );
+            
+            #ifdef MACHINELEARNING_COMPRESSION
+            void trainDictionary( const std::vector<std::string>&, const bool& = false, const std::size_t& = 112640 );
+            #endif
+            
+            #ifdef MACHINELEARNING_FILES_HDF
+            void loadCache( const std::string& );
+            void saveCache( const std::string& ) const;
+            #endif
+            
+            #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
             ublas::matrix<T> unsquare ( const mpi::communicator&, const std::vector<std::string>&, const bool& = false ) const;
+            #ifndef SWIG
+            void unsquare ( const mpi::communicator&, const std::vector<std::string>&, receiver&, const bool& = false ) const;
+            #endif
             #endif
             
+        protected:
+            
+            virtual T measure( const std::size_t&, const std::size_t&, const std::size_t& ) const;
+            
         private:
             
+            #ifndef SWIG
+            /** compression state of one thread, the zlib stream and the output buffer are reused
+             * on every call, the compressed data is not stored, only the bytes are counted. The
+             * state can be primed with a first data, so the compression of the first data is
+             * reused for every second data (the zlib state is copied into a preallocated arena,
+             * zstd, LZ4 and xz compress the primed data once and use it as dictionary)
+             **/
+            class compressor
+            {
+                public :
+                
+                    compressor( const ncd<T>& );
+                    ~compressor( void );
+                    void prime( const char*, const std::size_t& );
+                    std::size_t deflate( const char*, const std::size_t& );
+                    std::size_t deflate( const char*, const std::size_t&, const char*, const std::size_t& );
+                
+                private :
+                
+                    /** compression algorithm **/
+                    const compresstype m_compress;
+                    /** compression level of bzip2 (block size) **/
+                    const int m_bzip2level;
+                    /** zlib stream, that holds the primed data **/
+                    z_stream m_zlib;
+                    /** zlib stream, that is copied of the primed stream **/
+                    z_stream m_copy;
+                    /** memory of both zlib streams **/
+                    std::vector<char> m_arena;
+                    /** current position within the arena **/
+                    std::size_t m_arenaposition;
+                    /** arena position of the copied stream **/
+                    std::size_t m_arenacopy;
+                    /** minimal size of the primed data, that the zlib state is copied or the primed data is used as dictionary **/
+                    const std::size_t m_copysize;
+                    /** primed data (bzip2 can not be primed, so the data is compressed on each call) **/
+                    const char* m_data;
+                    /** size of the primed data **/
+                    std::size_t m_size;
+                    /** compressed size of the primed data for the dictionary based algorithms (zero if it is not compressed) **/
+                    std::size_t m_primedsize;
+                    /** output buffer **/
+                    std::vector<char> m_buffer;
+                    
+                    #ifdef MACHINELEARNING_COMPRESSION
+                    /** compression level of zstd, acceleration of LZ4 (zero uses LZ4 HC) **/
+                    const int m_level;
+                    /** zstd context, the dictionary and the parameters are kept on reset **/
+                    ZSTD_CCtx* m_zstd;
+                    /** trained dictionary of zstd **/
+                    const ZSTD_CDict* m_dictionary;
+                    /** zstd dictionary of the primed data **/
+                    ZSTD_CDict* m_zstdprimed;
+                    /** LZ4 stream **/
+                    LZ4_stream_t* m_lz4;
+                    /** LZ4 HC stream **/
+                    LZ4_streamHC_t* m_lz4hc;
+                    /** xz stream **/
+                    lzma_stream m_lzma;
+                    /** LZMA2 options of the xz preset **/
+                    lzma_options_lzma m_lzmaoptions;
+                    
+                    std::size_t compressZstd( const char*, const std::size_t&, const ZSTD_EndDirective& );
+                    std::size_t compressLz4( const char*, const std::size_t& );
+                    void compressLzma( const char*, const std::size_t&, const lzma_action& );
+                    #endif
+                
+                    void compressZlib( z_stream&, const char*, const std::size_t&, const int& );
+                    void compressBzip2( bz_stream&, const char*, const std::size_t&, const int& );
+                    static voidpf allocate( voidpf, uInt, uInt );
+                    static void release( voidpf, voidpf );
+                
+                    compressor( const compressor& );
+                    compressor& operator=( const compressor& );
+            };
+            
+            
+            /** elements of one side of the pair computation **/
+            struct elements
+            {
+                /** strings or filenames **/
+                const std::vector<std::string>& data;
+                /** compressed size of every element **/
+                const ublas::vector<std::size_t>& size;
+                /** content hash of every element (empty without cache) **/
+                const std::vector<boost::uint64_t>& hash;
+            };
+            
+            
+            /** traversal of the pairs **/
+            enum traversal
+            {
+                /** all pairs **/
+                full,
+                /** all pairs, the diagonal is zero **/
+                diagonal,
+                /** blocks of the upper triangle with the mean of both concatenation orders **/
+                triangle
+            };
+            
+            
+            /** receiver, that copies the blocks into a matrix **/
+            template<typename M> class assign : public receiver
+            {
+                public :
+                
+                    assign( M& );
+                    void receive( const std::size_t&, const std::size_t&, const ublas::matrix<T>& );
+                
+                private :
+                
+                    /** target matrix **/
+                    M& m_matrix;
+            };
+            
+            
+            /** key of a cached pair (ordered content hashes) **/
+            typedef std::pair<boost::uint64_t, boost::uint64_t> pairkey;
+            #endif
+            
+            
             /** type for internal compression state **/
             const compresstype m_compress;
-            /** parameter for gzip **/
-            bio::gzip_params m_gzipparam;
-            /** parameter for bzip2 **/
-            bio::bzip2_params m_bzip2param;
+            /** compression level of gzip **/
+            int m_gziplevel;
+            /** compression level of bzip2 (block size) **/
+            int m_bzip2level;
+            
+            #ifdef MACHINELEARNING_COMPRESSION
+            /** compression level of zstd **/
+            int m_zstdlevel;
+            /** acceleration of LZ4 (zero uses LZ4 HC with the maximum level) **/
+            int m_lz4acceleration;
+            /** preset of xz **/
+            uint32_t m_xzlevel;
+            /** trained dictionary of zstd **/
+            boost::shared_ptr<ZSTD_CDict> m_dictionary;
+            /** hash of the trained dictionary **/
+            boost::uint64_t m_dictionaryhash;
+            #endif
+            
+            /** flag for using the cache **/
+            bool m_caching;
+            /** cache of the compressed sizes of single elements (key is the content hash) **/
+            mutable std::map<boost::uint64_t, std::size_t> m_singlecache;
+            /** cache of the compressed sizes of concatenations (key is the ordered pair of the content hashes) **/
+            mutable std::map< std::pair<boost::uint64_t, boost::uint64_t>, std::size_t > m_paircache;
+            /** maximum number of rows and columns of a block **/
+            const std::size_t m_blocksize;
             
-            std::size_t deflate ( const bool&, const std::string&, const std::string& = "" ) const;        
-            std::multimap<std::size_t, std::pair<std::size_t,std::size_t> > getWavefrontIndex( const std::size_t&, const std::size_t& ) const;
+            #ifndef SWIG
+            std::pair<const char*, std::size_t> source( const bool&, const std::string&, bio::mapped_file_source& ) const;
+            std::size_t deflate ( compressor&, const bool&, const std::string&, const std::string& = "" ) const;
+            ublas::vector<std::size_t> deflate ( const std::vector<std::string>&, const std::vector<boost::uint64_t>&, const bool& ) const;
+            std::vector<boost::uint64_t> hash( const std::vector<std::string>&, const bool& ) const;
+            boost::uint64_t configuration( void ) const;
+            void blocks( const elements&, const elements&, const bool&, const traversal&, receiver&, const std::size_t& = 0 ) const;
+            void pairs( compressor&, const elements&, const ublas::range&, const elements&, const ublas::range&, const bool&, const bool&, ublas::matrix<T>&, std::vector< std::pair<pairkey, std::size_t> >& ) const;
+            static void failure( std::string&, const std::string& );
+            static bool failed( const std::string& );
+            #endif
     };
     
     
@@ -123,8 +371,19 @@ namespace machinelearning { namespace distances {
     /** default constructor **/
     template<typename T> inline ncd<T>::ncd( void ) :
         m_compress ( gzip ),
-        m_gzipparam( bio::gzip::default_compression ),
-        m_bzip2param( 6 )
+        m_gziplevel( Z_DEFAULT_COMPRESSION ),
+        m_bzip2level( 6 ),
+        #ifdef MACHINELEARNING_COMPRESSION
+        m_zstdlevel( 3 ),
+        m_lz4acceleration( 1 ),
+        m_xzlevel( 6 ),
+        m_dictionary(),
+        m_dictionaryhash( 0 ),
+        #endif
+        m_caching( false ),
+        m_singlecache(),
+        m_paircache(),
+        m_blocksize( 64 )
     {}
     
     
@@ -133,31 +392,22 @@ namespace machinelearning { namespace distances {
      **/
     template<typename T> inline ncd<T>::ncd( const compresstype& p_compress ) :
         m_compress ( p_compress ),
-        m_gzipparam( bio::gzip::default_compression ),
-        m_bzip2param( 6 )
+        m_gziplevel( Z_DEFAULT_COMPRESSION ),
+        m_bzip2level( 6 ),
+        #ifdef MACHINELEARNING_COMPRESSION
+        m_zstdlevel( 3 ),
+        m_lz4acceleration( 1 ),
+        m_xzlevel( 6 ),
+        m_dictionary(),
+        m_dictionaryhash( 0 ),
+        #endif
+        m_caching( false ),
+        m_singlecache(),
+        m_paircache(),
+        m_blocksize( 64 )
     {}
     
     
-    /** creates wavefront index pairs for using on multithreaded systems
-     * @param p_size number of rows or columns
-     * @param p_threads number of threads
-     * @return map with indices
-     **/
-    template<typename T> inline std::multimap<std::size_t, std::pair<std::size_t,std::size_t> > ncd<T>::getWavefrontIndex( const std::size_t& p_size, const std::size_t& p_threads ) const
-    {
-        std::multimap<std::size_t, std::pair<std::size_t,std::size_t> > l_wavefront;
-        
-        // create wavefront in this case: (0,n) = 0, (0,n-1) = 1, (1,n) = 2 ...
-        // we must create only the upper or lower index position, the other one can be created of swapping the index position
-        std::size_t n=0;
-        for(std::size_t i=1; i < p_size; ++i)
-            for(std::size_t j=0; (i+j) < p_size; ++j)
-                l_wavefront.insert(  std::pair<std::size_t, std::pair<std::size_t,std::size_t> >(n++ % p_threads, std::pair<std::size_t,std::size_t>(j,i+j))  );
-            
-        return l_wavefront;
-    }
-    
-      
     /** sets the compression level
      * @param  p_level compression level
      **/
@@ -166,23 +416,178 @@ namespace machinelearning { namespace distances {
         switch (p_level) 
         {
             case defaultcompression :   
-                m_gzipparam     = bio::gzip_params( bio::gzip::default_compression );
-                m_bzip2param    = bio::bzip2_params( 6 );
+                m_gziplevel     = Z_DEFAULT_COMPRESSION;
+                m_bzip2level    = 6;
+                #ifdef MACHINELEARNING_COMPRESSION
+                m_zstdlevel         = 3;
+                m_lz4acceleration   = 1;
+                m_xzlevel           = 6;
+                #endif
                 break;
                 
             case bestspeed          :   
-                m_gzipparam     = bio::gzip_params( bio::gzip::best_speed );
-                m_bzip2param    = bio::bzip2_params( 1 );
+                m_gziplevel     = Z_BEST_SPEED;
+                m_bzip2level    = 1;
+                #ifdef MACHINELEARNING_COMPRESSION
+                m_zstdlevel         = 1;
+                m_lz4acceleration   = 8;
+                m_xzlevel           = 0;
+                #endif
                 break;
                 
             case bestcompression    :   
-                m_gzipparam     = bio::gzip_params( bio::gzip::best_compression );
-                m_bzip2param    = bio::bzip2_params( 9 );
+                m_gziplevel     = Z_BEST_COMPRESSION;
+                m_bzip2level    = 9;
+                #ifdef MACHINELEARNING_COMPRESSION
+                m_zstdlevel         = 19;
+                m_lz4acceleration   = 0;
+                m_xzlevel           = 9;
+                #endif
                 break;
         }
     }
     
     
+    #ifdef MACHINELEARNING_COMPRESSION
+    
+    /** trains a zstd dictionary of a sample of the data, the dictionary is used on each compression,
+     * so the data is not compressed against an empty history. The dictionary is created with the
+     * current compression level, so the level should be set before
+     * @param p_sample sample strings
+     * @param p_isfile parameter for interpreting the string as a file with path
+     * @param p_size maximum size of the dictionary in bytes
+     **/
+    template<typename T> inline void ncd<T>::trainDictionary( const std::vector<std::string>& p_sample, const bool& p_isfile, const std::size_t& p_size )
+    {
+        if (m_compress != zstd)
+            throw exception::runtime(_("dictionary can be used with zstd only"), *this);
+        if (p_sample.size() == 0)
+            throw exception::runtime(_("vector size must be greater than zero"), *this);
+        if (p_size == 0)
+            throw exception::runtime(_("dictionary size must be greater than zero"), *this);
+        
+        // the trainer needs the concatenated samples and the size of each sample
+        std::string l_samples;
+        std::vector<std::size_t> l_samplesize(p_sample.size());
+        for(std::size_t i=0; i < p_sample.size(); ++i) {
+            bio::mapped_file_source l_file;
+            const std::pair<const char*, std::size_t> l_data = source(p_isfile, p_sample[i], l_file);
+            
+            l_samples.append( l_data.first, l_data.second );
+            l_samplesize[i] = l_data.second;
+        }
+        
+        std::vector<char> l_dictionary(p_size);
+        const std::size_t l_size = ZDICT_trainFromBuffer( &l_dictionary[0], l_dictionary.size(), l_samples.data(), &l_samplesize[0], static_cast<unsigned int>(l_samplesize.size()) );
+        if (ZDICT_isError(l_size))
+            throw exception::runtime(_("dictionary can not be trained"), *this);
+        
+        ZSTD_CDict* const l_compressdictionary = ZSTD_createCDict( &l_dictionary[0], l_size, m_zstdlevel );
+        if (!l_compressdictionary)
+            throw exception::runtime(_("dictionary can not be created"), *this);
+        
+        m_dictionary     = boost::shared_ptr<ZSTD_CDict>( l_compressdictionary, ZSTD_freeCDict );
+        m_dictionaryhash = tools::function::fnv( &l_dictionary[0], l_size );
+    }
+    
+    #endif
+    
+    
+    /** enables or disables the cache of the compressed sizes. The cache is keyed by a 64 bit hash
+     * of the content and of the compression configuration, so only new elements and new pairs are
+     * compressed on the next calls. The cache is filled by the matrix functions, an object with
+     * enabled cache must not be used by concurrent calls
+     * @param p_caching enables / disables the cache
+     **/
+    template<typename T> inline void ncd<T>::setCaching( const bool& p_caching )
+    {
+        m_caching = p_caching;
+    }
+    
+    
+    /** removes all cached compression sizes **/
+    template<typename T> inline void ncd<T>::clearCache( void )
+    {
+        m_singlecache.clear();
+        m_paircache.clear();
+    }
+    
+    
+    #ifdef MACHINELEARNING_FILES_HDF
+    
+    /** loads cached compression sizes of a HDF file and enables the cache, the
+     * entries are merged into the current cache
+     * @param p_file filename
+     **/
+    template<typename T> inline void ncd<T>::loadCache( const std::string& p_file )
+    {
+        m_caching = true;
+        
+        const tools::files::hdf l_file( p_file );
+        
+        if (l_file.pathexists("/single/key")) {
+            const std::vector<boost::uint64_t> l_key  = l_file.readStdVector<boost::uint64_t>( "/single/key", tools::files::hdf::NATIVE_UINT64 );
+            const std::vector<boost::uint64_t> l_size = l_file.readStdVector<boost::uint64_t>( "/single/size", tools::files::hdf::NATIVE_UINT64 );
+            if (l_key.size() != l_size.size())
+                throw exception::runtime(_("cache file is not consistent"), *this);
+            
+            for(std::size_t i=0; i < l_key.size(); ++i)
+                m_singlecache[l_key[i]] = static_cast<std::size_t>(l_size[i]);
+        }
+        
+        if (l_file.pathexists("/pair/first")) {
+            const std::vector<boost::uint64_t> l_first  = l_file.readStdVector<boost::uint64_t>( "/pair/first", tools::files::hdf::NATIVE_UINT64 );
+            const std::vector<boost::uint64_t> l_second = l_file.readStdVector<boost::uint64_t>( "/pair/second", tools::files::hdf::NATIVE_UINT64 );
+            const std::vector<boost::uint64_t> l_size   = l_file.readStdVector<boost::uint64_t>( "/pair/size", tools::files::hdf::NATIVE_UINT64 );
+            if ( (l_first.size() != l_second.size()) || (l_first.size() != l_size.size()) )
+                throw exception::runtime(_("cache file is not consistent"), *this);
+            
+            for(std::size_t i=0; i < l_first.size(); ++i)
+                m_paircache[ std::pair<boost::uint64_t, boost::uint64_t>(l_first[i], l_second[i]) ] = static_cast<std::size_t>(l_size[i]);
+        }
+    }
+    
+    
+    /** writes the cached compression sizes into a HDF file (the file is overwritten)
+     * @param p_file filename
+     **/
+    template<typename T> inline void ncd<T>::saveCache( const std::string& p_file ) const
+    {
+        const tools::files::hdf l_file( p_file, true );
+        
+        if (!m_singlecache.empty()) {
+            std::vector<boost::uint64_t> l_key, l_size;
+            l_key.reserve( m_singlecache.size() );
+            l_size.reserve( m_singlecache.size() );
+            for(std::map<boost::uint64_t, std::size_t>::const_iterator it = m_singlecache.begin(); it != m_singlecache.end(); ++it) {
+                l_key.push_back( it->first );
+                l_size.push_back( it->second );
+            }
+            
+            l_file.writeStdVector<boost::uint64_t>( "/single/key", l_key, tools::files::hdf::NATIVE_UINT64 );
+            l_file.writeStdVector<boost::uint64_t>( "/single/size", l_size, tools::files::hdf::NATIVE_UINT64 );
+        }
+        
+        if (!m_paircache.empty()) {
+            std::vector<boost::uint64_t> l_first, l_second, l_size;
+            l_first.reserve( m_paircache.size() );
+            l_second.reserve( m_paircache.size() );
+            l_size.reserve( m_paircache.size() );
+            for(typename std::map< std::pair<boost::uint64_t, boost::uint64_t>, std::size_t >::const_iterator it = m_paircache.begin(); it != m_paircache.end(); ++it) {
+                l_first.push_back( it->first.first );
+                l_second.push_back( it->first.second );
+                l_size.push_back( it->second );
+            }
+            
+            l_file.writeStdVector<boost::uint64_t>( "/pair/first", l_first, tools::files::hdf::NATIVE_UINT64 );
+            l_file.writeStdVector<boost::uint64_t>( "/pair/second", l_second, tools::files::hdf::NATIVE_UINT64 );
+            l_file.writeStdVector<boost::uint64_t>( "/pair/size", l_size, tools::files::hdf::NATIVE_UINT64 );
+        }
+    }
+    
+    #endif
+    
+    
     
     /** calculate distances between two strings
      * @param p_str1 first string
@@ -192,10 +597,24 @@ namespace machinelearning { namespace distances {
      **/   
     template<typename T> inline T ncd<T>::calculate( const std::string& p_str1, const std::string& p_str2, const bool& p_isfile ) const
     {
-        const std::size_t l_first  = deflate(p_isfile, p_str1);
-        const std::size_t l_second = deflate(p_isfile, p_str2);
+        compressor l_compressor( *this );
         
-        return std::min( static_cast<T>(1),     static_cast<T>(deflate(p_isfile, p_str1, p_str2) - std::min(l_first, l_second)) / std::max(l_first, l_second) );
+        const std::size_t l_first  = deflate(l_compressor, p_isfile, p_str1);
+        const std::size_t l_second = deflate(l_compressor, p_isfile, p_str2);
+        
+        return std::min( static_cast<T>(1), measure(deflate(l_compressor, p_isfile, p_str1, p_str2), l_first, l_second) );
+    }
+    
+    
+    /** calculates the distance of the compressed sizes
+     * @param p_pair compressed size of the concatenation
+     * @param p_first compressed size of the first element
+     * @param p_second compressed size of the second element
+     * @return (unbounded) distance value
+     **/
+    template<typename T> inline T ncd<T>::measure( const std::size_t& p_pair, const std::size_t& p_first, const std::size_t& p_second ) const
+    {
+        return (static_cast<T>(p_pair) - static_cast<T>(std::min(p_first, p_second))) / static_cast<T>(std::max(p_first, p_second));
     }
     
     
@@ -208,60 +627,10 @@ namespace machinelearning { namespace distances {
      **/
     template<typename T> inline ublas::matrix<T> ncd<T>::unsymmetric( const std::vector<std::string>& p_strvec, const bool& p_isfile  ) const
     {
-        if (p_strvec.size() == 0)
-            throw exception::runtime(_("vector size must be greater than zero"), *this);
-        
-        // init data
-        ublas::vector<std::size_t> l_cache(p_strvec.size(), 0);
-        ublas::matrix<T> l_result(p_strvec.size(), p_strvec.size(), static_cast<T>(0));
-        
-        // the first and last element are calculated in a single run, because
-        // the first two thread are used the data directly
-        l_cache(0)                 = deflate(p_isfile, p_strvec[0]);
-        l_cache(p_strvec.size()-1) = deflate(p_isfile, p_strvec[p_strvec.size()-1]);
-        
-        // create wavefront index position
-        std::multimap<std::size_t, std::pair<std::size_t,std::size_t> > l_wavefront = getWavefrontIndex(p_strvec.size(), omp_get_max_threads());
-        
-        #pragma omp parallel shared(l_cache, l_result)
-        {
-            for(std::multimap<std::size_t, std::pair<std::size_t,std::size_t> >::iterator it=l_wavefront.lower_bound(omp_get_thread_num()); it != l_wavefront.upper_bound(omp_get_thread_num()); ++it) {
-                
-                // read cache data
-                std::size_t l_first=0, l_second=0;
-                
-                #pragma omp critical
-                {
-                    l_first  = l_cache(it->second.first);
-                    l_second = l_cache(it->second.second);
-                }
-                
-                // check for both index positions the cache and adds the data
-                if (l_first == 0) {
-                    l_first = deflate(p_isfile, p_strvec[it->second.first]);
-                    
-                    #pragma omp critical
-                    l_cache(it->second.first) = l_first;
-                }
-                
-                if (l_second == 0) {
-                    l_second = deflate(p_isfile, p_strvec[it->second.second]);
-                    
-                    #pragma omp critical 
-                    l_cache(it->second.second) = l_second;
-                }
-                
-                
-                // determin min and max
-                const std::size_t l_min = std::min(l_first, l_second);
-                const std::size_t l_max = std::max(l_first, l_second);
-                
-                // calculate NCD
-                l_result(it->second.first, it->second.second) = std::min( static_cast<T>(1), static_cast<T>(deflate(p_isfile, p_strvec[it->second.first], p_strvec[it->second.second]) - l_min) / l_max );
-                l_result(it->second.second, it->second.first) = std::min( static_cast<T>(1), static_cast<T>(deflate(p_isfile, p_strvec[it->second.second], p_strvec[it->second.first]) - l_min) / l_max );
-            }
-        }
+        ublas::matrix<T> l_result(p_strvec.size(), p_strvec.size());
+        assign< ublas::matrix<T> > l_assign(l_result);
         
+        unsymmetric(p_strvec, l_assign, p_isfile);
         return l_result;
     }
     
@@ -274,69 +643,11 @@ namespace machinelearning { namespace distances {
      **/
     template<typename T> inline ublas::symmetric_matrix<T, ublas::upper> ncd<T>::symmetric( const std::vector<std::string>& p_strvec, const bool& p_isfile  ) const
     {
-         if (p_strvec.size() == 0)
-             throw exception::runtime(_("vector size must be greater than zero"), *this);
-         
-         // init data
-         ublas::vector<std::size_t> l_cache(p_strvec.size(), 0);
-         ublas::symmetric_matrix<T, ublas::upper> l_result(p_strvec.size(), p_strvec.size());
-        
-        // the first and last element are calculated in a single run, because
-        // the first two thread are used the data directly
-        l_cache(0)                 = deflate(p_isfile, p_strvec[0]);
-        l_cache(p_strvec.size()-1) = deflate(p_isfile, p_strvec[p_strvec.size()-1]);
-        
-        // create wavefront index position
-        std::multimap<std::size_t, std::pair<std::size_t,std::size_t> > l_wavefront = getWavefrontIndex(p_strvec.size(), omp_get_max_threads());
-        
-        #pragma omp parallel shared(l_cache, l_result)
-        {
-            for(std::multimap<std::size_t, std::pair<std::size_t,std::size_t> >::iterator it=l_wavefront.lower_bound(omp_get_thread_num()); it != l_wavefront.upper_bound(omp_get_thread_num()); ++it) {
-                
-                // read cache data
-                std::size_t l_first=0, l_second=0;
-                
-                #pragma omp critical
-                {
-                    l_first  = l_cache(it->second.first);
-                    l_second = l_cache(it->second.second);
-                }
-                
-                // check for both index positions the cache and adds the data
-                if (l_first == 0) {
-                    l_first = deflate(p_isfile, p_strvec[it->second.first]);
-                    
-                    #pragma omp critical
-                    l_cache(it->second.first) = l_first;
-                }
-                
-                if (l_second == 0) {
-                    l_second = deflate(p_isfile, p_strvec[it->second.second]);
-                    
-                    #pragma omp critical 
-                    l_cache(it->second.second) = l_second;
-                }
-                
-                
-                // determin min and max
-                const std::size_t l_min = std::min(l_first, l_second);
-                const std::size_t l_max = std::max(l_first, l_second);
-                
-                // calculate NCD
-                l_result(it->second.first, it->second.second) = std::min( static_cast<T>(1),
-                             0.5 * (static_cast<T>(deflate(p_isfile, p_strvec[it->second.first], p_strvec[it->second.second]) - l_min) / l_max + 
-                                    static_cast<T>(deflate(p_isfile, p_strvec[it->second.second], p_strvec[it->second.first]) - l_min) / l_max)
-                             );
-
-            }
-        }
+        ublas::symmetric_matrix<T, ublas::upper> l_result(p_strvec.size(), p_strvec.size());
+        assign< ublas::symmetric_matrix<T, ublas::upper> > l_assign(l_result);
         
-         // we set the diagonal elements to zero, because constructor has no parameter for initialization value
-         #pragma omp for
-         for(std::size_t i=0; i < l_result.size1(); ++i)
-             l_result(i,i) = static_cast<T>(0);
-         
-         return l_result;
+        symmetric(p_strvec, l_assign, p_isfile);
+        return l_result;
     }
     
     
@@ -347,208 +658,1192 @@ namespace machinelearning { namespace distances {
      * @return dissimilarity matrix with std::vector1 x std::vector2 elements (deflating order: element first vector concat with element second vector )
      **/
     template<typename T> inline ublas::matrix<T> ncd<T>::unsquare( const std::vector<std::string>& p_strvec1, const std::vector<std::string>& p_strvec2, const bool& p_isfile ) const
+    {
+        ublas::matrix<T> l_result(p_strvec1.size(), p_strvec2.size());
+        assign< ublas::matrix<T> > l_assign(l_result);
+        
+        unsquare(p_strvec1, p_strvec2, l_assign, p_isfile);
+        return l_result;
+    }
+    
+    
+    /** calculate all distances of the string vector and passes the finished blocks to the receiver,
+     * so the matrix must not be stored
+     * @param p_strvec string vector
+     * @param p_receiver receiver of the blocks
+     * @param p_isfile parameter for interpreting the string as a file with path
+     **/
+    template<typename T> inline void ncd<T>::unsymmetric( const std::vector<std::string>& p_strvec, receiver& p_receiver, const bool& p_isfile  ) const
+    {
+        if (p_strvec.size() == 0)
+            throw exception::runtime(_("vector size must be greater than zero"), *this);
+        
+        const std::vector<boost::uint64_t> l_hash = hash(p_strvec, p_isfile);
+        const ublas::vector<std::size_t> l_cache  = deflate(p_strvec, l_hash, p_isfile);
+        const elements l_elements                 = { p_strvec, l_cache, l_hash };
+        
+        blocks( l_elements, l_elements, p_isfile, diagonal, p_receiver );
+    }
+    
+    
+    /** calculate all distances of the string vector and passes the finished blocks of the upper
+     * triangle (the blocks of the diagonal are complete) to the receiver, so the matrix must not be stored
+     * @param p_strvec string vector
+     * @param p_receiver receiver of the blocks
+     * @param p_isfile parameter for interpreting the string as a file with path
+     **/
+    template<typename T> inline void ncd<T>::symmetric( const std::vector<std::string>& p_strvec, receiver& p_receiver, const bool& p_isfile  ) const
+    {
+        if (p_strvec.size() == 0)
+            throw exception::runtime(_("vector size must be greater than zero"), *this);
+        
+        const std::vector<boost::uint64_t> l_hash = hash(p_strvec, p_isfile);
+        const ublas::vector<std::size_t> l_cache  = deflate(p_strvec, l_hash, p_isfile);
+        const elements l_elements                 = { p_strvec, l_cache, l_hash };
+        
+        blocks( l_elements, l_elements, p_isfile, triangle, p_receiver );
+    }
+    
+    
+    /** calculate all distances between each element of both string vectors and passes the finished
+     * blocks to the receiver, so the matrix must not be stored
+     * @param p_strvec1 string vector
+     * @param p_strvec2 string vector
+     * @param p_receiver receiver of the blocks
+     * @param p_isfile parameter for interpreting the string as a file with path
+     **/
+    template<typename T> inline void ncd<T>::unsquare( const std::vector<std::string>& p_strvec1, const std::vector<std::string>& p_strvec2, receiver& p_receiver, const bool& p_isfile ) const
     {
         if ( (p_strvec1.size() == 0) || (p_strvec2.size() == 0) )
             throw exception::runtime(_("vector size must be greater than zero"), *this);
         
-        // init data
-        ublas::vector<std::size_t> l_cache(p_strvec1.size() + p_strvec2.size(), 0);
-        ublas::matrix<T> l_result( p_strvec1.size(), p_strvec2.size() );
+        const std::vector<boost::uint64_t> l_hash1 = hash(p_strvec1, p_isfile);
+        const std::vector<boost::uint64_t> l_hash2 = hash(p_strvec2, p_isfile);
+        const ublas::vector<std::size_t> l_cache1  = deflate(p_strvec1, l_hash1, p_isfile);
+        const ublas::vector<std::size_t> l_cache2  = deflate(p_strvec2, l_hash2, p_isfile);
+        const elements l_rows                      = { p_strvec1, l_cache1, l_hash1 };
+        const elements l_columns                   = { p_strvec2, l_cache2, l_hash2 };
+        
+        blocks( l_rows, l_columns, p_isfile, full, p_receiver );
+    }
+    
     
-        // we create the map for threads (on the contrary to wavefront we cut patches for each thread, because we must calculate each element without any topographical order)
-        // The map element has in the std::pair within the first position the index of the first vector
-        std::multimap<std::size_t, std::pair<std::size_t,std::size_t> > l_map;
+    /** calculates the distances in blocks of row and column elements. A block is computed by one thread, so only the
+     * elements of the block are used and the mapped column elements are reused for each row element. The row blocks are
+     * sorted descending by their estimated costs (compressed sizes), so the dynamic schedule starts with the expensive
+     * blocks, and the blocks of a row block are enumerated by the index of the loop, so the schedule needs only the
+     * order of the row blocks. The block size is reduced, so that each thread gets at least four blocks, if the
+     * receiver does not fix the block size. The row blocks are aligned to the row index within the whole matrix,
+     * so the blocks of a row offset are on the same grid as the blocks of the whole matrix
+     * @param p_rows row elements (first part of the concatenation)
+     * @param p_columns column elements (second part of the concatenation)
+     * @param p_isfile parameter for interpreting the string as a file with path
+     * @param p_traversal traversal of the pairs
+     * @param p_receiver receiver of the bounded distance blocks
+     * @param p_rowoffset index of the first row element within the matrix (only for full and diagonal traversal)
+     **/
+    template<typename T> inline void ncd<T>::blocks( const elements& p_rows, const elements& p_columns, const bool& p_isfile, const traversal& p_traversal, receiver& p_receiver, const std::size_t& p_rowoffset ) const
+    {
+        const std::size_t l_threads   = static_cast<std::size_t>(omp_get_max_threads());
+        const std::size_t l_blocks    = (p_traversal == triangle ? 8 : 4) * l_threads;
+        const std::size_t l_blocksize = p_receiver.getBlockSize() ? p_receiver.getBlockSize() : std::max( static_cast<std::size_t>(1), std::min( m_blocksize, static_cast<std::size_t>(std::sqrt( static_cast<double>(p_rows.data.size() * p_columns.data.size()) / l_blocks )) ) );
+        
+        // the first row block is shortened by the shift of the grid
+        const std::size_t l_shift        = p_rowoffset % l_blocksize;
+        const std::size_t l_rowblocks    = (p_rows.data.size() + l_shift + l_blocksize - 1) / l_blocksize;
+        const std::size_t l_columnblocks = (p_columns.data.size() + l_blocksize - 1) / l_blocksize;
+        
+        // costs of the row blocks (each pair costs the compression of both elements)
+        std::size_t l_columnsum = 0;
+        for(std::size_t j=0; j < p_columns.size.size(); ++j)
+            l_columnsum += p_columns.size(j);
+        
+        std::vector< std::pair<std::size_t, std::size_t> > l_order(l_rowblocks, std::pair<std::size_t, std::size_t>(0, 0));
+        for(std::size_t i=0; i < p_rows.size.size(); ++i) {
+            l_order[(i + l_shift) / l_blocksize].first  += p_rows.size(i) * p_columns.size.size() + l_columnsum;
+            l_order[(i + l_shift) / l_blocksize].second  = (i + l_shift) / l_blocksize;
+        }
+        std::sort( l_order.begin(), l_order.end(), std::greater< std::pair<std::size_t, std::size_t> >() );
+        
+        // first loop index of each row block (the triangle uses only the column blocks behind the row block)
+        std::vector<std::size_t> l_offset(l_rowblocks+1, 0);
+        for(std::size_t i=0; i < l_rowblocks; ++i)
+            l_offset[i+1] = l_offset[i] + (p_traversal == triangle ? l_columnblocks - l_order[i].second : l_columnblocks);
         
-        #pragma omp parallel shared(l_map, l_cache, l_result)
+        // exceptions can not leave the parallel region, so the first error is stored and thrown after the region
+        std::string l_error;
+        
+        #pragma omp parallel shared(l_error)
         {
-            if (p_strvec1.size() < p_strvec2.size())
-                
-                #pragma omp for
-                for(std::size_t j=0; j < p_strvec1.size(); ++j)
-                    for(std::size_t i=0; i < p_strvec2.size(); ++i)
-                        
-                        #pragma omp critical
-                        l_map.insert(  std::pair<std::size_t, std::pair<std::size_t,std::size_t> >(i % omp_get_max_threads(), std::pair<std::size_t,std::size_t>(j,i))  );
+            compressor* l_compressor = NULL;
+            ublas::matrix<T> l_block;
+            ublas::matrix<T> l_transposed;
+            std::vector< std::pair<pairkey, std::size_t> > l_newpairs;
+            
+            try {
+                l_compressor = new compressor( *this );
+            } catch (const std::exception& e) {
+                failure( l_error, e.what() );
+            } catch (...) {
+                failure( l_error, _("unknown error on creating the compressor") );
+            }
             
-            else
+            #pragma omp for schedule(dynamic)
+            for(std::size_t n=0; n < l_offset.back(); ++n) {
+                if (failed(l_error))
+                    continue;
                 
-                #pragma omp for
-                for(std::size_t j=0; j < p_strvec2.size(); ++j)
-                    for(std::size_t i=0; i < p_strvec1.size(); ++i)
+                try {
+                    // determine the row and column block of the loop index
+                    const std::size_t l_position    = static_cast<std::size_t>(std::upper_bound(l_offset.begin(), l_offset.end(), n) - l_offset.begin()) - 1;
+                    const std::size_t l_rowblock    = l_order[l_position].second;
+                    const std::size_t l_columnblock = (p_traversal == triangle ? l_rowblock : 0) + n - l_offset[l_position];
+                    
+                    const ublas::range l_rowrange( std::max(l_shift, l_rowblock * l_blocksize) - l_shift, std::min(p_rows.data.size() + l_shift, (l_rowblock+1) * l_blocksize) - l_shift );
+                    const ublas::range l_columnrange( l_columnblock * l_blocksize, std::min(p_columns.data.size(), (l_columnblock+1) * l_blocksize) );
+                    
+                    // blocks of a previous calculation are skipped
+                    bool l_exists;
+                    #pragma omp critical (ncd_receiver)
+                    l_exists = p_receiver.exists( p_rowoffset + l_rowrange.start(), l_columnrange.start() );
+                    if (l_exists)
+                        continue;
+                    
+                    pairs( *l_compressor, p_rows, l_rowrange, p_columns, l_columnrange, p_isfile, (p_traversal != full), l_block, l_newpairs );
+                    
+                    // the distance of the triangle is the mean of both concatenation orders, a diagonal block holds both orders
+                    if (p_traversal == triangle) {
+                        if (l_rowblock == l_columnblock)
+                            l_transposed = l_block;
+                        else
+                            pairs( *l_compressor, p_columns, l_columnrange, p_rows, l_rowrange, p_isfile, false, l_transposed, l_newpairs );
                         
-                        #pragma omp critical
-                        l_map.insert(  std::pair<std::size_t, std::pair<std::size_t,std::size_t> >(i % omp_get_max_threads(), std::pair<std::size_t,std::size_t>(i,j))  );
-
+                        for(std::size_t i=0; i < l_block.size1(); ++i)
+                            for(std::size_t j=0; j < l_block.size2(); ++j)
+                                l_block(i,j) = 0.5 * (l_block(i,j) + l_transposed(j,i));
+                    }
+                    
+                    for(std::size_t i=0; i < l_block.size1(); ++i)
+                        for(std::size_t j=0; j < l_block.size2(); ++j)
+                            l_block(i,j) = std::min( static_cast<T>(1), l_block(i,j) );
+                    
+                    #pragma omp critical (ncd_receiver)
+                    p_receiver.receive( p_rowoffset + l_rowrange.start(), l_columnrange.start(), l_block );
+                } catch (const std::exception& e) {
+                    failure( l_error, e.what() );
+                } catch (...) {
+                    failure( l_error, _("unknown error on calculating a block") );
+                }
+            }
             
-            #pragma omp barrier
+            delete l_compressor;
             
-            for(std::multimap<std::size_t, std::pair<std::size_t,std::size_t> >::iterator it=l_map.lower_bound(omp_get_thread_num()); it != l_map.upper_bound(omp_get_thread_num()); ++it) {
+            // the loop ends with a barrier, so the cache is not read anymore
+            if (!l_newpairs.empty()) {
+                #pragma omp critical (ncd_cache)
+                m_paircache.insert( l_newpairs.begin(), l_newpairs.end() );
+            }
+        }
         
-                // read cache data
-                std::size_t l_first=0, l_second=0;
-                
-                #pragma omp critical
-                {
-                    l_first  = l_cache(it->second.first);
-                    l_second = l_cache(p_strvec1.size()+it->second.second);
+        if (!l_error.empty())
+            throw exception::runtime(l_error);
+    }
+    
+    
+    /** calculates the (unbounded) distances of a block. Every row element is compressed once into the compressor state
+     * and only the column elements are compressed on top of the primed state, so the compression of the row element is
+     * reused. The column elements are mapped once for the block. With enabled cache only the pairs, that are not cached,
+     * are compressed (a row is primed on the first missing pair) and the new pairs are collected
+     * @param p_compressor compression state of the thread
+     * @param p_rows row elements (first part of the concatenation)
+     * @param p_rowrange rows of the block
+     * @param p_columns column elements (second part of the concatenation)
+     * @param p_columnrange columns of the block
+     * @param p_isfile parameter for interpreting the string as a file with path
+     * @param p_diagonal the diagonal of the matrix is zero
+     * @param p_block distance block
+     * @param p_newpairs new pairs for the cache
+     **/
+    template<typename T> inline void ncd<T>::pairs( compressor& p_compressor, const elements& p_rows, const ublas::range& p_rowrange, const elements& p_columns, const ublas::range& p_columnrange, const bool& p_isfile, const bool& p_diagonal, ublas::matrix<T>& p_block, std::vector< std::pair<pairkey, std::size_t> >& p_newpairs ) const
+    {
+        p_block.resize( p_rowrange.size(), p_columnrange.size(), false );
+        
+        // each column needs its own mapping object (a copy of a mapping object shares the mapping)
+        std::vector<bio::mapped_file_source> l_columnfile;
+        l_columnfile.reserve( p_columnrange.size() );
+        for(std::size_t j=0; j < p_columnrange.size(); ++j)
+            l_columnfile.push_back( bio::mapped_file_source() );
+        std::vector< std::pair<const char*, std::size_t> > l_column( p_columnrange.size(), std::pair<const char*, std::size_t>(NULL, 0) );
+        
+        for(std::size_t i=0; i < p_rowrange.size(); ++i) {
+            const std::size_t l_row = p_rowrange(i);
+            
+            bio::mapped_file_source l_rowfile;
+            bool l_primed = false;
+            
+            for(std::size_t j=0; j < p_columnrange.size(); ++j) {
+                const std::size_t l_col = p_columnrange(j);
+                if ( p_diagonal && (l_row == l_col) ) {
+                    p_block(i,j) = static_cast<T>(0);
+                    continue;
                 }
                 
-                // check for both index positions the cache and adds the data
-                if (l_first == 0) {
-                    l_first = deflate(p_isfile, p_strvec1[it->second.first]);
-                    
-                    #pragma omp critical
-                    l_cache(it->second.first) = l_first;
+                // the cache is not changed within the parallel part, so it can be read without lock
+                if (m_caching) {
+                    const typename std::map<pairkey, std::size_t>::const_iterator l_cached = m_paircache.find( pairkey(p_rows.hash[l_row], p_columns.hash[l_col]) );
+                    if (l_cached != m_paircache.end()) {
+                        p_block(i,j) = measure( l_cached->second, p_rows.size(l_row), p_columns.size(l_col) );
+                        continue;
+                    }
                 }
                 
-                if (l_second == 0) {
-                    l_second = deflate(p_isfile, p_strvec2[it->second.second]);
-                    
-                    #pragma omp critical 
-                    l_cache(p_strvec1.size()+it->second.second) = l_second;
+                if (!l_primed) {
+                    const std::pair<const char*, std::size_t> l_data = source(p_isfile, p_rows.data[l_row], l_rowfile);
+                    p_compressor.prime( l_data.first, l_data.second );
+                    l_primed = true;
                 }
                 
+                if (!l_column[j].first)
+                    l_column[j] = source(p_isfile, p_columns.data[l_col], l_columnfile[j]);
                 
-                // determin min and max
-                const std::size_t l_min = std::min(l_first, l_second);
-                const std::size_t l_max = std::max(l_first, l_second);
-        
-                // calculate NCD
-                l_result(it->second.first, it->second.second) = std::min( static_cast<T>(1), static_cast<T>(deflate(p_isfile, p_strvec1[it->second.first], p_strvec2[it->second.second]) - l_min) / l_max );
+                const std::size_t l_size = p_compressor.deflate( l_column[j].first, l_column[j].second );
+                if (m_caching)
+                    p_newpairs.push_back( std::make_pair( pairkey(p_rows.hash[l_row], p_columns.hash[l_col]), l_size ) );
+                
+                p_block(i,j) = measure( l_size, p_rows.size(l_row), p_columns.size(l_col) );
             }
         }
-                
-        return l_result;
     }
     
     
-    #ifdef MACHINELEARNING_MPI
+    /** constructor of the matrix receiver
+     * @param p_matrix target matrix
+     **/
+    template<typename T> template<typename M> inline ncd<T>::assign<M>::assign( M& p_matrix ) :
+        m_matrix( p_matrix )
+    {}
+    
     
-    /** creates a distance matrix with shared data
-     * @param p_mpi MPI object
-     * @param p_strvec local dataset
-     * @param p_isfile parameter for interpreting the string as a file with path
-     * @return part of distance matrix (all data size x local data size)
+    /** copies a block into the matrix
+     * @param p_row index of the first row
+     * @param p_column index of the first column
+     * @param p_block distance block
      **/
-    template<typename T> inline ublas::matrix<T> ncd<T>::unsquare ( const mpi::communicator& p_mpi, const std::vector<std::string>& p_strvec, const bool& p_isfile ) const
+    template<typename T> template<typename M> inline void ncd<T>::assign<M>::receive( const std::size_t& p_row, const std::size_t& p_column, const ublas::matrix<T>& p_block )
+    {
+        for(std::size_t i=0; i < p_block.size1(); ++i)
+            for(std::size_t j=0; j < p_block.size2(); ++j)
+                m_matrix(p_row + i, p_column + j) = p_block(i,j);
+    }
+    
+    
+    #ifdef MACHINELEARNING_FILES_HDF
+    
+    /** constructor of the HDF receiver, the datasets are created if they do not exist, existing datasets
+     * are reused, so the finished blocks of a previous calculation are not calculated again
+     * @param p_file HDF file
+     * @param p_path path of the distance dataset
+     * @param p_rows number of rows of the distance matrix
+     * @param p_columns number of columns of the distance matrix
+     * @param p_datatype datatype of the distances within the file
+     * @param p_symmetric the blocks are mirrored (for the symmetric calculation, that passes only the upper triangle)
+     * @param p_blocksize number of rows and columns of a block / chunk
+     **/
+    template<typename T> inline ncd<T>::hdfwriter::hdfwriter( tools::files::hdf& p_file, const std::string& p_path, const std::size_t& p_rows, const std::size_t& p_columns, const tools::files::hdf::datatype& p_datatype, const bool& p_symmetric, const std::size_t& p_blocksize ) :
+        m_file( p_file ),
+        m_path( p_path ),
+        m_blockpath( p_path + "_blocks" ),
+        m_datatype( p_datatype ),
+        m_symmetric( p_symmetric ),
+        m_blocksize( p_blocksize )
+    {
+        if ((!p_rows) || (!p_columns))
+            throw exception::runtime(_("matrix size must be greater than zero"), *this);
+        if (!p_blocksize)
+            throw exception::runtime(_("block size must be greater than zero"), *this);
+        if (p_symmetric && (p_rows != p_columns))
+            throw exception::runtime(_("symmetric matrix must be square"), *this);
+        
+        // the row blocks of a row offset (MPI) are not aligned, so the blocks are marked by the first row
+        const std::pair<std::size_t, std::size_t> l_blocks( p_rows, (p_columns + p_blocksize - 1) / p_blocksize );
+        
+        if (m_file.pathexists(m_path)) {
+            if ( (m_file.getBlasMatrixSize(m_path) != std::make_pair(p_rows, p_columns)) || (!m_file.pathexists(m_blockpath)) || (m_file.getBlasMatrixSize(m_blockpath) != l_blocks) )
+                throw exception::runtime(_("existing dataset does not match the matrix size"), *this);
+            return;
+        }
+        
+        // the marks are written at last, so the data of a marked block is complete
+        m_file.createBlasMatrix( m_path, p_rows, p_columns, p_blocksize, m_datatype );
+        m_file.createBlasMatrix( m_blockpath, l_blocks.first, l_blocks.second, p_blocksize, tools::files::hdf::NATIVE_UINT8 );
+        m_file.flush();
+    }
+    
+    
+    /** writes a block into the dataset and marks the block as finished
+     * @param p_row index of the first row
+     * @param p_column index of the first column
+     * @param p_block distance block
+     **/
+    template<typename T> inline void ncd<T>::hdfwriter::receive( const std::size_t& p_row, const std::size_t& p_column, const ublas::matrix<T>& p_block )
+    {
+        if (p_column % m_blocksize)
+            throw exception::runtime(_("block is not aligned to the block size"), *this);
+        
+        m_file.writeBlasMatrix( m_path, p_row, p_column, p_block, m_datatype );
+        if (m_symmetric && (p_row != p_column))
+            m_file.writeBlasMatrix( m_path, p_column, p_row, ublas::matrix<T>(ublas::trans(p_block)), m_datatype );
+        
+        m_file.writeBlasMatrix( m_blockpath, p_row, p_column / m_blocksize, ublas::matrix<unsigned char>(1, 1, 1), tools::files::hdf::NATIVE_UINT8 );
+        m_file.flush();
+    }
+    
+    
+    /** returns the block size
+     * @return number of rows and columns of a block
+     **/
+    template<typename T> inline std::size_t ncd<T>::hdfwriter::getBlockSize( void ) const
+    {
+        return m_blocksize;
+    }
+    
+    
+    /** checks the mark of a block
+     * @param p_row index of the first row
+     * @param p_column index of the first column
+     * @return the block is finished
+     **/
+    template<typename T> inline bool ncd<T>::hdfwriter::exists( const std::size_t& p_row, const std::size_t& p_column ) const
+    {
+        return m_file.readBlasMatrix<unsigned char>( m_blockpath, p_row, 1, p_column / m_blocksize, 1, tools::files::hdf::NATIVE_UINT8 )(0,0) != 0;
+    }
+    
+    #endif
+    
+    
+    #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
+    
+    /** creates a distance matrix with shared data
+     * @param p_mpi MPI object
+     * @param p_strvec local dataset
+     * @param p_isfile parameter for interpreting the string as a file with path
+     * @return part of distance matrix (all data size x local data size)
+     **/
+    template<typename T> inline ublas::matrix<T> ncd<T>::unsquare ( const mpi::communicator& p_mpi, const std::vector<std::string>& p_strvec, const bool& p_isfile ) const
+    {
+        if (p_strvec.size() == 0)
+            throw exception::runtime(_("vector size must be greater than zero"), *this);
+        
+        // create the target matrix (rows = all data size, column local data size)
+        ublas::matrix<T> l_result( mpi::all_reduce(p_mpi, p_strvec.size(), std::plus<std::size_t>()), p_strvec.size() );
+        assign< ublas::matrix<T> > l_assign(l_result);
+        unsquare( p_mpi, p_strvec, l_assign, p_isfile );
+        
+        return l_result;
+    }
+    
+    
+    /** calculates the distances with shared data and passes the finished blocks to the receiver, so the
+     * part of the distance matrix must not be stored (the rows are the indices of all data, the columns
+     * the indices of the local data)
+     * @param p_mpi MPI object
+     * @param p_strvec local dataset
+     * @param p_receiver receiver of the blocks
+     * @param p_isfile parameter for interpreting the string as a file with path
+     **/
+    template<typename T> inline void ncd<T>::unsquare ( const mpi::communicator& p_mpi, const std::vector<std::string>& p_strvec, receiver& p_receiver, const bool& p_isfile ) const
     {
         if (p_strvec.size() == 0)
             throw exception::runtime(_("vector size must be greater than zero"), *this);
         
-        // synchronize the isFile parameter
-        const bool l_isfile = mpi::all_reduce(p_mpi, p_isfile, std::multiplies<bool>());
+        // synchronize the isFile parameter and the use of the cache (the hashes are sent only if all CPUs use the cache)
+        const bool l_isfile   = mpi::all_reduce(p_mpi, p_isfile, std::multiplies<bool>());
+        const bool l_sendhash = mpi::all_reduce(p_mpi, m_caching, std::multiplies<bool>());
+        
+        // the compression sizes of the local data are computed once and are sent together with the data,
+        // so no CPU compresses a single element twice
+        const std::vector<boost::uint64_t> l_hash = hash(p_strvec, l_isfile);
+        const ublas::vector<std::size_t> l_cache  = deflate(p_strvec, l_hash, l_isfile);
+        const elements l_local                    = { p_strvec, l_cache, l_hash };
+        
+        // the local data is serialized once into a flat buffer and a header with the length, the compression
+        // size and the hash of each element, so the buffers are forwarded around the ring without serialization
+        // (the first buffer holds the current data of the ring, the second buffer receives the next data)
+        std::vector<char> l_data[2];
+        std::vector<boost::uint64_t> l_header[2];
+        
+        for(std::size_t i=0; i < p_strvec.size(); ++i) {
+            l_data[0].insert( l_data[0].end(), p_strvec[i].begin(), p_strvec[i].end() );
+            l_header[0].push_back( p_strvec[i].size() );
+            l_header[0].push_back( l_cache(i) );
+            l_header[0].push_back( l_sendhash ? l_hash[i] : 0 );
+        }
         
-        // we detect the matrix row size (sum over each CPU data - we don't use the all_reduce,
-        // because the different datasizes of each CPU data is needed later)
+        if (l_data[0].size() > static_cast<std::size_t>(std::numeric_limits<int>::max()))
+            throw exception::runtime(_("local data is too large for sending"), *this);
+        
+        // we detect the number of elements and bytes of each CPU data for the receive buffers and the row index
         std::vector<std::size_t> l_datasize;
+        std::vector<std::size_t> l_bytes;
         mpi::all_gather(p_mpi, p_strvec.size(), l_datasize );
-        const std::size_t l_rowsize = std::accumulate( l_datasize.begin(), l_datasize.end(), 0 );
-        
-        // create the target matrix (rows = all data size, column local data size)
-        ublas::matrix<T> l_result( l_rowsize, p_strvec.size() );
+        mpi::all_gather(p_mpi, l_data[0].size(), l_bytes );
         
         
-        // create the local distances
-        const std::size_t l_localrow = std::accumulate( l_datasize.begin(), l_datasize.begin() + static_cast<std::size_t>(p_mpi.rank()), 0 );
-        ublas::matrix_range< ublas::matrix<T> > l_rangelocal(l_result, 
-                                                                  ublas::range( l_localrow, l_localrow + p_strvec.size() ), 
-                                                                  ublas::range( 0, l_result.size2() )
-                                                                  );
-        l_rangelocal.assign( unsquare(p_strvec, p_strvec, l_isfile) );
+        // each step calculates the distances of the data of the CPU rank-i to the local data, and the buffer is
+        // forwarded to the successor, while the data of the next step is received of the predecessor, so the
+        // transfer is overlapped with the calculation
+        const std::size_t l_size        = static_cast<std::size_t>(p_mpi.size());
+        const std::size_t l_rank        = static_cast<std::size_t>(p_mpi.rank());
+        const int l_successor           = static_cast<int>((l_rank + 1) % l_size);
+        const int l_predecessor         = static_cast<int>((l_rank + l_size - 1) % l_size);
         
-        // create distance to the local articles and the articless of the neighborhood CPU
-        for(std::size_t i=1; i < static_cast<std::size_t>(p_mpi.size()); ++i)
+        for(std::size_t i=0; i < l_size; ++i)
         {
-            // get start index on the matrix
-            const std::size_t l_successor   = (static_cast<std::size_t>(p_mpi.rank())+i) % static_cast<std::size_t>(p_mpi.size());
-            const std::size_t l_predecessor = (static_cast<std::size_t>(p_mpi.rank())+p_mpi.size()-i) % static_cast<std::size_t>(p_mpi.size());
+            const std::size_t l_current = i % 2;
+            const std::size_t l_owner   = (l_rank + l_size - i) % l_size;
             
-            // send and receive with non-blocking operation and wait for both request
-            mpi::request l_req[2];
-            std::vector<std::string> l_neighbourdata;
-            l_req[0] = p_mpi.isend(l_successor, 0, p_strvec);
-            l_req[1] = p_mpi.irecv(l_predecessor, 0, l_neighbourdata);
-            mpi::wait_all(l_req, l_req+2);
+            // the buffer of the next step was sent in the previous step, so it can be resized
+            std::vector<mpi::request> l_requests;
+            if (i+1 < l_size) {
+                const std::size_t l_next = (l_owner + l_size - 1) % l_size;
+                l_data[1-l_current].resize( l_bytes[l_next] );
+                l_header[1-l_current].resize( 3 * l_datasize[l_next] );
+                
+                l_requests.push_back( mpi::isendrecv(p_mpi, l_successor, &l_data[l_current][0], static_cast<int>(l_data[l_current].size()), l_predecessor, &l_data[1-l_current][0], static_cast<int>(l_data[1-l_current].size())) );
+                l_requests.push_back( mpi::isendrecv(p_mpi, l_successor, &l_header[l_current][0], static_cast<int>(l_header[l_current].size()), l_predecessor, &l_header[1-l_current][0], static_cast<int>(l_header[1-l_current].size())) );
+            }
             
             // get position within the matrix and create distance values
-            const std::size_t l_startrow = std::accumulate( l_datasize.begin(), l_datasize.begin() + l_predecessor, 0 );
-            ublas::matrix_range< ublas::matrix<T> > l_range( l_result, 
-                                                             ublas::range( l_startrow, l_startrow+l_neighbourdata.size() ), 
-                                                             ublas::range( 0, l_result.size2() )
-                                                           );
-            l_range.assign( unsquare(l_neighbourdata, p_strvec, l_isfile) );
+            const std::size_t l_row = std::accumulate( l_datasize.begin(), l_datasize.begin() + l_owner, static_cast<std::size_t>(0) );
+            
+            if (!i)
+                blocks( l_local, l_local, l_isfile, diagonal, p_receiver, l_row );
+            else {
+                std::vector<std::string> l_neighbourdata( l_datasize[l_owner] );
+                ublas::vector<std::size_t> l_neighbourcache( l_datasize[l_owner] );
+                std::vector<boost::uint64_t> l_neighbourhash( l_sendhash ? l_datasize[l_owner] : 0 );
+                
+                std::size_t l_offset = 0;
+                for(std::size_t n=0; n < l_neighbourdata.size(); ++n) {
+                    l_neighbourdata[n].assign( &l_data[l_current][l_offset], static_cast<std::size_t>(l_header[l_current][3*n]) );
+                    l_offset += static_cast<std::size_t>(l_header[l_current][3*n]);
+                    
+                    l_neighbourcache(n) = static_cast<std::size_t>(l_header[l_current][3*n+1]);
+                    if (l_sendhash)
+                        l_neighbourhash[n] = l_header[l_current][3*n+2];
+                }
+                
+                // a CPU with cache computes the hashes, if they are not sent
+                if ( (m_caching) && (!l_sendhash) )
+                    l_neighbourhash = hash(l_neighbourdata, l_isfile);
+                
+                const elements l_neighbour = { l_neighbourdata, l_neighbourcache, l_neighbourhash };
+                blocks( l_neighbour, l_local, l_isfile, full, p_receiver, l_row );
+            }
+            
+            mpi::wait_all( l_requests.begin(), l_requests.end() );
         }
+    }
+    #endif
+    
+    
+    /** returns the data of a string or a file, files are mapped into the memory
+     * @param p_isfile bool for interpret input string like filenames
+     * @param p_str string or filename
+     * @param p_file file object, that holds the mapping
+     * @return pointer and size of the data
+     **/
+    template<typename T> inline std::pair<const char*, std::size_t> ncd<T>::source( const bool& p_isfile, const std::string& p_str, bio::mapped_file_source& p_file ) const
+    {
+        if (p_str.empty())
+            throw exception::runtime(_("string size must be greater than zero"), *this);
         
-        // set the main diagonal zero values
-        #pragma omp parallel for shared(l_result)
-        for(std::size_t i = 0; i < l_result.size2(); ++i)
-            l_result(l_localrow+i,i) = 0;
+        if (!p_isfile)
+            return std::pair<const char*, std::size_t>(p_str.data(), p_str.size());
         
-        return l_result;
+        try {
+            p_file.open( p_str );
+        } catch (...) {
+            throw exception::runtime(_("file can not be opened"), *this);
+        }
+        
+        return std::pair<const char*, std::size_t>(p_file.data(), p_file.size());
     }
-    #endif
     
     
     /** deflate a string or file with the algorithm
+     * @param p_compressor compression state of the thread
      * @param p_isfile bool for interpret input string like filenames
      * @param p_str1 first string to compress
      * @param p_str2 optional second string to compress
      * @return number of bytes 
      **/    
-    template<typename T> inline std::size_t ncd<T>::deflate( const bool& p_isfile, const std::string& p_str1, const std::string& p_str2 ) const
+    template<typename T> inline std::size_t ncd<T>::deflate( compressor& p_compressor, const bool& p_isfile, const std::string& p_str1, const std::string& p_str2 ) const
     {
-        if (p_str1.empty())
-            throw exception::runtime(_("string size must be greater than zero"), *this);
-
-        // for each compress algorithm we removed the header & footer size of the resulting count
-        // @see http://en.wikipedia.org/wiki/Bzip2#File_format
-        // @see http://en.wikipedia.org/wiki/Gzip#File_format
-        std::size_t l_removesize = 0;
+        bio::mapped_file_source l_file1;
+        const std::pair<const char*, std::size_t> l_data1 = source(p_isfile, p_str1, l_file1);
+        
+        if (p_str2.empty())
+            return p_compressor.deflate( l_data1.first, l_data1.second, NULL, 0 );
+        
+        bio::mapped_file_source l_file2;
+        const std::pair<const char*, std::size_t> l_data2 = source(p_isfile, p_str2, l_file2);
+        
+        return p_compressor.deflate( l_data1.first, l_data1.second, l_data2.first, l_data2.second );
+    }
+    
+    
+    /** deflate every string or file of a vector, with enabled cache only the uncached elements are compressed
+     * @param p_strvec string vector
+     * @param p_hash content hash of every element (empty without cache)
+     * @param p_isfile bool for interpret input string like filenames
+     * @return vector with number of bytes
+     **/    
+    template<typename T> inline ublas::vector<std::size_t> ncd<T>::deflate( const std::vector<std::string>& p_strvec, const std::vector<boost::uint64_t>& p_hash, const bool& p_isfile ) const
+    {
+        ublas::vector<std::size_t> l_size(p_strvec.size());
+        
+        std::string l_error;
+        
+        #pragma omp parallel shared(l_size, l_error)
+        {
+            compressor* l_compressor = NULL;
+            std::vector< std::pair<boost::uint64_t, std::size_t> > l_newelements;
+            
+            try {
+                l_compressor = new compressor( *this );
+            } catch (const std::exception& e) {
+                failure( l_error, e.what() );
+            } catch (...) {
+                failure( l_error, _("unknown error on creating the compressor") );
+            }
+            
+            #pragma omp for schedule(dynamic)
+            for(std::size_t i=0; i < p_strvec.size(); ++i) {
+                if (failed(l_error))
+                    continue;
+                
+                if (m_caching) {
+                    const std::map<boost::uint64_t, std::size_t>::const_iterator l_cached = m_singlecache.find(p_hash[i]);
+                    if (l_cached != m_singlecache.end()) {
+                        l_size(i) = l_cached->second;
+                        continue;
+                    }
+                }
+                
+                try {
+                    l_size(i) = deflate(*l_compressor, p_isfile, p_strvec[i]);
+                    if (m_caching)
+                        l_newelements.push_back( std::make_pair(p_hash[i], l_size(i)) );
+                } catch (const std::exception& e) {
+                    failure( l_error, e.what() );
+                } catch (...) {
+                    failure( l_error, _("unknown error on compressing an element") );
+                }
+            }
+            
+            delete l_compressor;
+            
+            if (!l_newelements.empty()) {
+                #pragma omp critical (ncd_cache)
+                m_singlecache.insert( l_newelements.begin(), l_newelements.end() );
+            }
+        }
+        
+        if (!l_error.empty())
+            throw exception::runtime(l_error);
+        
+        return l_size;
+    }
+    
+    
+    /** creates the content hashes of every string or file of a vector, the hashes are
+     * seeded with the compression configuration, so the keys of different configurations
+     * are different
+     * @param p_strvec string vector
+     * @param p_isfile bool for interpret input string like filenames
+     * @return vector with the hashes (empty if the cache is disabled)
+     **/    
+    template<typename T> inline std::vector<boost::uint64_t> ncd<T>::hash( const std::vector<std::string>& p_strvec, const bool& p_isfile ) const
+    {
+        if (!m_caching)
+            return std::vector<boost::uint64_t>();
+        
+        const boost::uint64_t l_configuration = configuration();
+        std::vector<boost::uint64_t> l_hash(p_strvec.size());
+        
+        std::string l_error;
+        
+        #pragma omp parallel for shared(l_hash, l_error)
+        for(std::size_t i=0; i < p_strvec.size(); ++i) {
+            if (failed(l_error))
+                continue;
+            
+            try {
+                bio::mapped_file_source l_file;
+                const std::pair<const char*, std::size_t> l_data = source(p_isfile, p_strvec[i], l_file);
+                l_hash[i] = tools::function::fnv( l_data.first, l_data.second, l_configuration );
+            } catch (const std::exception& e) {
+                failure( l_error, e.what() );
+            } catch (...) {
+                failure( l_error, _("unknown error on hashing an element") );
+            }
+        }
+        
+        if (!l_error.empty())
+            throw exception::runtime(l_error);
+        
+        return l_hash;
+    }
+    
+    
+    /** stores the first error of a parallel region, exceptions can not leave the region
+     * @param p_error error of the region
+     * @param p_message message of the caught exception
+     **/
+    template<typename T> inline void ncd<T>::failure( std::string& p_error, const std::string& p_message )
+    {
+        #pragma omp critical (ncd_error)
+        if (p_error.empty())
+            p_error = p_message;
+    }
+    
+    
+    /** checks if an error is stored within a parallel region, so the remaining iterations can be skipped
+     * @param p_error error of the region
+     * @return flag of the error
+     **/
+    template<typename T> inline bool ncd<T>::failed( const std::string& p_error )
+    {
+        bool l_failed;
+        #pragma omp critical (ncd_error)
+        l_failed = !p_error.empty();
+        return l_failed;
+    }
+    
+    
+    /** returns the hash of the compression configuration (algorithm, levels and dictionary)
+     * @return hash
+     **/
+    template<typename T> inline boost::uint64_t ncd<T>::configuration( void ) const
+    {
+        std::vector<boost::uint64_t> l_configuration;
+        l_configuration.push_back( static_cast<boost::uint64_t>(m_compress) );
+        l_configuration.push_back( static_cast<boost::uint64_t>(m_gziplevel) );
+        l_configuration.push_back( static_cast<boost::uint64_t>(m_bzip2level) );
         
-        // create output null stream, compressor and counter structure
-        bio::counter l_counter;
-        bio::basic_null_sink<char> l_null;
-        bio::filtering_streambuf< bio::output > l_deflate;
+        #ifdef MACHINELEARNING_COMPRESSION
+        l_configuration.push_back( static_cast<boost::uint64_t>(m_zstdlevel) );
+        l_configuration.push_back( static_cast<boost::uint64_t>(m_lz4acceleration) );
+        l_configuration.push_back( static_cast<boost::uint64_t>(m_xzlevel) );
+        l_configuration.push_back( m_dictionaryhash );
+        #endif
         
+        return tools::function::fnv( reinterpret_cast<const char*>(&l_configuration[0]), l_configuration.size() * sizeof(boost::uint64_t) );
+    }
+    
+    
+    /** constructor of the compression state
+     * @param p_ncd NCD object with the algorithm, the compression levels and the dictionary
+     **/
+    template<typename T> inline ncd<T>::compressor::compressor( const ncd<T>& p_ncd ) :
+        m_compress( p_ncd.m_compress ),
+        m_bzip2level( p_ncd.m_bzip2level ),
+        m_zlib(),
+        m_copy(),
+        m_arena(),
+        m_arenaposition( 0 ),
+        m_arenacopy( 0 ),
+        m_copysize( 1024 ),
+        m_data( NULL ),
+        m_size( 0 ),
+        m_primedsize( 0 ),
+        m_buffer( 64*1024 )
+        #ifdef MACHINELEARNING_COMPRESSION
+        ,
+        m_level( (p_ncd.m_compress == zstd) ? p_ncd.m_zstdlevel : p_ncd.m_lz4acceleration ),
+        m_zstd( NULL ),
+        m_dictionary( p_ncd.m_dictionary.get() ),
+        m_zstdprimed( NULL ),
+        m_lz4( NULL ),
+        m_lz4hc( NULL ),
+        m_lzma(),
+        m_lzmaoptions()
+        #endif
+    {
+        #ifdef MACHINELEARNING_COMPRESSION
         switch (m_compress) {
-            case gzip   : l_deflate.push( bio::gzip_compressor( m_gzipparam ) );      l_removesize = 18; break;
-            case bzip2  : l_deflate.push( bio::bzip2_compressor( m_bzip2param ) );    l_removesize = 8; break;
+            
+            case zstd :
+                // the frame is created without checksum, dictionary id and content size, so only the magic number
+                // and the frame header (descriptor & window) are written
+                m_zstd = ZSTD_createCCtx();
+                if ( (!m_zstd) ||
+                     ZSTD_isError(ZSTD_CCtx_setParameter(m_zstd, ZSTD_c_compressionLevel, m_level)) ||
+                     ZSTD_isError(ZSTD_CCtx_setParameter(m_zstd, ZSTD_c_contentSizeFlag, 0)) ||
+                     ZSTD_isError(ZSTD_CCtx_setParameter(m_zstd, ZSTD_c_checksumFlag, 0)) ||
+                     ZSTD_isError(ZSTD_CCtx_setParameter(m_zstd, ZSTD_c_dictIDFlag, 0)) ||
+                     ( m_dictionary && ZSTD_isError(ZSTD_CCtx_refCDict(m_zstd, m_dictionary)) )
+                   ) {
+                    ZSTD_freeCCtx(m_zstd);
+                    throw exception::runtime(_("compression stream can not be initialized"));
+                }
+                return;
+                
+            case lz4 :
+                if (m_level > 0)
+                    m_lz4   = LZ4_createStream();
+                else
+                    m_lz4hc = LZ4_createStreamHC();
+                if ( (!m_lz4) && (!m_lz4hc) )
+                    throw exception::runtime(_("compression stream can not be initialized"));
+                return;
+                
+            case xz :
+                if (lzma_lzma_preset(&m_lzmaoptions, p_ncd.m_xzlevel))
+                    throw exception::runtime(_("compression stream can not be initialized"));
+                return;
+                
+            default :
+                break;
+        }
+        #endif
+        
+        if (m_compress != gzip)
+            return;
+        
+        // the arena holds the primed and the copied stream (memory of one stream: window, hash tables and pending buffer)
+        // @see http://www.zlib.net/zlib_tech.html
+        m_arena.resize( 2 * ((static_cast<std::size_t>(1) << (MAX_WBITS+2)) + (static_cast<std::size_t>(1) << (8+9)) + 32*1024) );
+        m_zlib.zalloc = allocate;
+        m_zlib.zfree  = release;
+        m_zlib.opaque = this;
+        
+        // the gzip stream is created without header & footer (raw deflate data)
+        if (deflateInit2(&m_zlib, p_ncd.m_gziplevel, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            throw exception::runtime(_("compression stream can not be initialized"));
+        m_arenacopy = m_arenaposition;
+    }
+    
+    
+    /** destructor **/
+    template<typename T> inline ncd<T>::compressor::~compressor( void )
+    {
+        if (m_compress == gzip)
+            deflateEnd(&m_zlib);
+        
+        #ifdef MACHINELEARNING_COMPRESSION
+        if (m_zstd)
+            ZSTD_freeCCtx(m_zstd);
+        if (m_zstdprimed)
+            ZSTD_freeCDict(m_zstdprimed);
+        if (m_lz4)
+            LZ4_freeStream(m_lz4);
+        if (m_lz4hc)
+            LZ4_freeStreamHC(m_lz4hc);
+        if (m_compress == xz)
+            lzma_end(&m_lzma);
+        #endif
+    }
+    
+    
+    /** allocation function of zlib, the memory is taken of the arena
+     * @param p_compressor compressor object
+     * @param p_items number of items
+     * @param p_size size of an item
+     * @return pointer to the memory or null if the arena is full
+     **/
+    template<typename T> inline voidpf ncd<T>::compressor::allocate( voidpf p_compressor, uInt p_items, uInt p_size )
+    {
+        compressor* const l_compressor = static_cast<compressor*>(p_compressor);
+        const std::size_t l_size       = (static_cast<std::size_t>(p_items) * p_size + 63) & ~static_cast<std::size_t>(63);
+        
+        if (l_compressor->m_arenaposition + l_size > l_compressor->m_arena.size())
+            return Z_NULL;
+        
+        voidpf l_memory = &l_compressor->m_arena[l_compressor->m_arenaposition];
+        l_compressor->m_arenaposition += l_size;
+        return l_memory;
+    }
+    
+    
+    /** release function of zlib, the arena is reused, so the memory is not released **/
+    template<typename T> inline void ncd<T>::compressor::release( voidpf, voidpf )
+    {}
+    
+    
+    /** primes the compressor with the first data
+     * @param p_data data
+     * @param p_size size of the data
+     **/
+    template<typename T> inline void ncd<T>::compressor::prime( const char* p_data, const std::size_t& p_size )
+    {
+        m_data       = p_data;
+        m_size       = p_size;
+        m_primedsize = 0;
+        
+        if ( (m_compress == gzip) && (m_size >= m_copysize) ) {
+            deflateReset(&m_zlib);
+            compressZlib( m_zlib, p_data, p_size, Z_NO_FLUSH );
         }
-        l_deflate.push( boost::ref(l_counter) );        
-        l_deflate.push( l_null );
-        
-        // create stream for data and copy streamdata to output
-        if (p_isfile) {
-            // for filestreams copy data manually to deflate stream, cause boost::iostreams::copy close
-            // source and destination stream after copy is finished, so we copy only data from first
-            // stream into deflate and than from second stream
-            
-            std::ifstream l_file1(p_str1.c_str(), std::ifstream::binary);
-            if (!l_file1.is_open())
-                throw exception::runtime(_("file can not be opened"), *this);
-            std::copy( std::istream_iterator<char>(l_file1), std::istream_iterator<char>(), std::ostreambuf_iterator<char>(&l_deflate) );
-            
-            if (!p_str2.empty()) {
-                std::ifstream l_file2(p_str2.c_str(), std::ifstream::binary);
-                if (!l_file2.is_open())
-                    throw exception::runtime(_("file can not be opened"), *this);
-                std::copy( std::istream_iterator<char>(l_file2), std::istream_iterator<char>(), std::ostreambuf_iterator<char>(&l_deflate) );
+        
+        // the dictionary of the previous data is referenced by the context only during a compression
+        #ifdef MACHINELEARNING_COMPRESSION
+        if (m_zstdprimed) {
+            ZSTD_freeCDict(m_zstdprimed);
+            m_zstdprimed = NULL;
+        }
+        #endif
+    }
+    
+    
+    /** compresses the concatenation of the primed data and a buffer and counts the bytes. The zlib state
+     * is copied, so the primed data is not compressed again. zstd, LZ4 and xz compress the primed data once
+     * and compress the buffer with the primed data as dictionary, so the size is the sum of both parts
+     * @param p_data buffer
+     * @param p_size size of the buffer
+     * @return number of compressed bytes (without header & footer)
+     **/
+    template<typename T> inline std::size_t ncd<T>::compressor::deflate( const char* p_data, const std::size_t& p_size )
+    {
+        switch (m_compress) {
+            
+            case gzip :
+                // small data is compressed again, because the copy of the stream state is more expensive
+                if (m_size < m_copysize) {
+                    deflateReset(&m_zlib);
+                    compressZlib( m_zlib, m_data, m_size, Z_NO_FLUSH );
+                    compressZlib( m_zlib, p_data, p_size, Z_FINISH );
+                    return static_cast<std::size_t>(m_zlib.total_out);
+                }
+                
+                // the copy uses the allocation function of the primed stream, so the arena is reset
+                m_arenaposition = m_arenacopy;
+                if (deflateCopy(&m_copy, &m_zlib) != Z_OK)
+                    throw exception::runtime(_("compression stream can not be copied"));
+                compressZlib( m_copy, p_data, p_size, Z_FINISH );
+                return static_cast<std::size_t>(m_copy.total_out);
+                
+            case bzip2 :
+            {
+                // bzip2 has no reset function, so the stream is created on each call. The block size (100k bytes
+                // per level) is reduced to the data size, the compressed size of data within one block does not change
+                const int l_level = static_cast<int>( std::min( static_cast<std::size_t>(m_bzip2level), (m_size + p_size + 19) / 100000 + 1 ) );
+                
+                bz_stream l_stream;
+                l_stream.bzalloc = NULL;
+                l_stream.bzfree  = NULL;
+                l_stream.opaque  = NULL;
+                if (BZ2_bzCompressInit(&l_stream, l_level, 0, 30) != BZ_OK)
+                    throw exception::runtime(_("compression stream can not be initialized"));
+                
+                compressBzip2( l_stream, m_data, m_size, BZ_RUN );
+                compressBzip2( l_stream, p_data, p_size, BZ_FINISH );
+                
+                const std::size_t l_size = static_cast<std::size_t>(l_stream.total_out_lo32) + (static_cast<std::size_t>(l_stream.total_out_hi32) << 32);
+                BZ2_bzCompressEnd(&l_stream);
+                
+                // we removed the header size of the resulting count
+                // @see http://en.wikipedia.org/wiki/Bzip2#File_format
+                return (l_size >= 8) ? l_size - 8 : l_size;
             }
             
-        } else {
-          
-            // we read binary data and don't skip any whitespaces
-            std::stringstream l_sstream( std::stringstream::in | std::stringstream::out | std::stringstream::binary );
-            l_sstream << std::noskipws << p_str1 << p_str2;
-            std::copy( std::istream_iterator<char>(l_sstream), std::istream_iterator<char>(), std::ostreambuf_iterator<char>(&l_deflate) );
+            #ifdef MACHINELEARNING_COMPRESSION
+            case zstd :
+            {
+                // small data is compressed again, the same holds with a trained dictionary (the context references only
+                // one dictionary) and for data, that starts with the magic number of a zstd dictionary (it is not raw content)
+                // @see https://github.com/facebook/zstd/blob/dev/doc/zstd_compression_format.md#dictionary-format
+                const bool l_magic = (m_size >= 4) && (static_cast<unsigned char>(m_data[0]) == 0x37) && (static_cast<unsigned char>(m_data[1]) == 0xA4) &&
+                                     (static_cast<unsigned char>(m_data[2]) == 0x30) && (static_cast<unsigned char>(m_data[3]) == 0xEC);
+                if ( (m_size < m_copysize) || (p_size == 0) || m_dictionary || l_magic ) {
+                    // the reset keeps the parameters and the dictionary
+                    ZSTD_CCtx_reset(m_zstd, ZSTD_reset_session_only);
+                    std::size_t l_size = compressZstd( m_data, m_size, ZSTD_e_continue );
+                    l_size            += compressZstd( p_data, p_size, ZSTD_e_end );
+                    
+                    // we removed the magic number (4 bytes), the frame header descriptor and the window descriptor
+                    // @see https://github.com/facebook/zstd/blob/dev/doc/zstd_compression_format.md#frames
+                    return (l_size >= 6) ? l_size - 6 : l_size;
+                }
+                
+                // the primed data is compressed once and the tables of the dictionary are created once
+                if (!m_zstdprimed) {
+                    ZSTD_CCtx_reset(m_zstd, ZSTD_reset_session_only);
+                    const std::size_t l_size = compressZstd( m_data, m_size, ZSTD_e_end );
+                    m_primedsize = (l_size >= 6) ? l_size - 6 : l_size;
+                    
+                    m_zstdprimed = ZSTD_createCDict( m_data, m_size, m_level );
+                    if (!m_zstdprimed)
+                        throw exception::runtime(_("dictionary can not be created"));
+                }
+                
+                ZSTD_CCtx_reset(m_zstd, ZSTD_reset_session_only);
+                if (ZSTD_isError(ZSTD_CCtx_refCDict(m_zstd, m_zstdprimed)))
+                    throw exception::runtime(_("compression stream can not be initialized"));
+                const std::size_t l_size = compressZstd( p_data, p_size, ZSTD_e_end );
+                ZSTD_CCtx_refCDict(m_zstd, NULL);
+                
+                return m_primedsize + ((l_size >= 6) ? l_size - 6 : l_size);
+            }
+                
+            case lz4 :
+            {
+                // the LZ4 block format has got no header, the second block references the data of the first block. Small
+                // data is compressed again, otherwise the primed data is compressed once and only the last 64 KB (the
+                // window of LZ4) are loaded as dictionary of the second block
+                if ( (m_size < m_copysize) || (p_size == 0) || (!m_primedsize) ) {
+                    if (m_lz4)
+                        LZ4_resetStream_fast(m_lz4);
+                    else
+                        LZ4_resetStreamHC_fast(m_lz4hc, LZ4HC_CLEVEL_MAX);
+                    m_primedsize = compressLz4( m_data, m_size );
+                } else {
+                    const std::size_t l_dictionary = std::min( m_size, static_cast<std::size_t>(64*1024) );
+                    if (m_lz4)
+                        LZ4_loadDict( m_lz4, m_data + m_size - l_dictionary, static_cast<int>(l_dictionary) );
+                    else
+                        LZ4_loadDictHC( m_lz4hc, m_data + m_size - l_dictionary, static_cast<int>(l_dictionary) );
+                }
+                
+                // LZ4 HC drops the history, if the second block overlaps the first block, so the data is copied
+                if ( (p_data < m_data + m_size) && (m_data < p_data + p_size) ) {
+                    const std::vector<char> l_copy( p_data, p_data + p_size );
+                    return m_primedsize + compressLz4( &l_copy[0], p_size );
+                }
+                
+                return m_primedsize + compressLz4( p_data, p_size );
+            }
+                
+            case xz :
+            {
+                // the dictionary size is reduced to the data size, the compressed size does not change, but
+                // the memory of the stream is smaller, the stream is reinitialized with the reused memory
+                lzma_options_lzma l_options = m_lzmaoptions;
+                l_options.dict_size         = LZMA_DICT_SIZE_MIN;
+                while ( (l_options.dict_size < m_size + p_size) && (l_options.dict_size < m_lzmaoptions.dict_size) )
+                    l_options.dict_size <<= 1;
+                
+                // the LZMA2 data is created without the xz container (raw stream)
+                lzma_filter l_filter[2];
+                l_filter[0].id      = LZMA_FILTER_LZMA2;
+                l_filter[0].options = &l_options;
+                l_filter[1].id      = LZMA_VLI_UNKNOWN;
+                l_filter[1].options = NULL;
+                
+                // small data is compressed again, otherwise the primed data is compressed once and the second data is
+                // compressed with the primed data as preset dictionary (the match finder only indexes the dictionary)
+                if ( (m_size < m_copysize) || (p_size == 0) ) {
+                    if (lzma_raw_encoder(&m_lzma, l_filter) != LZMA_OK)
+                        throw exception::runtime(_("compression stream can not be initialized"));
+                    
+                    compressLzma( m_data, m_size, LZMA_RUN );
+                    compressLzma( p_data, p_size, LZMA_FINISH );
+                    const std::size_t l_size = static_cast<std::size_t>(m_lzma.total_out);
+                    
+                    // we removed the header of the first chunk (control byte, sizes & properties) and the end marker
+                    // @see http://tukaani.org/xz/xz-file-format.txt
+                    return (l_size >= 7) ? l_size - 7 : l_size;
+                }
+                
+                if (!m_primedsize) {
+                    if (lzma_raw_encoder(&m_lzma, l_filter) != LZMA_OK)
+                        throw exception::runtime(_("compression stream can not be initialized"));
+                    
+                    compressLzma( m_data, m_size, LZMA_FINISH );
+                    const std::size_t l_size = static_cast<std::size_t>(m_lzma.total_out);
+                    m_primedsize = (l_size >= 7) ? l_size - 7 : l_size;
+                }
+                
+                // only the last bytes of the dictionary size are used of the preset dictionary
+                const std::size_t l_dictionary = std::min( m_size, static_cast<std::size_t>(l_options.dict_size) );
+                l_options.preset_dict          = reinterpret_cast<const uint8_t*>(m_data + m_size - l_dictionary);
+                l_options.preset_dict_size     = static_cast<uint32_t>(l_dictionary);
+                if (lzma_raw_encoder(&m_lzma, l_filter) != LZMA_OK)
+                    throw exception::runtime(_("compression stream can not be initialized"));
+                
+                compressLzma( p_data, p_size, LZMA_FINISH );
+                const std::size_t l_size = static_cast<std::size_t>(m_lzma.total_out);
+                
+                return m_primedsize + ((l_size >= 7) ? l_size - 7 : l_size);
+            }
+            #endif
         }
-
-        // close deflate stream, cause only than counter returns correct value
-        bio::close(l_deflate);
         
-        return (static_cast<std::size_t>(l_counter.characters()) >= l_removesize) ? l_counter.characters()-l_removesize*sizeof(char) : l_counter.characters();
+        return 0;
     }
     
     
+    /** compresses the concatenation of two buffers and counts the bytes
+     * @param p_data1 first buffer
+     * @param p_size1 size of the first buffer
+     * @param p_data2 second buffer
+     * @param p_size2 size of the second buffer
+     * @return number of compressed bytes (without header & footer)
+     **/
+    template<typename T> inline std::size_t ncd<T>::compressor::deflate( const char* p_data1, const std::size_t& p_size1, const char* p_data2, const std::size_t& p_size2 )
+    {
+        prime( p_data1, p_size1 );
+        return deflate( p_data2, p_size2 );
+    }
+    
+    
+    /** pushes a buffer into a zlib stream, the output is written into the
+     * reused buffer, because only the number of bytes is needed
+     * @param p_stream zlib stream
+     * @param p_data buffer
+     * @param p_size size of the buffer
+     * @param p_flush zlib flush mode
+     **/
+    template<typename T> inline void ncd<T>::compressor::compressZlib( z_stream& p_stream, const char* p_data, const std::size_t& p_size, const int& p_flush )
+    {
+        // the input size of zlib is an unsigned int, so large buffers are split
+        const std::size_t l_maxinput = static_cast<std::size_t>(1) << 30;
+        std::size_t l_pos = 0;
+        
+        do {
+            const std::size_t l_input = std::min(l_maxinput, p_size-l_pos);
+            const int l_flush         = (l_pos+l_input < p_size) ? Z_NO_FLUSH : p_flush;
+            
+            p_stream.next_in  = reinterpret_cast<Bytef*>(const_cast<char*>(p_data)) + l_pos;
+            p_stream.avail_in = static_cast<uInt>(l_input);
+            l_pos            += l_input;
+            
+            int l_status = Z_OK;
+            do {
+                p_stream.next_out  = reinterpret_cast<Bytef*>(&m_buffer[0]);
+                p_stream.avail_out = static_cast<uInt>(m_buffer.size());
+                l_status = ::deflate(&p_stream, l_flush);
+            } while ( (l_status == Z_OK) && ((p_stream.avail_out == 0) || ((l_flush == Z_FINISH) && (l_status != Z_STREAM_END))) );
+            
+            if ( (l_status != Z_OK) && (l_status != Z_STREAM_END) && (l_status != Z_BUF_ERROR) )
+                throw exception::runtime(_("data can not be compressed"));
+            
+        } while (l_pos < p_size);
+    }
+    
+    
+    /** pushes a buffer into the bzip2 stream, the output is written into the
+     * reused buffer, because only the number of bytes is needed
+     * @param p_stream bzip2 stream
+     * @param p_data buffer
+     * @param p_size size of the buffer
+     * @param p_action bzip2 action
+     **/
+    template<typename T> inline void ncd<T>::compressor::compressBzip2( bz_stream& p_stream, const char* p_data, const std::size_t& p_size, const int& p_action )
+    {
+        // bzip2 returns an error, if no data is pushed
+        if ( (p_size == 0) && (p_action == BZ_RUN) )
+            return;
+        
+        // the input size of bzip2 is an unsigned int, so large buffers are split
+        const std::size_t l_maxinput = static_cast<std::size_t>(1) << 30;
+        std::size_t l_pos = 0;
+        
+        do {
+            const std::size_t l_input = std::min(l_maxinput, p_size-l_pos);
+            const int l_action        = (l_pos+l_input < p_size) ? BZ_RUN : p_action;
+            
+            p_stream.next_in  = const_cast<char*>(p_data) + l_pos;
+            p_stream.avail_in = static_cast<unsigned int>(l_input);
+            l_pos            += l_input;
+            
+            int l_status = BZ_RUN_OK;
+            do {
+                p_stream.next_out  = &m_buffer[0];
+                p_stream.avail_out = static_cast<unsigned int>(m_buffer.size());
+                l_status = BZ2_bzCompress(&p_stream, l_action);
+            } while ( ((l_action == BZ_RUN) && (l_status == BZ_RUN_OK) && (p_stream.avail_in > 0)) || ((l_action == BZ_FINISH) && (l_status == BZ_FINISH_OK)) );
+            
+            if ( (l_status != BZ_RUN_OK) && (l_status != BZ_STREAM_END) )
+                throw exception::runtime(_("data can not be compressed"));
+            
+        } while (l_pos < p_size);
+    }
+    
+    
+    #ifdef MACHINELEARNING_COMPRESSION
+    
+    /** pushes a buffer into the zstd context, the output is written into the
+     * reused buffer, because only the number of bytes is needed
+     * @param p_data buffer
+     * @param p_size size of the buffer
+     * @param p_mode zstd end directive
+     * @return number of compressed bytes
+     **/
+    template<typename T> inline std::size_t ncd<T>::compressor::compressZstd( const char* p_data, const std::size_t& p_size, const ZSTD_EndDirective& p_mode )
+    {
+        ZSTD_inBuffer l_input = { p_data, p_size, 0 };
+        std::size_t l_size    = 0;
+        std::size_t l_remain  = 0;
+        
+        do {
+            ZSTD_outBuffer l_output = { &m_buffer[0], m_buffer.size(), 0 };
+            l_remain = ZSTD_compressStream2(m_zstd, &l_output, &l_input, p_mode);
+            if (ZSTD_isError(l_remain))
+                throw exception::runtime(_("data can not be compressed"));
+            
+            l_size += l_output.pos;
+        } while ( (p_mode == ZSTD_e_end) ? (l_remain != 0) : (l_input.pos < l_input.size) );
+        
+        return l_size;
+    }
+    
+    
+    /** compresses a buffer as a LZ4 block of the stream, the previous block must
+     * be unchanged, because it is used as the history
+     * @param p_data buffer
+     * @param p_size size of the buffer
+     * @return number of compressed bytes
+     **/
+    template<typename T> inline std::size_t ncd<T>::compressor::compressLz4( const char* p_data, const std::size_t& p_size )
+    {
+        if (p_size == 0)
+            return 0;
+        if (p_size > static_cast<std::size_t>(LZ4_MAX_INPUT_SIZE))
+            throw exception::runtime(_("data is too large for LZ4"));
+        
+        const int l_bound = LZ4_compressBound( static_cast<int>(p_size) );
+        if (m_buffer.size() < static_cast<std::size_t>(l_bound))
+            m_buffer.resize( static_cast<std::size_t>(l_bound) );
+        
+        const int l_size = m_lz4 ? LZ4_compress_fast_continue(m_lz4, p_data, &m_buffer[0], static_cast<int>(p_size), l_bound, m_level) 
+                                 : LZ4_compress_HC_continue(m_lz4hc, p_data, &m_buffer[0], static_cast<int>(p_size), l_bound);
+        if (l_size <= 0)
+            throw exception::runtime(_("data can not be compressed"));
+        
+        return static_cast<std::size_t>(l_size);
+    }
+    
+    
+    /** pushes a buffer into the xz stream, the output is written into the
+     * reused buffer, because only the number of bytes is needed
+     * @param p_data buffer
+     * @param p_size size of the buffer
+     * @param p_action lzma action
+     **/
+    template<typename T> inline void ncd<T>::compressor::compressLzma( const char* p_data, const std::size_t& p_size, const lzma_action& p_action )
+    {
+        // lzma returns an error, if no data is pushed
+        if ( (p_size == 0) && (p_action == LZMA_RUN) )
+            return;
+        
+        m_lzma.next_in  = reinterpret_cast<const uint8_t*>(p_data);
+        m_lzma.avail_in = p_size;
+        
+        lzma_ret l_status = LZMA_OK;
+        do {
+            m_lzma.next_out  = reinterpret_cast<uint8_t*>(&m_buffer[0]);
+            m_lzma.avail_out = m_buffer.size();
+            l_status = lzma_code(&m_lzma, p_action);
+        } while ( (l_status == LZMA_OK) && ((p_action == LZMA_FINISH) || (m_lzma.avail_in > 0) || (m_lzma.avail_out == 0)) );
+        
+        if ( (l_status != LZMA_OK) && (l_status != LZMA_STREAM_END) )
+            throw exception::runtime(_("data can not be compressed"));
+    }
+    
+    #endif
+    
+    
 }}
 #endif
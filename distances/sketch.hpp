@@ -0,0 +1,294 @@
+/** 
+ @cond
+ ############################################################################
+ # LGPL License                                                             #
+ #                                                                          #
+ # This file is part of the Machine Learning Framework.                     #
+ # Copyright (c) 2010-2012, Philipp Kraus, <philipp.kraus@flashpixx.de>     #
+ # This program is free software: you can redistribute it and/or modify     #
+ # it under the terms of the GNU Lesser General Public License as           #
+ # published by the Free Software Foundation, either version 3 of the       #
+ # License, or (at your option) any later version.                          #
+ #                                                                          #
+ # This program is distributed in the hope that it will be useful,          #
+ # but WITHOUT ANY WARRANTY; without even the implied warranty of           #
+ # MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            #
+ # GNU Lesser General Public License for more details.                      #
+ #                                                                          #
+ # You should have received a copy of the GNU Lesser General Public License #
+ # along with this program. If not, see <http://www.gnu.org/licenses/>.     #
+ ############################################################################
+ @endcond
+ **/
+
+
+
+#ifndef __MACHINELEARNING_DISTANCES_SKETCH_HPP
+#define __MACHINELEARNING_DISTANCES_SKETCH_HPP
+
+#include <omp.h>
+#include <string>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+
+#include <boost/cstdint.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/numeric/ublas/matrix.hpp>
+#include <boost/numeric/ublas/symmetric.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "../errorhandling/exception.hpp"
+#include "../tools/function.hpp"
+#include "../tools/communication/communication.h"
+
+
+
+
+namespace machinelearning { namespace distances {   
+    
+    #ifndef SWIG
+    namespace ublas = boost::numeric::ublas;
+    namespace bio   = boost::iostreams;
+    #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
+    namespace mpi   = machinelearning::tools::communication;
+    #endif
+    #endif
+    
+    
+    /**
+     * abstract class for distances of strings or files, that are approximated by sketches.
+     * Each element is processed once into a compact sketch (vector of hash values), so the
+     * distance of a pair needs only the sketches and not the data. The matrices have the
+     * same structure like the matrices of the NCD
+     **/
+    template<typename T> class sketch
+    {
+        #ifndef SWIG
+        BOOST_STATIC_ASSERT( !boost::is_integral<T>::value );
+        #endif
+        
+        
+        public:
+            
+            ublas::matrix<T> unsquare ( const std::vector<std::string>&, const std::vector<std::string>&, const bool& = false ) const;
+            ublas::matrix<T> unsymmetric ( const std::vector<std::string>&, const bool& = false ) const;
+            ublas::symmetric_matrix<T, ublas::upper> symmetric ( const std::vector<std::string>&, const bool& = false ) const;
+            T calculate ( const std::string&, const std::string&, const bool& = false ) const;
+            
+            #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
+            ublas::matrix<T> unsquare ( const mpi::communicator&, const std::vector<std::string>&, const bool& = false ) const;
+            #endif
+            
+            virtual ~sketch( void ) {}
+            
+            
+        protected:
+            
+            /** creates the sketch of the data **/
+            virtual std::vector<boost::uint64_t> create( const char*, const std::size_t& ) const = 0;
+            
+            /** returns the distance of two sketches **/
+            virtual T distance( const std::vector<boost::uint64_t>&, const std::vector<boost::uint64_t>& ) const = 0;
+            
+        private:
+            
+            std::vector< std::vector<boost::uint64_t> > sketches( const std::vector<std::string>&, const bool& ) const;
+            std::vector<boost::uint64_t> sketches( const std::string&, const bool& ) const;
+        
+    };
+    
+    
+    
+    /** calculate the distance between two strings
+     * @param p_str1 first string
+     * @param p_str2 second string
+     * @param p_isfile parameter for interpreting the string as a file with path
+     * @return distance value
+     **/
+    template<typename T> inline T sketch<T>::calculate( const std::string& p_str1, const std::string& p_str2, const bool& p_isfile ) const
+    {
+        return distance( sketches(p_str1, p_isfile), sketches(p_str2, p_isfile) );
+    }
+    
+    
+    /** calculate all distances of the string vector (first item in the vector is
+     * first row and colum in the returning matrix)
+     * @param p_strvec string vector
+     * @param p_isfile parameter for interpreting the string as a file with path
+     * @return dissimilarity matrix with std::vector x std::vector elements
+     **/
+    template<typename T> inline ublas::matrix<T> sketch<T>::unsymmetric( const std::vector<std::string>& p_strvec, const bool& p_isfile ) const
+    {
+        if (p_strvec.size() == 0)
+            throw exception::runtime(_("vector size must be greater than zero"), *this);
+        
+        const std::vector< std::vector<boost::uint64_t> > l_sketch = sketches(p_strvec, p_isfile);
+        ublas::matrix<T> l_result( p_strvec.size(), p_strvec.size() );
+        
+        #pragma omp parallel for schedule(dynamic) shared(l_result)
+        for(std::size_t i=0; i < l_sketch.size(); ++i)
+            for(std::size_t j=0; j < l_sketch.size(); ++j)
+                l_result(i,j) = (i == j) ? static_cast<T>(0) : distance( l_sketch[i], l_sketch[j] );
+        
+        return l_result;
+    }
+    
+    
+    /** calculate all distances of the string vector (first item in the vector is
+     * first row and colum in the returning matrix)
+     * @param p_strvec string vector
+     * @param p_isfile parameter for interpreting the string as a file with path
+     * @return symmetric dissimilarity matrix with std::vector x std::vector elements
+     **/
+    template<typename T> inline ublas::symmetric_matrix<T, ublas::upper> sketch<T>::symmetric( const std::vector<std::string>& p_strvec, const bool& p_isfile ) const
+    {
+        if (p_strvec.size() == 0)
+            throw exception::runtime(_("vector size must be greater than zero"), *this);
+        
+        const std::vector< std::vector<boost::uint64_t> > l_sketch = sketches(p_strvec, p_isfile);
+        ublas::symmetric_matrix<T, ublas::upper> l_result( p_strvec.size(), p_strvec.size() );
+        
+        // the distance of two sketches is symmetric, so only the upper triangle is calculated
+        #pragma omp parallel for schedule(dynamic) shared(l_result)
+        for(std::size_t i=0; i < l_sketch.size(); ++i) {
+            l_result(i,i) = static_cast<T>(0);
+            for(std::size_t j=i+1; j < l_sketch.size(); ++j)
+                l_result(i,j) = distance( l_sketch[i], l_sketch[j] );
+        }
+        
+        return l_result;
+    }
+    
+    
+    /** calculate all distances between each element of both string vectors
+     * @param p_strvec1 first string vector (rows)
+     * @param p_strvec2 second string vector (columns)
+     * @param p_isfile parameter for interpreting the string as a file with path
+     * @return dissimilarity matrix with std::vector1 x std::vector2 elements
+     **/
+    template<typename T> inline ublas::matrix<T> sketch<T>::unsquare( const std::vector<std::string>& p_strvec1, const std::vector<std::string>& p_strvec2, const bool& p_isfile ) const
+    {
+        if ((p_strvec1.size() == 0) || (p_strvec2.size() == 0))
+            throw exception::runtime(_("vector size must be greater than zero"), *this);
+        
+        const std::vector< std::vector<boost::uint64_t> > l_rows    = sketches(p_strvec1, p_isfile);
+        const std::vector< std::vector<boost::uint64_t> > l_columns = sketches(p_strvec2, p_isfile);
+        ublas::matrix<T> l_result( p_strvec1.size(), p_strvec2.size() );
+        
+        #pragma omp parallel for schedule(dynamic) shared(l_result)
+        for(std::size_t i=0; i < l_rows.size(); ++i)
+            for(std::size_t j=0; j < l_columns.size(); ++j)
+                l_result(i,j) = distance( l_rows[i], l_columns[j] );
+        
+        return l_result;
+    }
+    
+    
+    /** creates the sketch of every element
+     * @param p_strvec string vector
+     * @param p_isfile parameter for interpreting the string as a file with path
+     * @return vector with the sketches
+     **/
+    template<typename T> inline std::vector< std::vector<boost::uint64_t> > sketch<T>::sketches( const std::vector<std::string>& p_strvec, const bool& p_isfile ) const
+    {
+        std::vector< std::vector<boost::uint64_t> > l_sketch( p_strvec.size() );
+        
+        // an unreadable element must not terminate the program within the loop, so the first error is thrown afterwards
+        std::string l_error;
+        
+        #pragma omp parallel for schedule(dynamic) shared(l_sketch, l_error)
+        for(std::size_t i=0; i < p_strvec.size(); ++i) {
+            try {
+                l_sketch[i] = sketches( p_strvec[i], p_isfile );
+            } catch (const std::exception& e) {
+                #pragma omp critical (sketch_error)
+                if (l_error.empty())
+                    l_error = e.what();
+            } catch (...) {
+                #pragma omp critical (sketch_error)
+                if (l_error.empty())
+                    l_error = _("unknown error on creating a sketch");
+            }
+        }
+        
+        if (!l_error.empty())
+            throw exception::runtime(l_error);
+        
+        return l_sketch;
+    }
+    
+    
+    /** creates the sketch of a string or a file, files are mapped into the memory
+     * @param p_str string or filename
+     * @param p_isfile bool for interpret input string like filenames
+     * @return sketch
+     **/
+    template<typename T> inline std::vector<boost::uint64_t> sketch<T>::sketches( const std::string& p_str, const bool& p_isfile ) const
+    {
+        if (p_str.empty())
+            throw exception::runtime(_("string size must be greater than zero"), *this);
+        
+        if (!p_isfile)
+            return create( p_str.data(), p_str.size() );
+        
+        bio::mapped_file_source l_file;
+        try {
+            l_file.open( p_str );
+        } catch (...) {
+            throw exception::runtime(_("file can not be opened"), *this);
+        }
+        
+        return create( l_file.data(), l_file.size() );
+    }
+    
+    
+    
+    #if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
+    
+    /** creates a distance matrix with shared data, only the sketches are sent,
+     * so the data is processed only by the CPU, that holds it
+     * @param p_mpi MPI object
+     * @param p_strvec local dataset
+     * @param p_isfile parameter for interpreting the string as a file with path
+     * @return part of distance matrix (all data size x local data size)
+     **/
+    template<typename T> inline ublas::matrix<T> sketch<T>::unsquare( const mpi::communicator& p_mpi, const std::vector<std::string>& p_strvec, const bool& p_isfile ) const
+    {
+        if (p_strvec.size() == 0)
+            throw exception::runtime(_("vector size must be greater than zero"), *this);
+        
+        const std::vector< std::vector<boost::uint64_t> > l_local = sketches(p_strvec, p_isfile);
+        
+        std::vector< std::vector< std::vector<boost::uint64_t> > > l_all;
+        mpi::all_gather(p_mpi, l_local, l_all);
+        
+        // the local data starts at the row of the sum of the data of the CPUs before
+        std::size_t l_rows     = 0;
+        std::size_t l_localrow = 0;
+        for(std::size_t i=0; i < l_all.size(); ++i) {
+            if (i == static_cast<std::size_t>(p_mpi.rank()))
+                l_localrow = l_rows;
+            l_rows += l_all[i].size();
+        }
+        
+        std::vector< std::vector<boost::uint64_t> > l_rowsketch;
+        l_rowsketch.reserve( l_rows );
+        for(std::size_t i=0; i < l_all.size(); ++i)
+            l_rowsketch.insert( l_rowsketch.end(), l_all[i].begin(), l_all[i].end() );
+        
+        ublas::matrix<T> l_result( l_rows, p_strvec.size() );
+        
+        #pragma omp parallel for schedule(dynamic) shared(l_result)
+        for(std::size_t i=0; i < l_rowsketch.size(); ++i)
+            for(std::size_t j=0; j < l_local.size(); ++j)
+                l_result(i,j) = (i == l_localrow + j) ? static_cast<T>(0) : distance( l_rowsketch[i], l_local[j] );
+        
+        return l_result;
+    }
+    
+    #endif
+    
+    
+}}
+#endif
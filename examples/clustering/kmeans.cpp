@@ -27,6 +27,9 @@
 #include <boost/program_options/parsers.hpp>
 #include <boost/program_options/variables_map.hpp>
 #include <boost/program_options/options_description.hpp>
+#ifdef MACHINELEARNING_MPI
+#include <boost/mpi.hpp>
+#endif
 
 
 namespace po        = boost::program_options;
@@ -34,6 +37,9 @@ namespace ublas     = boost::numeric::ublas;
 namespace cluster   = machinelearning::clustering::nonsupervised;
 namespace distance  = machinelearning::distances;
 namespace tools     = machinelearning::tools;
+#ifdef MACHINELEARNING_MPI
+namespace mpi       = boost::mpi;
+#endif
 
 
 /** main program
@@ -42,6 +48,11 @@ namespace tools     = machinelearning::tools;
  **/
 int main(int p_argc, char* p_argv[])
 {
+    #ifdef MACHINELEARNING_MPI
+    mpi::environment l_mpienv(p_argc, p_argv);
+    mpi::communicator l_mpicom;
+    #endif
+    
     #ifdef MACHINELEARNING_MULTILANGUAGE
     tools::language::bindings::bind();
     #endif
@@ -55,9 +66,15 @@ int main(int p_argc, char* p_argv[])
     l_description.add_options()
         ("help", "produce help message")
         ("outfile", po::value<std::string>(), "output HDF5 file")
+        #ifdef MACHINELEARNING_MPI
+        ("inputfile", po::value< std::vector<std::string> >()->multitoken(), "input HDF5 file")
+        ("inputpath", po::value< std::vector<std::string> >()->multitoken(), "path to dataset")
+        ("prototype", po::value< std::vector<std::size_t> >()->multitoken(), "number of prototypes")
+        #else
         ("inputfile", po::value<std::string>(), "input HDF5 file")
         ("inputpath", po::value<std::string>(), "path to dataset")
         ("prototype", po::value<std::size_t>(), "number of prototypes")
+        #endif
         ("iteration", po::value<std::size_t>(&l_iteration)->default_value(15), "number of iteration [default: 15]")
         ("log", po::value<bool>(&l_log)->default_value(false), "'true' for enable logging [default: false]")
     ;
@@ -80,11 +97,68 @@ int main(int p_argc, char* p_argv[])
 
 
 
+    #ifdef MACHINELEARNING_MPI
+    if(!(
+         ((l_map["inputfile"].as< std::vector<std::string> >().size() == static_cast<std::size_t>(l_mpicom.size())) && (l_map["inputpath"].as< std::vector<std::string> >().size() == 1)) ||
+         ((l_map["inputpath"].as< std::vector<std::string> >().size() == static_cast<std::size_t>(l_mpicom.size())) && (l_map["inputfile"].as< std::vector<std::string> >().size() == 1)) ||
+         ((l_map["inputpath"].as< std::vector<std::string> >().size() == static_cast<std::size_t>(l_mpicom.size())) && (l_map["inputfile"].as< std::vector<std::string> >().size() == static_cast<std::size_t>(l_mpicom.size())))
+         ))
+        throw std::runtime_error("number of files or number of path must be equal to CPU rank");
+    
+    if (l_map["prototype"].as< std::vector<std::size_t> >().size() != static_cast<std::size_t>(l_mpicom.size()))
+        throw std::runtime_error("number of prototypes must be equal to CPU rank");
+    #endif
+    
+    
+
     // read source hdf file and data
+    #ifdef MACHINELEARNING_MPI
+    const std::size_t l_filepos = l_map["inputfile"].as< std::vector<std::string> >().size() > 1 ? static_cast<std::size_t>(l_mpicom.rank()) : 0;
+    const std::size_t l_pathpos = l_map["inputpath"].as< std::vector<std::string> >().size() > 1 ? static_cast<std::size_t>(l_mpicom.rank()) : 0;
+    
+    tools::files::hdf l_source( l_map["inputfile"].as< std::vector<std::string> >()[l_filepos] );
+    ublas::matrix<double> l_data = l_source.readBlasMatrix<double>( l_map["inputpath"].as< std::vector<std::string> >()[l_pathpos], tools::files::hdf::NATIVE_DOUBLE);
+    #else
     tools::files::hdf l_source( l_map["inputfile"].as<std::string>() );
     ublas::matrix<double> l_data = l_source.readBlasMatrix<double>( l_map["inputpath"].as<std::string>(), tools::files::hdf::NATIVE_DOUBLE);
+    #endif
 
 
+    #ifdef MACHINELEARNING_MPI
+    // each process trains with its data and owns its prototypes
+    cluster::kmeans<double> l_kmeans(distance::norm::euclid<double>(), l_map["prototype"].as< std::vector<std::size_t> >()[static_cast<std::size_t>(l_mpicom.rank())], l_data.size2());
+    l_kmeans.setLogging(l_log);
+    
+    l_kmeans.train(l_mpicom, l_data, l_iteration);
+    
+    // collect all data (of each process)
+    ublas::matrix<double> l_protos = l_kmeans.getPrototypes(l_mpicom);
+    ublas::vector<double> l_qerror;
+    std::vector< ublas::matrix<double> > l_logproto;
+    
+    if (l_kmeans.getLogging()) {
+        l_qerror      = tools::vector::copy(l_kmeans.getLoggedQuantizationError(l_mpicom));
+        l_logproto    = l_kmeans.getLoggedPrototypes(l_mpicom);
+    }
+    
+    
+    // only process 0 writes hdf
+    if (l_mpicom.rank() == 0) {
+        tools::files::hdf target(l_map["outfile"].as<std::string>(), true);
+        
+        target.writeBlasMatrix<double>( "/protos",  l_protos, tools::files::hdf::NATIVE_DOUBLE );
+        target.writeValue<std::size_t>( "/numprotos",  l_protos.size1(), tools::files::hdf::NATIVE_ULONG );
+        target.writeValue<std::size_t>( "/iteration",  l_iteration, tools::files::hdf::NATIVE_ULONG );
+        
+        if (l_kmeans.getLogging()) {
+            target.writeBlasVector<double>( "/error",  l_qerror, tools::files::hdf::NATIVE_DOUBLE );
+            for(std::size_t i=0; i < l_logproto.size(); ++i)
+                target.writeBlasMatrix<double>("/log" + boost::lexical_cast<std::string>( i )+"/protos", l_logproto[i], tools::files::hdf::NATIVE_DOUBLE );
+        }
+    }
+    
+    #else
+    
     // create distance object, k-means object and enable logging
     cluster::kmeans<double> l_kmeans(distance::norm::euclid<double>(), l_map["prototype"].as<std::size_t>(), l_data.size2());
     l_kmeans.setLogging(l_log);
@@ -108,6 +182,12 @@ int main(int p_argc, char* p_argv[])
             target.writeBlasMatrix<double>("/log" + boost::lexical_cast<std::string>( i )+"/protos", l_logproto[i], tools::files::hdf::NATIVE_DOUBLE );
     }
 
+    #endif
+
+
+    #ifdef MACHINELEARNING_MPI
+    if (l_mpicom.rank() == 0) {
+    #endif
 
     std::cout << "structure of the output file" << std::endl;
     std::cout << "/numprotos \t\t number of prototypes" << std::endl;
@@ -119,5 +199,9 @@ int main(int p_argc, char* p_argv[])
         std::cout << "/log<0 to number of iteration-1>/protosos \t\t prototypes on each iteration" << std::endl;
     }
 
+    #ifdef MACHINELEARNING_MPI
+    }
+    #endif
+
     return EXIT_SUCCESS;
 }
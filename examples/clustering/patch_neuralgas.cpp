@@ -139,13 +139,13 @@ int main(int p_argc, char* p_argv[])
     if (l_mpicom.rank() == 0)
         l_target = new tools::files::hdf( l_map["outfile"].as<std::string>(), true );
 
-    // do each patch
-    for (std::size_t i=0; i < l_map["inputpath"].as< std::vector<std::string> >().size(); ++i) {
+    // do each patch (the next patch is read while the current patch is trained)
+    const cluster::hdfpatchsource<double> l_patches( l_source.getFilename(), l_map["inputpath"].as< std::vector<std::string> >() );
+    cluster::patchtrainer<double> l_trainer( l_patches );
+    while (l_trainer.hasNext()) {
 
-        l_ng.trainpatch( l_mpicom,
-                       l_source.readBlasMatrix<double>( l_map["inputpath"].as< std::vector<std::string> >()[i], tools::files::hdf::NATIVE_DOUBLE),
-                       l_iteration
-                     );
+        const std::size_t i = l_trainer.getPatchIndex();
+        l_trainer.trainpatch( l_mpicom, l_ng, l_iteration );
 
         ublas::vector<double> l_weights                  = l_ng.getPrototypeWeights(l_mpicom);
         ublas::matrix<double> l_protos                   = l_ng.getPrototypes(l_mpicom);
@@ -184,12 +184,13 @@ int main(int p_argc, char* p_argv[])
     //create target file
     tools::files::hdf l_target( l_map["outfile"].as<std::string>(), true );
 
-    // do each patch
-    for (std::size_t i=0; i < l_map["inputpath"].as< std::vector<std::string> >().size(); ++i) {
-        l_ng.trainpatch(
-                       l_source.readBlasMatrix<double>( l_map["inputpath"].as< std::vector<std::string> >()[i], tools::files::hdf::NATIVE_DOUBLE),
-                       l_iteration
-                     );
+    // do each patch (the next patch is read while the current patch is trained)
+    const cluster::hdfpatchsource<double> l_patches( l_source.getFilename(), l_map["inputpath"].as< std::vector<std::string> >() );
+    cluster::patchtrainer<double> l_trainer( l_patches );
+    while (l_trainer.hasNext()) {
+
+        const std::size_t i = l_trainer.getPatchIndex();
+        l_trainer.trainpatch( l_ng, l_iteration );
 
         std::string l_patchpath = "/patch" + boost::lexical_cast<std::string>(i);
         l_target.writeBlasVector<double>( l_patchpath+"/weights",  l_ng.getPrototypeWeights(), tools::files::hdf::NATIVE_DOUBLE );
@@ -23,6 +23,7 @@
 
 #include <cstdlib>
 #include <machinelearning.h>
+#include <boost/filesystem.hpp>
 #include <boost/numeric/ublas/matrix.hpp>
 #include <boost/program_options/parsers.hpp>
 #include <boost/program_options/variables_map.hpp>
@@ -34,6 +35,19 @@ using namespace boost::numeric;
 using namespace machinelearning;
 
 
+/** calculates the distance matrix of the files
+ * @param p_distance distance object
+ * @param p_sources filenames
+ * @param p_matrix structure of the matrix
+ * @return distance matrix
+ **/
+template<typename D> ublas::matrix<double> distancematrix( const D& p_distance, const std::vector<std::string>& p_sources, const std::string& p_matrix )
+{
+    if (p_matrix == "unsymmetric")
+        return p_distance.unsymmetric( p_sources, true );
+    return p_distance.symmetric( p_sources, true );
+}
+
 /** main program
  * @param p_argc number of arguments
  * @param p_argv arguments
@@ -45,9 +59,12 @@ int main(int p_argc, char* p_argv[])
     #endif
     
     // default values
+    std::string l_distance;
     std::string l_compress;
     std::string l_algorithm;
     std::string l_matrix;
+    std::size_t l_sketch;
+    std::size_t l_ngram;
 
     // create CML options with description
     po::options_description l_description("allowed options");
@@ -55,9 +72,15 @@ int main(int p_argc, char* p_argv[])
         ("help", "produce help message")
         ("outfile", po::value<std::string>(), "output HDF5 file")
         ("sources", po::value< std::vector<std::string> >()->multitoken(), "list of text files or directories with text files (all files in the directory will be read and subdirectories will be ignored)")
-        ("compress", po::value<std::string>(&l_compress)->default_value("default"), "compression level (allowed values are: default [default], bestspeed or bestcompression)")
-        ("algorithm", po::value<std::string>(&l_algorithm)->default_value("gzip"), "compression algorithm (allowed values are: gzip [default], bzip)")
+        ("distance", po::value<std::string>(&l_distance)->default_value("ncd"), "distance measure (allowed values are: ncd [default], cdm, lzjd or minhash)")
+        ("compress", po::value<std::string>(&l_compress)->default_value("default"), "compression level of ncd and cdm (allowed values are: default [default], bestspeed or bestcompression)")
+        ("algorithm", po::value<std::string>(&l_algorithm)->default_value("gzip"), "compression algorithm of ncd and cdm (allowed values are: gzip [default], bzip, zstd, lz4, xz)")
+        ("dictionary", po::value<std::size_t>(), "number of sources, that are used for training a zstd dictionary")
+        ("cache", po::value<std::string>(), "HDF file with cached compression sizes (the file is read, if it exists, and written after the calculation)")
+        ("sketch", po::value<std::size_t>(&l_sketch)->default_value(256), "number of hash values of a lzjd or minhash sketch (empty bins of a minhash sketch, e.g. of a file with less n-grams than bins, are filled by densification)")
+        ("ngram", po::value<std::size_t>(&l_ngram)->default_value(4), "number of bytes of a minhash n-gram")
         ("matrix", po::value<std::string>(&l_matrix)->default_value("symmetric"), "structure of the matrix (allowed values are: symmetric [default] or unsymmetric")
+        ("stream", "the finished blocks are written directly into the output file without holding the matrix (an interrupted calculation is resumed with the existing output file)")
     ;
 
     po::variables_map l_map;
@@ -74,23 +97,99 @@ int main(int p_argc, char* p_argv[])
         std::cerr << "[--sources] must be set" << std::endl;
         return EXIT_FAILURE;
     }
+    
+    if ( (l_distance != "ncd") && (l_distance != "cdm") && (l_distance != "lzjd") && (l_distance != "minhash") ) {
+        std::cerr << "[--distance] must be ncd, cdm, lzjd or minhash" << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    // the sketch distances do not compress the data, so there are no compression sizes and no blocks
+    const bool l_sketchdistance = (l_distance == "lzjd") || (l_distance == "minhash");
+    if ( l_sketchdistance && (l_map.count("dictionary") || l_map.count("cache") || l_map.count("stream")) ) {
+        std::cerr << "[--dictionary], [--cache] and [--stream] can be used with ncd or cdm only" << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    if ( (l_map.count("stream")) && (!l_map.count("outfile")) ) {
+        std::cerr << "[--stream] needs [--outfile]" << std::endl;
+        return EXIT_FAILURE;
+    }
 
-
-
-    // create ncd object
-    distances::ncd<double> l_ncd( (l_algorithm == "gzip") ? distances::ncd<double>::gzip : distances::ncd<double>::bzip2 );
-    if (l_compress == "bestspeed")
-        l_ncd.setCompressionLevel( distances::ncd<double>::bestspeed );
-    if (l_compress == "bestcompression")
-        l_ncd.setCompressionLevel( distances::ncd<double>::bestcompression );
-
-
-    // create the distance matrix and use the each element of the vector as a filename
+    
+    const std::vector<std::string>& l_sources = l_map["sources"].as< std::vector<std::string> >();
     ublas::matrix<double> l_distancematrix;
-    if (l_matrix == "unsymmetric")
-        l_distancematrix = l_ncd.unsymmetric( l_map["sources"].as< std::vector<std::string> >(), true);
-    else
-        l_distancematrix = l_ncd.symmetric( l_map["sources"].as< std::vector<std::string> >(), true);
+    
+    if (l_distance == "lzjd")
+        l_distancematrix = distancematrix( distances::lzjd<double>(l_sketch), l_sources, l_matrix );
+    
+    if (l_distance == "minhash")
+        l_distancematrix = distancematrix( distances::minhash<double>(l_ngram, l_sketch), l_sources, l_matrix );
+    
+    if (!l_sketchdistance) {
+    
+        // create ncd or cdm object
+        distances::ncd<double>::compresstype l_type = distances::ncd<double>::gzip;
+        if (l_algorithm == "bzip")
+            l_type = distances::ncd<double>::bzip2;
+        #ifdef MACHINELEARNING_COMPRESSION
+        if (l_algorithm == "zstd")
+            l_type = distances::ncd<double>::zstd;
+        if (l_algorithm == "lz4")
+            l_type = distances::ncd<double>::lz4;
+        if (l_algorithm == "xz")
+            l_type = distances::ncd<double>::xz;
+        #endif
+        
+        distances::ncd<double> l_ncdobject( l_type );
+        distances::cdm<double> l_cdmobject( l_type );
+        distances::ncd<double>& l_ncd = (l_distance == "cdm") ? l_cdmobject : l_ncdobject;
+        
+        if (l_compress == "bestspeed")
+            l_ncd.setCompressionLevel( distances::ncd<double>::bestspeed );
+        if (l_compress == "bestcompression")
+            l_ncd.setCompressionLevel( distances::ncd<double>::bestcompression );
+        
+        #ifdef MACHINELEARNING_COMPRESSION
+        // the dictionary is trained with the first sources
+        if ( (l_type == distances::ncd<double>::zstd) && l_map.count("dictionary") )
+            l_ncd.trainDictionary( std::vector<std::string>( l_sources.begin(), l_sources.begin() + std::min(l_sources.size(), l_map["dictionary"].as<std::size_t>()) ), true );
+        #endif
+        
+        if (l_map.count("cache")) {
+            if (boost::filesystem::exists(l_map["cache"].as<std::string>()))
+                l_ncd.loadCache( l_map["cache"].as<std::string>() );
+            else
+                l_ncd.setCaching(true);
+        }
+
+
+        // write the blocks of the distance matrix into the output file
+        if (l_map.count("stream")) {
+            const bool l_resume = boost::filesystem::exists(l_map["outfile"].as<std::string>());
+            
+            tools::files::hdf file(l_map["outfile"].as<std::string>(), !l_resume);
+            distances::ncd<double>::hdfwriter l_writer(file, "/"+l_distance, l_sources.size(), l_sources.size(), tools::files::hdf::NATIVE_DOUBLE, l_matrix != "unsymmetric");
+            if (l_matrix == "unsymmetric")
+                l_ncd.unsymmetric( l_sources, l_writer, true );
+            else
+                l_ncd.symmetric( l_sources, l_writer, true );
+            
+            if (l_map.count("cache"))
+                l_ncd.saveCache( l_map["cache"].as<std::string>() );
+            
+            std::cout << "structure of the output file" << std::endl;
+            std::cout << "/" << l_distance << "\t\t" << "distance matrix" << std::endl;
+            std::cout << "/" << l_distance << "_blocks" << "\t" << "marks of the finished blocks" << std::endl;
+            return EXIT_SUCCESS;
+        }
+        
+        
+        // create the distance matrix and use the each element of the vector as a filename
+        l_distancematrix = distancematrix( l_ncd, l_sources, l_matrix );
+        
+        if (l_map.count("cache"))
+            l_ncd.saveCache( l_map["cache"].as<std::string>() );
+    }
 
 
     if (!l_map.count("outfile"))
@@ -98,9 +197,9 @@ int main(int p_argc, char* p_argv[])
     else {
         // create hdf file and write data
         tools::files::hdf file(l_map["outfile"].as<std::string>(), true);
-        file.writeBlasMatrix<double>( "/ncd",  l_distancematrix, tools::files::hdf::NATIVE_DOUBLE );
+        file.writeBlasMatrix<double>( "/"+l_distance,  l_distancematrix, tools::files::hdf::NATIVE_DOUBLE );
         std::cout << "structure of the output file" << std::endl;
-        std::cout << "/ncd" << "\t\t" << "distance matrix" << std::endl;
+        std::cout << "/" << l_distance << "\t\t" << "distance matrix" << std::endl;
     }
 
     return EXIT_SUCCESS;
@@ -34,6 +34,9 @@ if env["withfiles"] :
         buildlist.append( env.Program( target=os.path.join("#build", env["buildtype"], "other", "mds_wikipedia"), source=defaultcpp+["mds_wikipedia.cpp"] ) )
         buildlist.append( env.Program( target=os.path.join("#build", env["buildtype"], "other", "mds_twitter"), source=defaultcpp+["mds_twitter.cpp"] ) )
         
+if env["withmpi"] or env["withsharedmemory"] :
+    buildlist.append( env.Program( target=os.path.join("#build", env["buildtype"], "other", "communication"), source=defaultcpp+["communication.cpp"] ) )
+        
 if env["uselocallibrary"] or env["copylibrary"] :
     Depends(buildlist, env.LibraryCopy( os.path.join("#build", env["buildtype"], "other"), [] ))
 
@@ -0,0 +1,278 @@
+/**
+ @cond
+ ############################################################################
+ # LGPL License                                                             #
+ #                                                                          #
+ # This file is part of the Machine Learning Framework.                     #
+ # Copyright (c) 2010-2012, Philipp Kraus, <philipp.kraus@flashpixx.de>     #
+ # This program is free software: you can redistribute it and/or modify     #
+ # it under the terms of the GNU Lesser General Public License as           #
+ # published by the Free Software Foundation, either version 3 of the       #
+ # License, or (at your option) any later version.                          #
+ #                                                                          #
+ # This program is distributed in the hope that it will be useful,          #
+ # but WITHOUT ANY WARRANTY; without even the implied warranty of           #
+ # MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            #
+ # GNU Lesser General Public License for more details.                      #
+ #                                                                          #
+ # You should have received a copy of the GNU Lesser General Public License #
+ # along with this program. If not, see <http://www.gnu.org/licenses/>.     #
+ ############################################################################
+ @endcond
+ **/
+
+#include <cstdlib>
+#include <vector>
+#include <iostream>
+#include <functional>
+#include <unistd.h>
+#include <machinelearning.h>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/program_options/parsers.hpp>
+#include <boost/program_options/variables_map.hpp>
+#include <boost/program_options/options_description.hpp>
+#ifdef MACHINELEARNING_MPI
+#include <boost/mpi.hpp>
+#endif
+
+
+
+namespace po        = boost::program_options;
+namespace ptime     = boost::posix_time;
+namespace tools     = machinelearning::tools;
+namespace com       = machinelearning::tools::communication;
+#ifdef MACHINELEARNING_MPI
+namespace mpi       = boost::mpi;
+#endif
+
+
+
+/** result of the benchmark of one backend **/
+struct result
+{
+    /** reduced array **/
+    std::vector<double> reduce;
+    /** gathered array **/
+    std::vector<double> gather;
+    /** seconds of all reductions **/
+    double reducetime;
+    /** seconds of all gatherings **/
+    double gathertime;
+};
+
+
+
+/** returns the value of an element of a process, the values are integral, so the sum
+ * does not depend on the reduction order and all backends must create the same result
+ * @param p_rank rank of the process
+ * @param p_index index of the element
+ * @return value
+ **/
+inline double value( const std::size_t& p_rank, const std::size_t& p_index )
+{
+    return static_cast<double>( (p_rank+1) * (p_index % 1024) );
+}
+
+
+/** creates the counts and displacements of the gathering, each process sends a different number of elements
+ * @param p_elements number of elements
+ * @param p_size number of processes
+ * @param p_counts number of elements of each process
+ * @param p_displacements offsets of the process arrays
+ **/
+inline void layout( const std::size_t& p_elements, const std::size_t& p_size, std::vector<int>& p_counts, std::vector<int>& p_displacements )
+{
+    p_counts.resize(p_size);
+    p_displacements.resize(p_size);
+    for(std::size_t i=0; i < p_size; ++i) {
+        p_counts[i]        = static_cast<int>(p_elements / p_size + i);
+        p_displacements[i] = (i == 0) ? 0 : p_displacements[i-1] + p_counts[i-1];
+    }
+}
+
+
+/** runs the non-blocking reduction and gathering
+ * @param p_com communicator
+ * @param p_elements number of elements
+ * @param p_iteration number of repetitions
+ * @return result
+ **/
+inline result benchmark( const com::communicator& p_com, const std::size_t& p_elements, const std::size_t& p_iteration )
+{
+    const std::size_t l_rank = static_cast<std::size_t>(p_com.rank());
+    const std::size_t l_size = static_cast<std::size_t>(p_com.size());
+    
+    std::vector<double> l_data( p_elements + l_size );
+    for(std::size_t i=0; i < l_data.size(); ++i)
+        l_data[i] = value(l_rank, i);
+    
+    result l_result;
+    l_result.reduce.resize(p_elements);
+    
+    p_com.barrier();
+    ptime::ptime l_start = ptime::microsec_clock::universal_time();
+    for(std::size_t i=0; i < p_iteration; ++i) {
+        com::request l_request = com::iall_reduce(p_com, &l_data[0], static_cast<int>(p_elements), &l_result.reduce[0], std::plus<double>());
+        l_request.wait();
+    }
+    l_result.reducetime = (ptime::microsec_clock::universal_time() - l_start).total_microseconds() * 1e-6;
+    
+    std::vector<int> l_counts;
+    std::vector<int> l_displacements;
+    layout(p_elements, l_size, l_counts, l_displacements);
+    l_result.gather.resize( static_cast<std::size_t>(l_displacements.back() + l_counts.back()) );
+    
+    p_com.barrier();
+    l_start = ptime::microsec_clock::universal_time();
+    for(std::size_t i=0; i < p_iteration; ++i) {
+        com::request l_request = com::iall_gatherv(p_com, &l_data[0], l_counts[l_rank], &l_result.gather[0], l_counts, l_displacements);
+        l_request.wait();
+    }
+    l_result.gathertime = (ptime::microsec_clock::universal_time() - l_start).total_microseconds() * 1e-6;
+    
+    return l_result;
+}
+
+
+/** checks the result against the expected values
+ * @param p_result result
+ * @param p_elements number of elements
+ * @param p_size number of processes
+ * @return boolean of the check
+ **/
+inline bool check( const result& p_result, const std::size_t& p_elements, const std::size_t& p_size )
+{
+    for(std::size_t i=0; i < p_elements; ++i)
+        if (p_result.reduce[i] != value(0, i) * static_cast<double>(p_size * (p_size+1) / 2))
+            return false;
+    
+    std::vector<int> l_counts;
+    std::vector<int> l_displacements;
+    layout(p_elements, p_size, l_counts, l_displacements);
+    for(std::size_t i=0; i < p_size; ++i)
+        for(std::size_t j=0; j < static_cast<std::size_t>(l_counts[i]); ++j)
+            if (p_result.gather[static_cast<std::size_t>(l_displacements[i])+j] != value(i, j))
+                return false;
+    
+    return true;
+}
+
+
+/** prints the throughput of a backend
+ * @param p_name name of the backend
+ * @param p_result result
+ * @param p_elements number of elements
+ * @param p_size number of processes
+ * @param p_iteration number of repetitions
+ **/
+inline void print( const std::string& p_name, const result& p_result, const std::size_t& p_elements, const std::size_t& p_size, const std::size_t& p_iteration )
+{
+    const double l_reduce = static_cast<double>(p_iteration * p_elements * sizeof(double)) / 1048576.0;
+    const double l_gather = static_cast<double>(p_iteration * p_result.gather.size() * sizeof(double)) / 1048576.0;
+    
+    std::cout << p_name << " backend with " << p_size << " processes" << std::endl;
+    std::cout << "    iall_reduce  : " << l_reduce / p_result.reducetime << " MB/s (" << p_result.reducetime << " s)" << std::endl;
+    std::cout << "    iall_gatherv : " << l_gather / p_result.gathertime << " MB/s (" << p_result.gathertime << " s)" << std::endl;
+    std::cout << "    result       : " << (check(p_result, p_elements, p_size) ? "correct" : "wrong") << std::endl;
+}
+
+
+
+/** main program, that measures the throughput of the non-blocking collectives on each backend
+ * and compares the results of the backends
+ * @param p_argc number of arguments
+ * @param p_argv arguments
+ **/
+int main(int p_argc, char* p_argv[])
+{
+    #ifdef MACHINELEARNING_MPI
+    mpi::environment l_mpienv(p_argc, p_argv);
+    mpi::communicator l_mpicom;
+    #endif
+    
+    #ifdef MACHINELEARNING_MULTILANGUAGE
+    tools::language::bindings::bind();
+    #endif
+    
+    
+    
+    // default values
+    #ifdef MACHINELEARNING_SHAREDMEMORY
+    std::size_t l_processes;
+    #endif
+    std::size_t l_elements;
+    std::size_t l_iteration;
+    
+    // create CML options with description
+    po::options_description l_description("allowed options");
+    l_description.add_options()
+        ("help", "produce help message")
+        #ifdef MACHINELEARNING_SHAREDMEMORY
+        #ifdef MACHINELEARNING_MPI
+        ("processes", po::value<std::size_t>(&l_processes)->default_value(0), "number of forked processes of the shared-memory backend [default: number of MPI processes]")
+        #else
+        ("processes", po::value<std::size_t>(&l_processes)->default_value(4), "number of forked processes of the shared-memory backend [default: 4]")
+        #endif
+        #endif
+        ("elements", po::value<std::size_t>(&l_elements)->default_value(1048576), "number of elements of the arrays [default: 1048576]")
+        ("iteration", po::value<std::size_t>(&l_iteration)->default_value(10), "number of repetitions [default: 10]")
+    ;
+    
+    po::variables_map l_map;
+    po::positional_options_description l_input;
+    po::store(po::command_line_parser(p_argc, p_argv).options(l_description).positional(l_input).run(), l_map);
+    po::notify(l_map);
+    
+    if (l_map.count("help")) {
+        std::cout << l_description << std::endl;
+        return EXIT_SUCCESS;
+    }
+    
+    if ((l_elements == 0) || (l_iteration == 0))
+    {
+        std::cerr << "[--elements] and [--iteration] must be greater than zero" << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    
+    
+    #ifdef MACHINELEARNING_MPI
+    const result l_mpiresult = benchmark(l_mpicom, l_elements, l_iteration);
+    if (l_mpicom.rank() == 0)
+        print("MPI", l_mpiresult, l_elements, static_cast<std::size_t>(l_mpicom.size()), l_iteration);
+    #endif
+    
+    
+    #ifdef MACHINELEARNING_SHAREDMEMORY
+    #ifdef MACHINELEARNING_MPI
+    // only the MPI process 0 forks, the forked processes must not call any MPI function
+    if (l_processes == 0)
+        l_processes = static_cast<std::size_t>(l_mpicom.size());
+    if (l_mpicom.rank() == 0)
+    #endif
+    {
+        result l_shared;
+        {
+            com::communicator l_com = com::sharedmemory::fork(l_processes);
+            l_shared = benchmark(l_com, l_elements, l_iteration);
+            
+            // the forked processes leave the program without the destructors of the main function
+            if (l_com.rank() != 0) {
+                std::cout.flush();
+                _exit(EXIT_SUCCESS);
+            }
+        }
+        
+        print("shared-memory", l_shared, l_elements, l_processes, l_iteration);
+        
+        #ifdef MACHINELEARNING_MPI
+        if (l_processes == static_cast<std::size_t>(l_mpicom.size()))
+            std::cout << "results of the MPI and the shared-memory backend are " << ( (l_shared.reduce == l_mpiresult.reduce) && (l_shared.gather == l_mpiresult.gather) ? "equal" : "different" ) << std::endl;
+        else
+            std::cout << "results of the backends are not compared, because the number of processes differs" << std::endl;
+        #endif
+    }
+    #endif
+    
+    return EXIT_SUCCESS;
+}
@@ -36,6 +36,35 @@ namespace tools = machinelearning::tools;
 
 
 
+/** projects the data of the input file, the data is read in row blocks if the chunk size is set
+ * @param p_source source file
+ * @param p_inpath path of the data within the file
+ * @param p_labels labels of the data
+ * @param p_dimension target dimension
+ * @param p_chunk number of rows of each block (zero reads all data)
+ * @return projected data
+ **/
+template<typename L> ublas::matrix<double> project( tools::files::hdf& p_source, const std::string& p_inpath, const std::vector<L>& p_labels, const std::size_t& p_dimension, const std::size_t& p_chunk )
+{
+    dim::lda<double, L> l_lda( p_dimension );
+    
+    if (p_chunk == 0)
+        return l_lda.map( p_source.readBlasMatrix<double>(p_inpath, tools::files::hdf::NATIVE_DOUBLE), p_labels );
+    
+    // the data is read in row blocks, first the scatter matrices are updated and than the blocks are projected
+    const std::size_t l_rows = p_source.getBlasMatrixSize( p_inpath ).first;
+    for(std::size_t i=0; i < l_rows; i += p_chunk)
+        l_lda.update( p_source.readBlasMatrix<double>(p_inpath, i, std::min(p_chunk, l_rows-i), tools::files::hdf::NATIVE_DOUBLE), std::vector<L>(p_labels.begin()+i, p_labels.begin()+std::min(i+p_chunk, l_rows)) );
+    
+    ublas::matrix<double> l_project( l_rows, p_dimension );
+    for(std::size_t i=0; i < l_rows; i += p_chunk)
+        ublas::subrange( l_project, i, std::min(i+p_chunk, l_rows), 0, p_dimension ) = l_lda.transform( p_source.readBlasMatrix<double>(p_inpath, i, std::min(p_chunk, l_rows-i), tools::files::hdf::NATIVE_DOUBLE) );
+    
+    return l_project;
+}
+
+
+
 /** main program
  * @param p_argc number of arguments
  * @param p_argv arguments
@@ -48,6 +77,7 @@ int main(int p_argc, char* p_argv[])
 
     // default values
     std::size_t l_dimension;
+    std::size_t l_chunk;
     std::string l_outpath;
 
     // create CML options with description
@@ -61,6 +91,7 @@ int main(int p_argc, char* p_argv[])
         ("outfile", po::value<std::string>(), "output HDF5 file")
         ("outpath", po::value<std::string>(&l_outpath)->default_value("/lda"), "output path within the HDF5 file [default: /lda]")
         ("dimension", po::value<std::size_t>(&l_dimension)->default_value(3), "target dimension [default: 3]")
+        ("chunk", po::value<std::size_t>(&l_chunk)->default_value(0), "number of rows, that are read from the input file on each incremental step [default: 0 = read all data]")
     ;
 
     po::variables_map l_map;
@@ -79,34 +110,27 @@ int main(int p_argc, char* p_argv[])
     }
 
 
-    // read source hdf file and data / create target file
+    // read source hdf file / create target file
     tools::files::hdf l_target( l_map["outfile"].as<std::string>(), true);
     tools::files::hdf l_source( l_map["infile"].as<std::string>() );
-    const ublas::matrix<double> l_data = l_source.readBlasMatrix<double>(l_map["inpath"].as<std::string>(), tools::files::hdf::NATIVE_DOUBLE);
 
 
     // lda with uint labels
     if (l_map["labeltype"].as<std::string>() == "uint") {
-        dim::lda<double, std::size_t> l_lda( l_dimension );
-
         const std::vector<std::size_t> l_labels = tools::vector::copy( l_source.readBlasVector<std::size_t>(l_map["labelpath"].as<std::string>(), tools::files::hdf::NATIVE_ULONG) );
-        l_target.writeBlasMatrix<double>( l_outpath,  l_lda.map(l_data, l_labels), tools::files::hdf::NATIVE_DOUBLE );
+        l_target.writeBlasMatrix<double>( l_outpath,  project(l_source, l_map["inpath"].as<std::string>(), l_labels, l_dimension, l_chunk), tools::files::hdf::NATIVE_DOUBLE );
     }
 
     // lda with int labels
     if (l_map["labeltype"].as<std::string>() == "int") {
-        dim::lda<double, std::ptrdiff_t> l_lda( l_dimension );
-
         const std::vector<std::ptrdiff_t> l_labels = tools::vector::copy( l_source.readBlasVector<std::ptrdiff_t>(l_map["labelpath"].as<std::string>(), tools::files::hdf::NATIVE_LONG) );
-        l_target.writeBlasMatrix<double>( l_outpath,  l_lda.map(l_data, l_labels), tools::files::hdf::NATIVE_DOUBLE );
+        l_target.writeBlasMatrix<double>( l_outpath,  project(l_source, l_map["inpath"].as<std::string>(), l_labels, l_dimension, l_chunk), tools::files::hdf::NATIVE_DOUBLE );
     }
 
     // lda with string labels
     if (l_map["labeltype"].as<std::string>() == "string") {
-        dim::lda<double, std::string> l_lda( l_dimension );
-
         const std::vector<std::string> l_labels = l_source.readStringVector(l_map["labelpath"].as<std::string>());
-        l_target.writeBlasMatrix<double>( l_outpath,  l_lda.map(l_data, l_labels), tools::files::hdf::NATIVE_DOUBLE );
+        l_target.writeBlasMatrix<double>( l_outpath,  project(l_source, l_map["inpath"].as<std::string>(), l_labels, l_dimension, l_chunk), tools::files::hdf::NATIVE_DOUBLE );
     }
 
 
@@ -50,6 +50,7 @@ int main(int p_argc, char* p_argv[])
     std::size_t l_dimension;
     std::size_t l_iteration;
     std::size_t l_step;
+    std::size_t l_landmarks;
     std::string l_outpath;
     std::string l_center;
     std::string l_mapping;
@@ -63,12 +64,14 @@ int main(int p_argc, char* p_argv[])
         ("inpath", po::value<std::string>(), "input path of the datapoint within the input file")
         ("outfile", po::value<std::string>(), "output HDF5 file")
         ("outpath", po::value<std::string>(&l_outpath)->default_value("/mds"), "output path within the HDF5 file [default: /mds]")
-        ("mapping", po::value<std::string>(&l_mapping)->default_value("metric"), "mapping type (values: metric [default], sammon, hit)")
+        ("mapping", po::value<std::string>(&l_mapping)->default_value("metric"), "mapping type (values: metric [default], sammon, hit, smacof, landmark, pivot)")
         ("dimension", po::value<std::size_t>(&l_dimension)->default_value(3), "target dimension [default: 3]")
-        ("iteration", po::value<std::size_t>(&l_iteration)->default_value(100), "iterations for sammon / hit mapping [default: 100]")
+        ("iteration", po::value<std::size_t>(&l_iteration)->default_value(100), "iterations for sammon / hit / smacof mapping [default: 100]")
         ("step", po::value<std::size_t>(&l_step)->default_value(20), "step size for sammon mapping [default: 20]")
         ("rate", po::value<double>(&l_rate)->default_value(1), "rate for hit mapping [default: 1]")
         ("center", po::value<std::string>(&l_center)->default_value("none"), "centering the data (values: none [default], single, double)")
+        ("landmarks", po::value<std::size_t>(&l_landmarks)->default_value(0), "number of equidistant landmark points of the input dissimilarity matrix for landmark / pivot mapping [default: 0 = the input matrix contains the dissimilarities between the landmarks (rows) and all points (columns)]")
+        ("landmarkindex", po::value< std::vector<std::size_t> >()->multitoken(), "indices of the landmark points of the input dissimilarity matrix for landmark / pivot mapping")
     ;
 
     po::variables_map l_map;
@@ -92,7 +95,19 @@ int main(int p_argc, char* p_argv[])
     tools::files::hdf l_source( l_map["infile"].as<std::string>() );
 
     // create mds object and map the data
-    dim::mds<double> l_mds( l_dimension, (l_mapping == "metric") ? dim::mds<double>::metric : (l_mapping == "sammon") ? dim::mds<double>::sammon : dim::mds<double>::hit );
+    dim::mds<double>::project l_type = dim::mds<double>::metric;
+    if (l_mapping == "sammon")
+        l_type = dim::mds<double>::sammon;
+    if (l_mapping == "hit")
+        l_type = dim::mds<double>::hit;
+    if (l_mapping == "smacof")
+        l_type = dim::mds<double>::smacof;
+    if (l_mapping == "landmark")
+        l_type = dim::mds<double>::landmark;
+    if (l_mapping == "pivot")
+        l_type = dim::mds<double>::pivot;
+    
+    dim::mds<double> l_mds( l_dimension, l_type );
 
     l_mds.setIteration( l_iteration );
     l_mds.setStep( l_step );
@@ -103,7 +118,31 @@ int main(int p_argc, char* p_argv[])
     if (l_center == "double")
         l_mds.setCentering( dim::mds<double>::doublecenter );
 
-    const ublas::matrix<double> l_project = l_mds.map( l_source.readBlasMatrix<double>(l_map["inpath"].as<std::string>(), tools::files::hdf::NATIVE_DOUBLE) );
+    ublas::matrix<double> l_data = l_source.readBlasMatrix<double>(l_map["inpath"].as<std::string>(), tools::files::hdf::NATIVE_DOUBLE);
+    
+    // landmark and pivot mapping use only the rows of the landmarks within the full dissimilarity matrix
+    if ( ((l_type == dim::mds<double>::landmark) || (l_type == dim::mds<double>::pivot)) && ((l_landmarks > 0) || (l_map.count("landmarkindex"))) )
+    {
+        std::vector<std::size_t> l_index;
+        if (l_map.count("landmarkindex"))
+            l_index = l_map["landmarkindex"].as< std::vector<std::size_t> >();
+        else
+            for(std::size_t i=0; i < l_landmarks; ++i)
+                l_index.push_back( i * l_data.size1() / l_landmarks );
+        
+        ublas::matrix<double> l_rows( l_index.size(), l_data.size2() );
+        for(std::size_t i=0; i < l_index.size(); ++i)
+        {
+            if (l_index[i] >= l_data.size1())
+                throw std::runtime_error("landmark index is out of the data");
+            ublas::row(l_rows, i) = ublas::row(l_data, l_index[i]);
+        }
+        
+        l_data = l_rows;
+        l_mds.setLandmarks( l_index );
+    }
+    
+    const ublas::matrix<double> l_project = l_mds.map( l_data );
 
     // create file and write data to hdf
     tools::files::hdf l_target(l_map["outfile"].as<std::string>(), true);
@@ -47,6 +47,7 @@ int main(int p_argc, char* p_argv[])
 
     // default values
     std::size_t l_dimension;
+    std::size_t l_chunk;
     std::string l_outpath;
 
     // create CML options with description
@@ -58,6 +59,8 @@ int main(int p_argc, char* p_argv[])
         ("outfile", po::value<std::string>(), "output HDF5 file")
         ("outpath", po::value<std::string>(&l_outpath)->default_value("/pca"), "output path within the HDF5 file [default: /pca]")
         ("dimension", po::value<std::size_t>(&l_dimension)->default_value(3), "target dimension [default: 3]")
+        ("randomized", "uses the randomized decomposition")
+        ("chunk", po::value<std::size_t>(&l_chunk)->default_value(0), "number of rows, that are read from the input file on each incremental step [default: 0 = read all data]")
     ;
 
     po::variables_map l_map;
@@ -80,8 +83,21 @@ int main(int p_argc, char* p_argv[])
     tools::files::hdf source( l_map["infile"].as<std::string>() );
 
     // create pca object and map the data
-    dim::pca<double> l_pca( l_dimension );
-    const ublas::matrix<double> l_project = l_pca.map( source.readBlasMatrix<double>( l_map["inpath"].as<std::string>(), tools::files::hdf::NATIVE_DOUBLE) );
+    dim::pca<double> l_pca( l_dimension, (l_map.count("randomized") ? dim::pca<double>::randomized : dim::pca<double>::full) );
+    ublas::matrix<double> l_project;
+    
+    if (l_chunk == 0)
+        l_project = l_pca.map( source.readBlasMatrix<double>( l_map["inpath"].as<std::string>(), tools::files::hdf::NATIVE_DOUBLE) );
+    else {
+        // the data is read in row blocks, first the projection is updated and than the blocks are projected
+        const std::size_t l_rows = source.getBlasMatrixSize( l_map["inpath"].as<std::string>() ).first;
+        for(std::size_t i=0; i < l_rows; i += l_chunk)
+            l_pca.update( source.readBlasMatrix<double>( l_map["inpath"].as<std::string>(), i, std::min(l_chunk, l_rows-i), tools::files::hdf::NATIVE_DOUBLE) );
+        
+        l_project.resize( l_rows, l_dimension, false );
+        for(std::size_t i=0; i < l_rows; i += l_chunk)
+            ublas::subrange( l_project, i, std::min(i+l_chunk, l_rows), 0, l_dimension ) = l_pca.transform( source.readBlasMatrix<double>( l_map["inpath"].as<std::string>(), i, std::min(l_chunk, l_rows-i), tools::files::hdf::NATIVE_DOUBLE) );
+    }
 
 
     // create file and write data to hdf
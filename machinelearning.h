@@ -41,7 +41,7 @@
  *         <li><i>optional Date-Time support</i> (used by Twitter support)</li>
  *         <li><i>optional Program Options</i> (only used by the examples)</li>
  *         <li><i>optional Filesystem support</i> (only used by the examples)</li>
- *         <li><i>optional Thread support</i> (only used by the framework logger)</li>
+ *         <li><i>optional Thread support</i> (used by the framework logger and the patch prefetching of the file support)</li>
  *         <li><i>optional Serialization</i> (only used by MPI use)</li>
  *         <li><i>optional Program options</i> (only used by the examples)</li>
  *         <li><i>optional Random Device support</i></li>
@@ -139,6 +139,7 @@
  * <li><dfn>MACHINELEARNING_SOURCES_TWITTER</dfn> twitter support</li>
  * </ul></li>
  * <li><dfn>MACHINELEARNING_MPI</dfn> enable MPI Support for the toolbox (requires Boost MPI support)</li>
+ * <li><dfn>MACHINELEARNING_SHAREDMEMORY</dfn> enable the shared-memory multi-process communicator (POSIX fork, requires Boost Interprocess), the MPI algorithms can be run on a single host without MPI</li>
  * </ul>
  * The following compiler commands should / must be set
  * <ul>
@@ -156,6 +157,7 @@
  * <ul>
  * <li><dfn>withrandomdevice</dfn> adds the compilerflag for random device support</li>
  * <li><dfn>withmpi</dfn> adds the compilerflag for cluster / MPI support (on the target <dfn>librarybuild</dfn> MPI support is compiled into the Boost)</li>
+ * <li><dfn>withsharedmemory</dfn> adds the compilerflag for the shared-memory multi-process communicator (not supported under MSYS)</li>
  * <li><dfn>withmultilanguage</dfn> adds the multilanguage support with gettext</li>
  * <li><dfn>withsources</dfn> support for the namespace machinelearning::tools::sources</li>
  * <li><dfn>withfiles</dfn> support for the namespace machinelearning::tools::files</li>
@@ -301,6 +303,8 @@
  * The namespace machinelearning::distances holds all types of distances. Every distance function is a subclass of <i>distance</i> and calculates distances values for vector- and matrixdata.
  * The class must be implementated as a template class and must hold some special functions for using the distance operation. In the namespace is also the ncd-class that creates a
  * symmetric/asymmetric dissimilarity matrix of string- or filedata with the <i>normalized compression distance</i>, that based on an approximation of the the Kolmogorov complexity. The
+ * cdm-class uses the same compressions with the <i>compression-based dissimilarity measure</i>. For large corpora the lzjd-class (<i>Lempel-Ziv Jaccard distance</i>) and the minhash-class
+ * (MinHash of byte n-grams) process each element once into a sketch, so a distance needs only the sketches, the matrices have the same structure like the NCD matrices. The
  * example show how to use these classes.
  *
  * @section ncd Normalize Compression Distance (NCD)
@@ -387,6 +391,19 @@
     tools::logger::releaseInstance();
  * @endcode
  *
+ * @section sharedmemory Shared-Memory Use
+ * The distributed algorithms can be run on a single host without MPI. The compile option <dfn>MACHINELEARNING_SHAREDMEMORY</dfn>
+ * must be set, the processes are forked and communicate over an anonymous shared-memory segment (each process reads its own data part)
+ * @code
+    tools::communication::communicator l_com = tools::communication::sharedmemory::fork( 4 );
+ 
+    clustering::nonsupervised::neuralgas<double> l_ng( l_distance, 11, 2 );
+    l_ng.train( l_com, l_data, 15 );
+ 
+    if (l_com.rank() == 0)
+        std::cout << l_ng.getPrototypes( l_com ) << std::endl;
+ * @endcode
+ *
  *
  *
  * @page files Example File Support
@@ -652,6 +669,10 @@
  * @file distances/distance.hpp abstract class for distance algorithms
  * @file distances/norm/euclid.hpp class for euclidian distances
  * @file distances/ncd.hpp implementation of the normalize compression distance
+ * @file distances/cdm.hpp implementation of the compression-based dissimilarity measure
+ * @file distances/sketch.hpp abstract class for sketch-based distances of strings
+ * @file distances/lzjd.hpp implementation of the Lempel-Ziv Jaccard distance
+ * @file distances/minhash.hpp implementation of the MinHash distance of byte n-grams
  *
  * @file errorhandling/exception.hpp header file for exceptions with implemention (forward declaration)
  * @file errorhandling/exception.implementation.hpp file with the exception implementation
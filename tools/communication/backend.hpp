@@ -0,0 +1,76 @@
+/** 
+ @cond
+ ############################################################################
+ # LGPL License                                                             #
+ #                                                                          #
+ # This file is part of the Machine Learning Framework.                     #
+ # Copyright (c) 2010-2012, Philipp Kraus, <philipp.kraus@flashpixx.de>     #
+ # This program is free software: you can redistribute it and/or modify     #
+ # it under the terms of the GNU Lesser General Public License as           #
+ # published by the Free Software Foundation, either version 3 of the       #
+ # License, or (at your option) any later version.                          #
+ #                                                                          #
+ # This program is distributed in the hope that it will be useful,          #
+ # but WITHOUT ANY WARRANTY; without even the implied warranty of           #
+ # MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            #
+ # GNU Lesser General Public License for more details.                      #
+ #                                                                          #
+ # You should have received a copy of the GNU Lesser General Public License #
+ # along with this program. If not, see <http://www.gnu.org/licenses/>.     #
+ ############################################################################
+ @endcond
+ **/
+
+#if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
+
+#ifndef __MACHINELEARNING_TOOLS_COMMUNICATION_BACKEND_HPP
+#define __MACHINELEARNING_TOOLS_COMMUNICATION_BACKEND_HPP
+
+#include <string>
+#include <vector>
+
+
+namespace machinelearning { namespace tools { namespace communication {
+    
+    
+    /** abstract class of a communication backend. The backend works on byte buffers,
+     * the typed collectives of the communicator serialize the data. All methods are
+     * collective calls, so every process must call them in the same order
+     **/
+    class backend
+    {
+        
+        public :
+        
+            /** function for reducing count elements of the input buffer into the inout buffer **/
+            typedef void (*reducefunction)( const void*, void*, const std::size_t& );
+        
+            virtual ~backend( void ) {};
+        
+            /** returns the rank of the process **/
+            virtual int rank( void ) const = 0;
+        
+            /** returns the number of processes **/
+            virtual int size( void ) const = 0;
+        
+            /** synchronizes all processes **/
+            virtual void barrier( void ) const = 0;
+        
+            /** reduces an array of plain elements (input, output, number of elements, size of one element, reduce function) **/
+            virtual void allreduce( const void*, void*, const std::size_t&, const std::size_t&, reducefunction ) const = 0;
+        
+            /** gathers the buffer of each process in rank order **/
+            virtual void allgather( const std::string&, std::vector<std::string>& ) const = 0;
+        
+            /** sends the buffer of the root process to all processes **/
+            virtual void broadcast( std::string&, const int& ) const = 0;
+        
+            /** sends a buffer to the destination and receives the buffer of the source process **/
+            virtual void sendrecv( const int&, const std::string&, const int&, std::string& ) const = 0;
+        
+    };
+    
+    
+}}}
+#endif
+#endif
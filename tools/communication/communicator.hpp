@@ -0,0 +1,625 @@
+/** 
+ @cond
+ ############################################################################
+ # LGPL License                                                             #
+ #                                                                          #
+ # This file is part of the Machine Learning Framework.                     #
+ # Copyright (c) 2010-2012, Philipp Kraus, <philipp.kraus@flashpixx.de>     #
+ # This program is free software: you can redistribute it and/or modify     #
+ # it under the terms of the GNU Lesser General Public License as           #
+ # published by the Free Software Foundation, either version 3 of the       #
+ # License, or (at your option) any later version.                          #
+ #                                                                          #
+ # This program is distributed in the hope that it will be useful,          #
+ # but WITHOUT ANY WARRANTY; without even the implied warranty of           #
+ # MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            #
+ # GNU Lesser General Public License for more details.                      #
+ #                                                                          #
+ # You should have received a copy of the GNU Lesser General Public License #
+ # along with this program. If not, see <http://www.gnu.org/licenses/>.     #
+ ############################################################################
+ @endcond
+ **/
+
+#if defined(MACHINELEARNING_MPI) || defined(MACHINELEARNING_SHAREDMEMORY)
+
+#ifndef __MACHINELEARNING_TOOLS_COMMUNICATION_COMMUNICATOR_HPP
+#define __MACHINELEARNING_TOOLS_COMMUNICATION_COMMUNICATOR_HPP
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <functional>
+#include <algorithm>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/type_traits/is_arithmetic.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/serialization/vector.hpp>
+#include <boost/serialization/string.hpp>
+#ifdef MACHINELEARNING_MPI
+#include <boost/mpi.hpp>
+#endif
+
+#include "backend.hpp"
+#include "messagepassing.hpp"
+#include "../language/language.h"
+#include "../../errorhandling/exception.hpp"
+
+
+namespace machinelearning { namespace tools { namespace communication {
+    
+    
+    /** communicator of the distributed algorithms. The communicator is a handle to a backend, so the
+     * algorithms can run with MPI or with processes on one machine. The collective functions of this
+     * namespace have the same signatures like the Boost.MPI functions, on the MPI backend they call
+     * Boost.MPI directly
+     * @note the communicator can be created implicitly of a Boost.MPI communicator
+     **/
+    class communicator
+    {
+        
+        public :
+        
+            #ifdef MACHINELEARNING_MPI
+            communicator( const boost::mpi::communicator& );
+            #endif
+            explicit communicator( const boost::shared_ptr<backend>& );
+            int rank( void ) const;
+            int size( void ) const;
+            void barrier( void ) const;
+            const backend& getBackend( void ) const;
+            #ifdef MACHINELEARNING_MPI
+            const boost::mpi::communicator* getMPICommunicator( void ) const;
+            #endif
+        
+        
+        private :
+        
+            /** backend **/
+            boost::shared_ptr<backend> m_backend;
+            #ifdef MACHINELEARNING_MPI
+            /** pointer to the MPI communicator (null if the backend is not MPI) **/
+            const boost::mpi::communicator* m_mpi;
+            #endif
+        
+    };
+    
+    
+    
+    /** request of a non-blocking collective **/
+    class request
+    {
+        
+        public :
+        
+            request( void );
+            #ifdef MACHINELEARNING_MPI
+            request( const MPI_Request&, const MPI_Request& = MPI_REQUEST_NULL );
+            #endif
+            void wait( void );
+        
+        
+        private :
+        
+            #ifdef MACHINELEARNING_MPI
+            /** MPI requests (the second is used for the receiving of a sendrecv) **/
+            MPI_Request m_request[2];
+            #endif
+            /** flag if the request is running **/
+            bool m_active;
+        
+    };
+    
+    
+    
+    #ifdef MACHINELEARNING_MPI
+    using boost::mpi::maximum;
+    using boost::mpi::minimum;
+    #else
+    
+    /** function object for the maximum **/
+    template<typename T> struct maximum : public std::binary_function<T, T, T>
+    {
+        const T& operator()( const T& p_x, const T& p_y ) const { return p_x < p_y ? p_y : p_x; }
+    };
+    
+    /** function object for the minimum **/
+    template<typename T> struct minimum : public std::binary_function<T, T, T>
+    {
+        const T& operator()( const T& p_x, const T& p_y ) const { return p_x < p_y ? p_x : p_y; }
+    };
+    
+    #endif
+    
+    
+    
+    //======= communicator =========================================================================================================================
+    
+    #ifdef MACHINELEARNING_MPI
+    /** creates the communicator with the MPI backend
+     * @param p_mpi MPI communicator
+     **/
+    inline communicator::communicator( const boost::mpi::communicator& p_mpi ) :
+        m_backend( new messagepassing(p_mpi) ),
+        m_mpi( &static_cast<messagepassing*>(m_backend.get())->getCommunicator() )
+    {}
+    #endif
+    
+    
+    /** creates the communicator with a backend
+     * @param p_backend backend
+     **/
+    inline communicator::communicator( const boost::shared_ptr<backend>& p_backend ) :
+        m_backend( p_backend )
+        #ifdef MACHINELEARNING_MPI
+        , m_mpi( NULL )
+        #endif
+    {
+        if (!m_backend)
+            throw exception::runtime(_("backend must be set"), *this);
+        
+        #ifdef MACHINELEARNING_MPI
+        if (const messagepassing* l_mpi = dynamic_cast<const messagepassing*>(m_backend.get()))
+            m_mpi = &l_mpi->getCommunicator();
+        #endif
+    }
+    
+    
+    /** returns the rank of the process
+     * @return rank
+     **/
+    inline int communicator::rank( void ) const
+    {
+        return m_backend->rank();
+    }
+    
+    
+    /** returns the number of processes
+     * @return size
+     **/
+    inline int communicator::size( void ) const
+    {
+        return m_backend->size();
+    }
+    
+    
+    /** synchronizes all processes **/
+    inline void communicator::barrier( void ) const
+    {
+        m_backend->barrier();
+    }
+    
+    
+    /** returns the backend
+     * @return backend reference
+     **/
+    inline const backend& communicator::getBackend( void ) const
+    {
+        return *m_backend;
+    }
+    
+    
+    #ifdef MACHINELEARNING_MPI
+    /** returns the MPI communicator
+     * @return pointer to the communicator or null if the backend is not MPI
+     **/
+    inline const boost::mpi::communicator* communicator::getMPICommunicator( void ) const
+    {
+        return m_mpi;
+    }
+    #endif
+    
+    
+    
+    //======= request ==============================================================================================================================
+    
+    /** creates a finished request **/
+    inline request::request( void ) :
+        m_active( false )
+    {
+        #ifdef MACHINELEARNING_MPI
+        m_request[0] = MPI_REQUEST_NULL;
+        m_request[1] = MPI_REQUEST_NULL;
+        #endif
+    }
+    
+    
+    #ifdef MACHINELEARNING_MPI
+    /** creates a running MPI request
+     * @param p_request MPI request
+     * @param p_second optional second MPI request, that is finished together with the first
+     **/
+    inline request::request( const MPI_Request& p_request, const MPI_Request& p_second ) :
+        m_active( true )
+    {
+        m_request[0] = p_request;
+        m_request[1] = p_second;
+    }
+    #endif
+    
+    
+    /** waits until the request is finished **/
+    inline void request::wait( void )
+    {
+        if (!m_active)
+            return;
+        
+        #ifdef MACHINELEARNING_MPI
+        MPI_Waitall( 2, m_request, MPI_STATUSES_IGNORE );
+        #endif
+        m_active = false;
+    }
+    
+    
+    
+    //======= serialization ========================================================================================================================
+    
+    /** reduce function for the backend, the function object must be default constructable
+     * @param p_in input elements
+     * @param p_inout elements, that are reduced with the input
+     * @param p_count number of elements
+     **/
+    template<typename T, typename Op> inline void reduceelements( const void* p_in, void* p_inout, const std::size_t& p_count )
+    {
+        const T* l_in = static_cast<const T*>(p_in);
+        T* l_inout    = static_cast<T*>(p_inout);
+        Op l_op;
+        
+        for(std::size_t i=0; i < p_count; ++i)
+            l_inout[i] = l_op( l_inout[i], l_in[i] );
+    }
+    
+    
+    /** serializes plain data into a byte buffer
+     * @param p_data data
+     * @param p_buffer byte buffer
+     **/
+    template<typename T> inline void serialize( const T& p_data, std::string& p_buffer, const boost::true_type& )
+    {
+        p_buffer.assign( reinterpret_cast<const char*>(&p_data), sizeof(T) );
+    }
+    
+    
+    /** serializes data with a binary archive into a byte buffer
+     * @param p_data data
+     * @param p_buffer byte buffer
+     **/
+    template<typename T> inline void serialize( const T& p_data, std::string& p_buffer, const boost::false_type& )
+    {
+        std::ostringstream l_stream( std::ios::out | std::ios::binary );
+        {
+            boost::archive::binary_oarchive l_archive( l_stream, boost::archive::no_header );
+            l_archive << p_data;
+        }
+        p_buffer = l_stream.str();
+    }
+    
+    
+    /** deserializes plain data of a byte buffer
+     * @param p_buffer byte buffer
+     * @param p_data data
+     **/
+    template<typename T> inline void deserialize( const std::string& p_buffer, T& p_data, const boost::true_type& )
+    {
+        std::copy( p_buffer.begin(), p_buffer.end(), reinterpret_cast<char*>(&p_data) );
+    }
+    
+    
+    /** deserializes data of a byte buffer with a binary archive
+     * @param p_buffer byte buffer
+     * @param p_data data
+     **/
+    template<typename T> inline void deserialize( const std::string& p_buffer, T& p_data, const boost::false_type& )
+    {
+        std::istringstream l_stream( p_buffer, std::ios::in | std::ios::binary );
+        boost::archive::binary_iarchive l_archive( l_stream, boost::archive::no_header );
+        l_archive >> p_data;
+    }
+    
+    
+    /** reduces plain elements within the backend
+     * @param p_com communicator
+     * @param p_in input array
+     * @param p_count number of elements
+     * @param p_out output array
+     **/
+    template<typename T, typename Op> inline void all_reduce( const communicator& p_com, const T* p_in, const int& p_count, T* p_out, Op, const boost::true_type& )
+    {
+        p_com.getBackend().allreduce( p_in, p_out, static_cast<std::size_t>(p_count), sizeof(T), &reduceelements<T, Op> );
+    }
+    
+    
+    /** reduces serializable elements, the arrays of all processes are gathered and reduced in rank order
+     * @param p_com communicator
+     * @param p_in input array
+     * @param p_count number of elements
+     * @param p_out output array
+     * @param p_op reduce function object
+     **/
+    template<typename T, typename Op> inline void all_reduce( const communicator& p_com, const T* p_in, const int& p_count, T* p_out, Op p_op, const boost::false_type& )
+    {
+        std::string l_buffer;
+        serialize( std::vector<T>(p_in, p_in+p_count), l_buffer, boost::false_type() );
+        
+        std::vector<std::string> l_buffers;
+        p_com.getBackend().allgather( l_buffer, l_buffers );
+        
+        std::vector<T> l_result;
+        deserialize( l_buffers[0], l_result, boost::false_type() );
+        for(std::size_t i=1; i < l_buffers.size(); ++i) {
+            std::vector<T> l_data;
+            deserialize( l_buffers[i], l_data, boost::false_type() );
+            
+            for(std::size_t n=0; n < l_result.size(); ++n)
+                l_result[n] = p_op( l_result[n], l_data[n] );
+        }
+        
+        std::copy( l_result.begin(), l_result.end(), p_out );
+    }
+    
+    
+    
+    //======= collectives ==========================================================================================================================
+    
+    /** reduces an array over all processes
+     * @param p_com communicator
+     * @param p_in input array
+     * @param p_count number of elements
+     * @param p_out output array
+     * @param p_op reduce function object (must be default constructable on plain types)
+     **/
+    template<typename T, typename Op> inline void all_reduce( const communicator& p_com, const T* p_in, const int& p_count, T* p_out, Op p_op )
+    {
+        #ifdef MACHINELEARNING_MPI
+        if (p_com.getMPICommunicator()) {
+            boost::mpi::all_reduce( *p_com.getMPICommunicator(), p_in, p_count, p_out, p_op );
+            return;
+        }
+        #endif
+        
+        all_reduce( p_com, p_in, p_count, p_out, p_op, typename boost::is_arithmetic<T>::type() );
+    }
+    
+    
+    /** reduces a value over all processes
+     * @param p_com communicator
+     * @param p_in input value
+     * @param p_out output value
+     * @param p_op reduce function object
+     **/
+    template<typename T, typename Op> inline void all_reduce( const communicator& p_com, const T& p_in, T& p_out, Op p_op )
+    {
+        all_reduce( p_com, &p_in, 1, &p_out, p_op );
+    }
+    
+    
+    /** reduces a value over all processes
+     * @param p_com communicator
+     * @param p_in input value
+     * @param p_op reduce function object
+     * @return reduced value
+     **/
+    template<typename T, typename Op> inline T all_reduce( const communicator& p_com, const T& p_in, Op p_op )
+    {
+        T l_out( p_in );
+        all_reduce( p_com, &p_in, 1, &l_out, p_op );
+        return l_out;
+    }
+    
+    
+    /** starts a non-blocking reduction of an array over all processes. The MPI backend uses the MPI-3 non-blocking
+     * collective, other backends run the reduction blocking and return a finished request
+     * @param p_com communicator
+     * @param p_in input array
+     * @param p_count number of elements
+     * @param p_out output array
+     * @param p_op reduce function object (must be a MPI operation on the MPI backend)
+     * @return request
+     **/
+    template<typename T, typename Op> inline request iall_reduce( const communicator& p_com, const T* p_in, const int& p_count, T* p_out, Op p_op )
+    {
+        #ifdef MACHINELEARNING_MPI
+        if (p_com.getMPICommunicator()) {
+            MPI_Request l_request;
+            MPI_Iallreduce( const_cast<T*>(p_in), p_out, p_count, boost::mpi::get_mpi_datatype<T>(), boost::mpi::is_mpi_op<Op, T>::op(), MPI_Comm(*p_com.getMPICommunicator()), &l_request );
+            return request(l_request);
+        }
+        #endif
+        
+        all_reduce( p_com, p_in, p_count, p_out, p_op );
+        return request();
+    }
+    
+    
+    /** waits for all requests
+     * @param p_first iterator to the first request
+     * @param p_last iterator behind the last request
+     **/
+    template<typename It> inline void wait_all( It p_first, It p_last )
+    {
+        for( ; p_first != p_last; ++p_first)
+            p_first->wait();
+    }
+    
+    
+    /** gathers a value of each process
+     * @param p_com communicator
+     * @param p_in input value
+     * @param p_out vector with the values of all processes in rank order
+     **/
+    template<typename T> inline void all_gather( const communicator& p_com, const T& p_in, std::vector<T>& p_out )
+    {
+        #ifdef MACHINELEARNING_MPI
+        if (p_com.getMPICommunicator()) {
+            boost::mpi::all_gather( *p_com.getMPICommunicator(), p_in, p_out );
+            return;
+        }
+        #endif
+        
+        std::string l_buffer;
+        serialize( p_in, l_buffer, typename boost::is_arithmetic<T>::type() );
+        
+        std::vector<std::string> l_buffers;
+        p_com.getBackend().allgather( l_buffer, l_buffers );
+        
+        p_out.resize( l_buffers.size() );
+        for(std::size_t i=0; i < l_buffers.size(); ++i)
+            deserialize( l_buffers[i], p_out[i], typename boost::is_arithmetic<T>::type() );
+    }
+    
+    
+    /** starts a non-blocking gathering of the arrays of all processes into one array (in rank order). The MPI backend
+     * uses the MPI-3 non-blocking collective, other backends run the gathering blocking and return a finished request
+     * @note the input array, the count and the displacement vector must be valid until the request is finished
+     * @param p_com communicator
+     * @param p_in input array
+     * @param p_count number of local elements
+     * @param p_out output array (size is the sum of the counts)
+     * @param p_counts number of elements of each process
+     * @param p_displacements offsets of the process arrays within the output array
+     * @return request
+     **/
+    template<typename T> inline request iall_gatherv( const communicator& p_com, const T* p_in, const int& p_count, T* p_out, const std::vector<int>& p_counts, const std::vector<int>& p_displacements )
+    {
+        #ifdef MACHINELEARNING_MPI
+        if (p_com.getMPICommunicator()) {
+            MPI_Request l_request;
+            MPI_Iallgatherv( const_cast<T*>(p_in), p_count, boost::mpi::get_mpi_datatype<T>(), p_out, const_cast<int*>(&p_counts[0]), const_cast<int*>(&p_displacements[0]), boost::mpi::get_mpi_datatype<T>(), MPI_Comm(*p_com.getMPICommunicator()), &l_request );
+            return request(l_request);
+        }
+        #endif
+        
+        std::vector<std::string> l_buffers;
+        p_com.getBackend().allgather( std::string(reinterpret_cast<const char*>(p_in), p_count * sizeof(T)), l_buffers );
+        
+        for(std::size_t i=0; i < l_buffers.size(); ++i)
+        {
+            if (l_buffers[i].size() != p_counts[i] * sizeof(T))
+                throw exception::runtime(_("number of gathered elements is not equal to the count"));
+            std::copy( l_buffers[i].begin(), l_buffers[i].end(), reinterpret_cast<char*>(p_out + p_displacements[i]) );
+        }
+        
+        return request();
+    }
+    
+    
+    /** sends the i-th value of each process to the process with rank i
+     * @param p_com communicator
+     * @param p_in vector with one value for each process
+     * @param p_out vector with the received values in rank order
+     **/
+    template<typename T> inline void all_to_all( const communicator& p_com, const std::vector<T>& p_in, std::vector<T>& p_out )
+    {
+        #ifdef MACHINELEARNING_MPI
+        if (p_com.getMPICommunicator()) {
+            boost::mpi::all_to_all( *p_com.getMPICommunicator(), p_in, p_out );
+            return;
+        }
+        #endif
+        
+        if (p_in.size() != static_cast<std::size_t>(p_com.size()))
+            throw exception::runtime(_("number of values must be equal to the number of processes"));
+        
+        std::vector< std::vector<T> > l_data;
+        all_gather( p_com, p_in, l_data );
+        
+        p_out.clear();
+        for(std::size_t i=0; i < l_data.size(); ++i)
+            p_out.push_back( l_data[i][static_cast<std::size_t>(p_com.rank())] );
+    }
+    
+    
+    /** sends a value of the root process to all processes
+     * @param p_com communicator
+     * @param p_data value
+     * @param p_root rank of the root process
+     **/
+    template<typename T> inline void broadcast( const communicator& p_com, T& p_data, const int& p_root )
+    {
+        #ifdef MACHINELEARNING_MPI
+        if (p_com.getMPICommunicator()) {
+            boost::mpi::broadcast( *p_com.getMPICommunicator(), p_data, p_root );
+            return;
+        }
+        #endif
+        
+        std::string l_buffer;
+        if (p_com.rank() == p_root)
+            serialize( p_data, l_buffer, typename boost::is_arithmetic<T>::type() );
+        
+        p_com.getBackend().broadcast( l_buffer, p_root );
+        
+        if (p_com.rank() != p_root)
+            deserialize( l_buffer, p_data, typename boost::is_arithmetic<T>::type() );
+    }
+    
+    
+    /** sends a value to the destination process and receives the value of the source process. All processes
+     * must call the function, so it can be used for ring communication
+     * @param p_com communicator
+     * @param p_destination rank of the destination process
+     * @param p_in value for sending
+     * @param p_source rank of the source process
+     * @param p_out received value
+     **/
+    template<typename T> inline void sendrecv( const communicator& p_com, const int& p_destination, const T& p_in, const int& p_source, T& p_out )
+    {
+        #ifdef MACHINELEARNING_MPI
+        if (p_com.getMPICommunicator()) {
+            boost::mpi::request l_request[2];
+            l_request[0] = p_com.getMPICommunicator()->isend( p_destination, 0, p_in );
+            l_request[1] = p_com.getMPICommunicator()->irecv( p_source, 0, p_out );
+            boost::mpi::wait_all( l_request, l_request+2 );
+            return;
+        }
+        #endif
+        
+        std::string l_send;
+        std::string l_receive;
+        serialize( p_in, l_send, typename boost::is_arithmetic<T>::type() );
+        p_com.getBackend().sendrecv( p_destination, l_send, p_source, l_receive );
+        deserialize( l_receive, p_out, typename boost::is_arithmetic<T>::type() );
+    }
+    
+    
+    /** starts a non-blocking sending of a plain array to the destination process and receiving of a plain array of
+     * the source process. All processes must call the function, so it can be used for ring communication. The MPI
+     * backend uses non-blocking point-to-point communication, other backends run the communication blocking and
+     * return a finished request
+     * @note the arrays must be valid until the request is finished
+     * @param p_com communicator
+     * @param p_destination rank of the destination process
+     * @param p_in array for sending
+     * @param p_count number of elements for sending
+     * @param p_source rank of the source process
+     * @param p_out array for receiving
+     * @param p_outcount number of elements for receiving
+     * @return request
+     **/
+    template<typename T> inline request isendrecv( const communicator& p_com, const int& p_destination, const T* p_in, const int& p_count, const int& p_source, T* p_out, const int& p_outcount )
+    {
+        #ifdef MACHINELEARNING_MPI
+        if (p_com.getMPICommunicator()) {
+            MPI_Request l_request[2];
+            MPI_Isend( const_cast<T*>(p_in), p_count, boost::mpi::get_mpi_datatype<T>(), p_destination, 0, MPI_Comm(*p_com.getMPICommunicator()), &l_request[0] );
+            MPI_Irecv( p_out, p_outcount, boost::mpi::get_mpi_datatype<T>(), p_source, 0, MPI_Comm(*p_com.getMPICommunicator()), &l_request[1] );
+            return request(l_request[0], l_request[1]);
+        }
+        #endif
+        
+        std::string l_receive;
+        p_com.getBackend().sendrecv( p_destination, std::string(reinterpret_cast<const char*>(p_in), p_count * sizeof(T)), p_source, l_receive );
+        
+        if (l_receive.size() != p_outcount * sizeof(T))
+            throw exception::runtime(_("number of received elements is not equal to the count"));
+        std::copy( l_receive.begin(), l_receive.end(), reinterpret_cast<char*>(p_out) );
+        
+        return request();
+    }
+    
+    
+}}}
+#endif
+#endif
@@ -0,0 +1,166 @@
+/** 
+ @cond
+ ############################################################################
+ # LGPL License                                                             #
+ #                                                                          #
+ # This file is part of the Machine Learning Framework.                     #
+ # Copyright (c) 2010-2012, Philipp Kraus, <philipp.kraus@flashpixx.de>     #
+ # This program is free software: you can redistribute it and/or modify     #
+ # it under the terms of the GNU Lesser General Public License as           #
+ # published by the Free Software Foundation, either version 3 of the       #
+ # License, or (at your option) any later version.                          #
+ #                                                                          #
+ # This program is distributed in the hope that it will be useful,          #
+ # but WITHOUT ANY WARRANTY; without even the implied warranty of           #
+ # MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            #
+ # GNU Lesser General Public License for more details.                      #
+ #                                                                          #
+ # You should have received a copy of the GNU Lesser General Public License #
+ # along with this program. If not, see <http://www.gnu.org/licenses/>.     #
+ ############################################################################
+ @endcond
+ **/
+
+#ifdef MACHINELEARNING_MPI
+
+#ifndef __MACHINELEARNING_TOOLS_COMMUNICATION_MESSAGEPASSING_HPP
+#define __MACHINELEARNING_TOOLS_COMMUNICATION_MESSAGEPASSING_HPP
+
+#include <string>
+#include <vector>
+#include <boost/mpi.hpp>
+#include <boost/serialization/string.hpp>
+
+#include "backend.hpp"
+
+
+namespace machinelearning { namespace tools { namespace communication {
+    
+    
+    /** backend for the Boost.MPI communicator. The typed collectives of the communicator
+     * call Boost.MPI directly, so this backend is only used on byte buffer calls
+     **/
+    class messagepassing : public backend
+    {
+        
+        public :
+        
+            messagepassing( const boost::mpi::communicator& );
+            const boost::mpi::communicator& getCommunicator( void ) const;
+            int rank( void ) const;
+            int size( void ) const;
+            void barrier( void ) const;
+            void allreduce( const void*, void*, const std::size_t&, const std::size_t&, reducefunction ) const;
+            void allgather( const std::string&, std::vector<std::string>& ) const;
+            void broadcast( std::string&, const int& ) const;
+            void sendrecv( const int&, const std::string&, const int&, std::string& ) const;
+        
+        
+        private :
+        
+            /** MPI communicator **/
+            const boost::mpi::communicator m_mpi;
+        
+    };
+    
+    
+    
+    /** constructor
+     * @param p_mpi MPI communicator
+     **/
+    inline messagepassing::messagepassing( const boost::mpi::communicator& p_mpi ) :
+        m_mpi( p_mpi )
+    {}
+    
+    
+    /** returns the MPI communicator
+     * @return communicator
+     **/
+    inline const boost::mpi::communicator& messagepassing::getCommunicator( void ) const
+    {
+        return m_mpi;
+    }
+    
+    
+    /** returns the rank of the process
+     * @return rank
+     **/
+    inline int messagepassing::rank( void ) const
+    {
+        return m_mpi.rank();
+    }
+    
+    
+    /** returns the number of processes
+     * @return size
+     **/
+    inline int messagepassing::size( void ) const
+    {
+        return m_mpi.size();
+    }
+    
+    
+    /** synchronizes all processes **/
+    inline void messagepassing::barrier( void ) const
+    {
+        m_mpi.barrier();
+    }
+    
+    
+    /** reduces an array of plain elements. The byte buffers of all processes are gathered
+     * and reduced in rank order, because the reduce function can not be used as MPI operation
+     * @param p_send input array
+     * @param p_receive output array
+     * @param p_count number of elements
+     * @param p_typesize size of one element
+     * @param p_function reduce function
+     **/
+    inline void messagepassing::allreduce( const void* p_send, void* p_receive, const std::size_t& p_count, const std::size_t& p_typesize, reducefunction p_function ) const
+    {
+        std::vector<std::string> l_data;
+        boost::mpi::all_gather( m_mpi, std::string(static_cast<const char*>(p_send), p_count*p_typesize), l_data );
+        
+        std::copy( l_data[0].begin(), l_data[0].end(), static_cast<char*>(p_receive) );
+        for(std::size_t i=1; i < l_data.size(); ++i)
+            p_function( l_data[i].data(), p_receive, p_count );
+    }
+    
+    
+    /** gathers the buffer of each process
+     * @param p_send buffer of the process
+     * @param p_receive vector with the buffers of all processes
+     **/
+    inline void messagepassing::allgather( const std::string& p_send, std::vector<std::string>& p_receive ) const
+    {
+        boost::mpi::all_gather( m_mpi, p_send, p_receive );
+    }
+    
+    
+    /** sends the buffer of the root process to all processes
+     * @param p_data buffer
+     * @param p_root rank of the root process
+     **/
+    inline void messagepassing::broadcast( std::string& p_data, const int& p_root ) const
+    {
+        boost::mpi::broadcast( m_mpi, p_data, p_root );
+    }
+    
+    
+    /** sends a buffer to the destination and receives the buffer of the source process
+     * @param p_destination rank of the destination process
+     * @param p_send buffer for sending
+     * @param p_source rank of the source process
+     * @param p_receive buffer for receiving
+     **/
+    inline void messagepassing::sendrecv( const int& p_destination, const std::string& p_send, const int& p_source, std::string& p_receive ) const
+    {
+        boost::mpi::request l_request[2];
+        l_request[0] = m_mpi.isend( p_destination, 0, p_send );
+        l_request[1] = m_mpi.irecv( p_source, 0, p_receive );
+        boost::mpi::wait_all( l_request, l_request+2 );
+    }
+    
+    
+}}}
+#endif
+#endif
@@ -0,0 +1,429 @@
+/** 
+ @cond
+ ############################################################################
+ # LGPL License                                                             #
+ #                                                                          #
+ # This file is part of the Machine Learning Framework.                     #
+ # Copyright (c) 2010-2012, Philipp Kraus, <philipp.kraus@flashpixx.de>     #
+ # This program is free software: you can redistribute it and/or modify     #
+ # it under the terms of the GNU Lesser General Public License as           #
+ # published by the Free Software Foundation, either version 3 of the       #
+ # License, or (at your option) any later version.                          #
+ #                                                                          #
+ # This program is distributed in the hope that it will be useful,          #
+ # but WITHOUT ANY WARRANTY; without even the implied warranty of           #
+ # MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            #
+ # GNU Lesser General Public License for more details.                      #
+ #                                                                          #
+ # You should have received a copy of the GNU Lesser General Public License #
+ # along with this program. If not, see <http://www.gnu.org/licenses/>.     #
+ ############################################################################
+ @endcond
+ **/
+
+#ifdef MACHINELEARNING_SHAREDMEMORY
+
+#ifndef __MACHINELEARNING_TOOLS_COMMUNICATION_SHAREDMEMORY_HPP
+#define __MACHINELEARNING_TOOLS_COMMUNICATION_SHAREDMEMORY_HPP
+
+#include <new>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/anonymous_shared_memory.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <boost/interprocess/sync/interprocess_mutex.hpp>
+#include <boost/interprocess/sync/interprocess_condition.hpp>
+
+#include "backend.hpp"
+#include "communicator.hpp"
+#include "../language/language.h"
+#include "../../errorhandling/exception.hpp"
+
+
+namespace machinelearning { namespace tools { namespace communication {
+    
+    #ifndef SWIG
+    namespace bip = boost::interprocess;
+    #endif
+    
+    
+    /** backend for processes on one machine without MPI. The processes are created with fork and
+     * exchange the data within an anonymous shared memory segment, that stores one buffer for each
+     * process and one buffer for the reduction result. On a reduction each process copies its elements
+     * into its buffer, reduces its part of the elements directly of the buffers of all processes into
+     * the result buffer (reduce-scatter) and copies the result, so the data is copied only into and out
+     * of the shared memory. Data, that is larger than a buffer, is sent in blocks
+     * @note the process 0 waits on destruction of its communicator for all other processes, the other
+     * processes return from the fork call and run the program code with their own communicator
+     * @code
+        tools::communication::communicator l_com = tools::communication::sharedmemory::fork( 4 );
+        l_neuralgas.train( l_com, l_data, l_iterations );
+     * @endcode
+     **/
+    class sharedmemory : public backend
+    {
+        
+        public :
+        
+            static communicator fork( const std::size_t&, const std::size_t& = 4194304 );
+            ~sharedmemory( void );
+            int rank( void ) const;
+            int size( void ) const;
+            void barrier( void ) const;
+            void allreduce( const void*, void*, const std::size_t&, const std::size_t&, reducefunction ) const;
+            void allgather( const std::string&, std::vector<std::string>& ) const;
+            void broadcast( std::string&, const int& ) const;
+            void sendrecv( const int&, const std::string&, const int&, std::string& ) const;
+        
+        
+        private :
+        
+            /** synchronization data within the shared memory **/
+            struct control
+            {
+                /** mutex of the barrier **/
+                bip::interprocess_mutex mutex;
+                /** condition of the barrier **/
+                bip::interprocess_condition condition;
+                /** number of processes, that are waiting **/
+                std::size_t count;
+                /** generation of the barrier **/
+                std::size_t generation;
+                
+                control( void ) : mutex(), condition(), count(0), generation(0) {}
+            };
+        
+            /** alignment of the buffers **/
+            static const std::size_t m_alignment = 64;
+        
+            /** shared memory region **/
+            const boost::shared_ptr<bip::mapped_region> m_region;
+            /** rank of the process **/
+            const std::size_t m_rank;
+            /** number of processes **/
+            const std::size_t m_size;
+            /** size of one buffer **/
+            const std::size_t m_buffersize;
+            /** child process ids (only set on process 0) **/
+            const std::vector<pid_t> m_childs;
+            /** pointer to the control data **/
+            control* const m_control;
+            /** pointer to the data length of each process **/
+            std::size_t* const m_length;
+            /** pointer to the first buffer **/
+            char* const m_buffer;
+        
+        
+            sharedmemory( const boost::shared_ptr<bip::mapped_region>&, const std::size_t&, const std::size_t&, const std::size_t&, const std::vector<pid_t>& );
+            char* getBuffer( const std::size_t& ) const;
+            std::size_t getMaxLength( void ) const;
+            static std::size_t align( const std::size_t& );
+            static std::size_t getHeaderSize( const std::size_t& );
+        
+    };
+    
+    
+    
+    /** creates the processes and returns the communicator of the process
+     * @param p_processes number of processes (include the calling process)
+     * @param p_buffersize size of the buffer of each process in bytes
+     * @return communicator
+     **/
+    inline communicator sharedmemory::fork( const std::size_t& p_processes, const std::size_t& p_buffersize )
+    {
+        if (p_processes == 0)
+            throw exception::runtime(_("number of processes must be greater than zero"));
+        if (p_buffersize == 0)
+            throw exception::runtime(_("buffer size must be greater than zero"));
+        
+        // the region is mapped before the fork, so every process uses the same memory
+        const std::size_t l_buffersize = align(p_buffersize);
+        boost::shared_ptr<bip::mapped_region> l_region( new bip::mapped_region( bip::anonymous_shared_memory( getHeaderSize(p_processes) + (p_processes+1) * l_buffersize ) ) );
+        new (l_region->get_address()) control();
+        
+        // buffered output must be flushed, otherwise it is written by each process
+        std::cout.flush();
+        std::cerr.flush();
+        std::fflush(NULL);
+        
+        std::vector<pid_t> l_childs;
+        for(std::size_t i=1; i < p_processes; ++i) {
+            const pid_t l_pid = ::fork();
+            
+            if (l_pid == 0)
+                return communicator( boost::shared_ptr<backend>( new sharedmemory(l_region, i, p_processes, l_buffersize, std::vector<pid_t>()) ) );
+            
+            if (l_pid < 0) {
+                for(std::size_t n=0; n < l_childs.size(); ++n) {
+                    kill( l_childs[n], SIGTERM );
+                    waitpid( l_childs[n], NULL, 0 );
+                }
+                throw exception::runtime(_("process can not be created"));
+            }
+            
+            l_childs.push_back( l_pid );
+        }
+        
+        return communicator( boost::shared_ptr<backend>( new sharedmemory(l_region, 0, p_processes, l_buffersize, l_childs) ) );
+    }
+    
+    
+    /** constructor
+     * @param p_region shared memory region
+     * @param p_rank rank of the process
+     * @param p_size number of processes
+     * @param p_buffersize size of one buffer
+     * @param p_childs child process ids
+     **/
+    inline sharedmemory::sharedmemory( const boost::shared_ptr<bip::mapped_region>& p_region, const std::size_t& p_rank, const std::size_t& p_size, const std::size_t& p_buffersize, const std::vector<pid_t>& p_childs ) :
+        m_region( p_region ),
+        m_rank( p_rank ),
+        m_size( p_size ),
+        m_buffersize( p_buffersize ),
+        m_childs( p_childs ),
+        m_control( static_cast<control*>(p_region->get_address()) ),
+        m_length( reinterpret_cast<std::size_t*>(static_cast<char*>(p_region->get_address()) + align(sizeof(control))) ),
+        m_buffer( static_cast<char*>(p_region->get_address()) + getHeaderSize(p_size) )
+    {}
+    
+    
+    /** destructor, the process 0 waits for all other processes **/
+    inline sharedmemory::~sharedmemory( void )
+    {
+        for(std::size_t i=0; i < m_childs.size(); ++i)
+            waitpid( m_childs[i], NULL, 0 );
+        
+        if (m_rank == 0)
+            m_control->~control();
+    }
+    
+    
+    /** returns the size of the memory in front of the buffers
+     * @param p_processes number of processes
+     * @return size in bytes
+     **/
+    inline std::size_t sharedmemory::getHeaderSize( const std::size_t& p_processes )
+    {
+        return align(sizeof(control)) + align(p_processes * sizeof(std::size_t));
+    }
+    
+    
+    /** aligns a size to the buffer alignment
+     * @param p_size size
+     * @return aligned size
+     **/
+    inline std::size_t sharedmemory::align( const std::size_t& p_size )
+    {
+        return ((p_size + m_alignment - 1) / m_alignment) * m_alignment;
+    }
+    
+    
+    /** returns a buffer
+     * @param p_index index of the buffer (the index of the number of processes is the result buffer)
+     * @return pointer to the buffer
+     **/
+    inline char* sharedmemory::getBuffer( const std::size_t& p_index ) const
+    {
+        return m_buffer + p_index * m_buffersize;
+    }
+    
+    
+    /** returns the maximum of the data length of all processes
+     * @return length
+     **/
+    inline std::size_t sharedmemory::getMaxLength( void ) const
+    {
+        return *std::max_element( m_length, m_length + m_size );
+    }
+    
+    
+    /** returns the rank of the process
+     * @return rank
+     **/
+    inline int sharedmemory::rank( void ) const
+    {
+        return static_cast<int>(m_rank);
+    }
+    
+    
+    /** returns the number of processes
+     * @return size
+     **/
+    inline int sharedmemory::size( void ) const
+    {
+        return static_cast<int>(m_size);
+    }
+    
+    
+    /** synchronizes all processes **/
+    inline void sharedmemory::barrier( void ) const
+    {
+        bip::scoped_lock<bip::interprocess_mutex> l_lock( m_control->mutex );
+        
+        const std::size_t l_generation = m_control->generation;
+        if (++m_control->count == m_size) {
+            m_control->count = 0;
+            m_control->generation++;
+            m_control->condition.notify_all();
+            return;
+        }
+        
+        while (l_generation == m_control->generation)
+            m_control->condition.wait( l_lock );
+    }
+    
+    
+    /** reduces an array of plain elements, each process reduces a part of the elements
+     * directly of the buffers of all processes
+     * @param p_send input array
+     * @param p_receive output array (can be equal to the input array)
+     * @param p_count number of elements
+     * @param p_typesize size of one element
+     * @param p_function reduce function
+     **/
+    inline void sharedmemory::allreduce( const void* p_send, void* p_receive, const std::size_t& p_count, const std::size_t& p_typesize, reducefunction p_function ) const
+    {
+        const std::size_t l_elements = m_buffersize / p_typesize;
+        if (l_elements == 0)
+            throw exception::runtime(_("buffer size is less than the element size"), *this);
+        
+        const char* l_send = static_cast<const char*>(p_send);
+        char* l_receive    = static_cast<char*>(p_receive);
+        char* l_result     = getBuffer(m_size);
+        
+        for(std::size_t l_offset=0; l_offset < p_count; l_offset += l_elements) {
+            const std::size_t l_count = std::min(l_elements, p_count - l_offset);
+            std::memcpy( getBuffer(m_rank), l_send + l_offset * p_typesize, l_count * p_typesize );
+            barrier();
+            
+            // reduce the part of this process
+            const std::size_t l_begin = l_count * m_rank / m_size;
+            const std::size_t l_end   = l_count * (m_rank+1) / m_size;
+            if (l_end > l_begin) {
+                std::memcpy( l_result + l_begin * p_typesize, getBuffer(0) + l_begin * p_typesize, (l_end-l_begin) * p_typesize );
+                for(std::size_t i=1; i < m_size; ++i)
+                    p_function( getBuffer(i) + l_begin * p_typesize, l_result + l_begin * p_typesize, l_end-l_begin );
+            }
+            barrier();
+            
+            // the result buffer is written only after the next barrier, so it can be read without synchronization
+            std::memcpy( l_receive + l_offset * p_typesize, l_result, l_count * p_typesize );
+        }
+    }
+    
+    
+    /** gathers the buffer of each process
+     * @param p_send buffer of the process
+     * @param p_receive vector with the buffers of all processes
+     **/
+    inline void sharedmemory::allgather( const std::string& p_send, std::vector<std::string>& p_receive ) const
+    {
+        m_length[m_rank] = p_send.size();
+        barrier();
+        
+        p_receive.resize(m_size);
+        for(std::size_t i=0; i < m_size; ++i)
+            p_receive[i].resize( m_length[i] );
+        
+        const std::size_t l_max = getMaxLength();
+        for(std::size_t l_offset=0; l_offset < l_max; l_offset += m_buffersize) {
+            if (l_offset < p_send.size())
+                std::memcpy( getBuffer(m_rank), p_send.data() + l_offset, std::min(m_buffersize, p_send.size() - l_offset) );
+            barrier();
+            
+            for(std::size_t i=0; i < m_size; ++i)
+                if (l_offset < p_receive[i].size())
+                    std::memcpy( &p_receive[i][l_offset], getBuffer(i), std::min(m_buffersize, p_receive[i].size() - l_offset) );
+            barrier();
+        }
+        
+        // the length values must be read before they are changed
+        if (l_max == 0)
+            barrier();
+    }
+    
+    
+    /** sends the buffer of the root process to all processes
+     * @param p_data buffer
+     * @param p_root rank of the root process
+     **/
+    inline void sharedmemory::broadcast( std::string& p_data, const int& p_root ) const
+    {
+        const std::size_t l_root = static_cast<std::size_t>(p_root);
+        if (l_root >= m_size)
+            throw exception::runtime(_("rank of the root process is out of range"), *this);
+        
+        if (m_rank == l_root)
+            m_length[l_root] = p_data.size();
+        barrier();
+        
+        const std::size_t l_length = m_length[l_root];
+        p_data.resize( l_length );
+        
+        for(std::size_t l_offset=0; l_offset < l_length; l_offset += m_buffersize) {
+            const std::size_t l_count = std::min(m_buffersize, l_length - l_offset);
+            
+            if (m_rank == l_root)
+                std::memcpy( getBuffer(l_root), p_data.data() + l_offset, l_count );
+            barrier();
+            
+            if (m_rank != l_root)
+                std::memcpy( &p_data[l_offset], getBuffer(l_root), l_count );
+            barrier();
+        }
+        
+        if (l_length == 0)
+            barrier();
+    }
+    
+    
+    /** sends a buffer to the destination and receives the buffer of the source process. Each process
+     * reads the data of its source directly, so the destination must be the process, that uses this
+     * process as source
+     * @param p_destination rank of the destination process
+     * @param p_send buffer for sending
+     * @param p_source rank of the source process
+     * @param p_receive buffer for receiving
+     **/
+    inline void sharedmemory::sendrecv( const int& p_destination, const std::string& p_send, const int& p_source, std::string& p_receive ) const
+    {
+        const std::size_t l_source = static_cast<std::size_t>(p_source);
+        if ((l_source >= m_size) || (static_cast<std::size_t>(p_destination) >= m_size))
+            throw exception::runtime(_("rank of the process is out of range"), *this);
+        
+        m_length[m_rank] = p_send.size();
+        barrier();
+        
+        p_receive.resize( m_length[l_source] );
+        
+        const std::size_t l_max = getMaxLength();
+        for(std::size_t l_offset=0; l_offset < l_max; l_offset += m_buffersize) {
+            if (l_offset < p_send.size())
+                std::memcpy( getBuffer(m_rank), p_send.data() + l_offset, std::min(m_buffersize, p_send.size() - l_offset) );
+            barrier();
+            
+            if (l_offset < p_receive.size())
+                std::memcpy( &p_receive[l_offset], getBuffer(l_source), std::min(m_buffersize, p_receive.size() - l_offset) );
+            barrier();
+        }
+        
+        if (l_max == 0)
+            barrier();
+    }
+    
+    
+}}}
+#endif
+#endif
@@ -52,18 +52,41 @@ namespace machinelearning { namespace tools { namespace files {
         
         public :
             
+            csv( void );
             template<typename T> ublas::vector<T> readBlasVector( const std::string&, const bool& = false ) const;
             template<typename T> ublas::matrix<T> readBlasMatrix( const std::string&, const std::string& = ",; \t", const bool& = false ) const;
+            template<typename T> ublas::matrix<T> readBlasMatrix( const std::string&, const std::size_t&, const std::size_t&, const std::string& = ",; \t", const bool& = false ) const;
             std::vector<std::string> readVector( const std::string& ) const;
             template<typename T> void write( const std::string&, const ublas::vector<T>&, const bool& = false ) const;
             template<typename T> void write( const std::string&, const std::vector<T>&, const bool& = false ) const;
             template<typename T> void write( const std::string&, const ublas::matrix<T>&, const char& = ' ', const bool& = false ) const;
         
+        
+        private :
+        
+            /** file of the last read row block **/
+            mutable std::string m_file;
+            /** header option of the last read row block **/
+            mutable bool m_header;
+            /** row behind the last read row block **/
+            mutable std::size_t m_row;
+            /** byte position of the row behind the last read row block **/
+            mutable std::streampos m_position;
+        
     };
     
      
         
         
+    /** constructor **/
+    inline csv::csv( void ) :
+        m_file(),
+        m_header( false ),
+        m_row( 0 ),
+        m_position( 0 )
+    {}
+    
+    
     /** read a vector structure from csv file 
      * @param p_file filename as string
      * @param p_header bool so the first element is set to the length of the vector
@@ -165,7 +188,70 @@ namespace machinelearning { namespace tools { namespace files {
 
         
         ublas::matrix<T> l_mat( l_row, l_col ); 
-        for(std::size_t i=0; l_mat.size1(); ++i)             
+        for(std::size_t i=0; i < l_mat.size1(); ++i)             
+            for(std::size_t j=0; (j < l_mat.size2()) && (j < l_data[i].size()); ++j)
+                l_mat(i,j) =  boost::lexical_cast<T>( l_data[i][j] );
+        
+        return l_mat;
+    }
+    
+    
+    /** read a row block of a matrix structure from csv file, so large files can be read in patches.
+     * Lines before the block are skipped without conversion. The byte position behind the block
+     * is stored, so the next block of the same file is read without skipping the previous lines
+     * @note the stored position is not valid if the file is changed between the calls
+     * @param p_file filename as string
+     * @param p_row first row
+     * @param p_rows number of rows
+     * @param p_separator characters for sperator (default , ; \\t blank)
+     * @param p_header the first line in the input file is the size of the input matrix and is skipped
+     * @return ublas matrix with data, the matrix has less rows if the file ends within the block and no rows after the end
+     **/
+    template<typename T> inline ublas::matrix<T> csv::readBlasMatrix( const std::string& p_file, const std::size_t& p_row, const std::size_t& p_rows, const std::string& p_separator, const bool& p_header ) const
+    {
+        if (p_separator.empty())
+            throw exception::runtime(_("separator can not be empty"), *this);
+        if (p_rows == 0)
+            throw exception::runtime(_("number of rows must be greater than zero"), *this);
+        
+        std::ifstream l_stream( p_file.c_str(), std::ifstream::in );
+        if (!l_stream.is_open())
+            throw exception::runtime(_("file can not be opened"), *this);
+        l_stream.seekg( std::ios_base::beg );
+        
+        // starts on the stored position, if the block is behind the last read block
+        std::string l_line;
+        std::size_t l_skip = p_row;
+        if ( (m_file == p_file) && (m_header == p_header) && (m_row <= p_row) ) {
+            l_stream.seekg( m_position );
+            l_skip -= m_row;
+        } else if (p_header)
+            std::getline(l_stream, l_line);
+        for(std::size_t i=0; (i < l_skip) && (std::getline(l_stream, l_line)); ++i);
+        
+        std::vector< std::vector<std::string> > l_data;
+        std::vector<std::string> l_splitline;
+        std::size_t l_col = 0;
+        while ( (l_data.size() < p_rows) && (std::getline(l_stream, l_line)) ) {
+            l_splitline.clear();
+            boost::split( l_splitline, l_line, boost::is_any_of(p_separator) );
+            
+            l_data.push_back(l_splitline);
+            l_col = std::max(l_col, l_splitline.size());
+        }
+        
+        if (l_stream.good()) {
+            m_file      = p_file;
+            m_header    = p_header;
+            m_row       = p_row + l_data.size();
+            m_position  = l_stream.tellg();
+        } else
+            m_file.clear();
+        l_stream.close();
+        
+        
+        ublas::matrix<T> l_mat( l_data.size(), l_col, 0 );
+        for(std::size_t i=0; i < l_mat.size1(); ++i)
             for(std::size_t j=0; (j < l_mat.size2()) && (j < l_data[i].size()); ++j)
                 l_mat(i,j) =  boost::lexical_cast<T>( l_data[i][j] );
         
@@ -27,6 +27,8 @@
 #define __MACHINELEARNING_TOOLS_FILES_HDF_HPP
 
 #include <string>
+#include <utility>
+#include <algorithm>
 #include <boost/numeric/ublas/matrix.hpp>
 #include <boost/numeric/ublas/vector.hpp>
 #include <boost/numeric/ublas/storage.hpp>
@@ -200,6 +202,9 @@ namespace machinelearning { namespace tools { namespace files {
             
             
             template<typename T> ublas::matrix<T> readBlasMatrix( const std::string&, const datatype& ) const;
+            template<typename T> ublas::matrix<T> readBlasMatrix( const std::string&, const std::size_t&, const std::size_t&, const datatype& ) const;
+            template<typename T> ublas::matrix<T> readBlasMatrix( const std::string&, const std::size_t&, const std::size_t&, const std::size_t&, const std::size_t&, const datatype& ) const;
+            std::pair<std::size_t, std::size_t> getBlasMatrixSize( const std::string& ) const;
             template<typename T> ublas::vector<T> readBlasVector( const std::string&, const datatype& ) const;
             template<typename T> std::vector<T> readStdVector( const std::string&, const datatype& ) const;
             template<typename T> T readValue( const std::string&, const datatype& ) const;
@@ -209,6 +214,8 @@ namespace machinelearning { namespace tools { namespace files {
             
             
             template<typename T> void writeBlasMatrix( const std::string&, const ublas::matrix<T>&, const datatype& ) const;
+            template<typename T> void writeBlasMatrix( const std::string&, const std::size_t&, const std::size_t&, const ublas::matrix<T>&, const datatype& ) const;
+            void createBlasMatrix( const std::string&, const std::size_t&, const std::size_t&, const std::size_t&, const datatype& ) const;
             template<typename T> void writeBlasVector( const std::string&, const ublas::vector<T>&, const datatype& ) const;
             template<typename T> void writeStdVector( const std::string&, const std::vector<T>&, const datatype& ) const;
             template<typename T> void writeValue( const std::string&, const T&, const datatype& ) const;
@@ -224,7 +231,7 @@ namespace machinelearning { namespace tools { namespace files {
             
             bool isAbsolutePath( const std::string& p_path ) const;
             std::string createPath( const std::string&, std::vector<H5::Group>& ) const;
-            void createDataSpace( const std::string&, const H5::PredType&, const ublas::vector<std::size_t>&, H5::DataSpace&, H5::DataSet&, std::vector<H5::Group>& ) const;
+            void createDataSpace( const std::string&, const H5::PredType&, const ublas::vector<std::size_t>&, H5::DataSpace&, H5::DataSet&, std::vector<H5::Group>&, const H5::DSetCreatPropList& = H5::DSetCreatPropList::DEFAULT ) const;
             void createStringSpace( const std::string&, const ublas::vector<std::size_t>&, const std::size_t&, H5::DataSpace&, H5::DataSet&, H5::StrType&, std::vector<H5::Group>& ) const;
             void closeSpace( std::vector<H5::Group>&, H5::DataSet&, H5::DataSpace& ) const;
             H5::PredType getHDFType( const datatype& ) const;
@@ -371,6 +378,130 @@ namespace machinelearning { namespace tools { namespace files {
     
     
     
+    /** reads a row block of a matrix with convert to blas matrix. Only the hyperslab
+     * of the rows is read from the file, so large datasets can be read in patches
+     * @param p_path dataset name
+     * @param p_row first row
+     * @param p_rows number of rows
+     * @param p_datatype datatype for reading data
+     * @return ublas matrix
+     **/ 
+    template<typename T> inline ublas::matrix<T> hdf::readBlasMatrix( const std::string& p_path, const std::size_t& p_row, const std::size_t& p_rows, const datatype& p_datatype ) const
+    {
+        if (!isAbsolutePath(p_path))
+            throw exception::runtime(_("path is not an absolute path"));
+        if (!p_rows)
+            throw exception::runtime(_("number of rows must be greater than zero"));
+        
+        H5::DataSet   l_dataset   = m_file.openDataSet( p_path.c_str() );
+        H5::DataSpace l_dataspace = l_dataset.getSpace();
+        
+        // check datasetdimension
+        if (l_dataspace.getSimpleExtentNdims() != 2)
+            throw exception::runtime(_("dataset must be two-dimensional"));
+        if (!l_dataspace.isSimple())
+            throw exception::runtime(_("dataset must be a simple datatype"));
+        
+        // read matrix size (first element is column size, second row size)
+        hsize_t l_size[2];
+        l_dataspace.getSimpleExtentDims( l_size );
+        
+        if ((!l_size[1]) || (!l_size[0]))
+            throw exception::runtime(_("dimension need not be zero"));
+        if (p_row + p_rows > l_size[1])
+            throw exception::runtime(_("row range is out of the dataset"));
+        
+        // select the row block (the matrix is stored transposed, so the rows are the second dimension)
+        hsize_t l_offset[2] = { 0, p_row };
+        hsize_t l_count[2]  = { l_size[0], p_rows };
+        l_dataspace.selectHyperslab( H5S_SELECT_SET, l_count, l_offset );
+        H5::DataSpace l_memspace( 2, l_count );
+        
+        // read data (read column oriantated, because data order is changed)
+        ublas::matrix<T, ublas::column_major> l_mat(p_rows,l_size[0]);
+        l_dataset.read( &(l_mat.data()[0]), getHDFType(p_datatype), l_memspace, l_dataspace );
+        
+        l_memspace.close();
+        l_dataspace.close();
+        l_dataset.close();
+        return l_mat;
+    }
+    
+    
+    /** reads a block of a matrix with convert to blas matrix. Only the hyperslab of the
+     * block is read from the file
+     * @param p_path dataset name
+     * @param p_row first row
+     * @param p_rows number of rows
+     * @param p_column first column
+     * @param p_columns number of columns
+     * @param p_datatype datatype for reading data
+     * @return ublas matrix
+     **/ 
+    template<typename T> inline ublas::matrix<T> hdf::readBlasMatrix( const std::string& p_path, const std::size_t& p_row, const std::size_t& p_rows, const std::size_t& p_column, const std::size_t& p_columns, const datatype& p_datatype ) const
+    {
+        if (!isAbsolutePath(p_path))
+            throw exception::runtime(_("path is not an absolute path"));
+        if ((!p_rows) || (!p_columns))
+            throw exception::runtime(_("number of rows and columns must be greater than zero"));
+        
+        H5::DataSet   l_dataset   = m_file.openDataSet( p_path.c_str() );
+        H5::DataSpace l_dataspace = l_dataset.getSpace();
+        
+        // check datasetdimension
+        if (l_dataspace.getSimpleExtentNdims() != 2)
+            throw exception::runtime(_("dataset must be two-dimensional"));
+        if (!l_dataspace.isSimple())
+            throw exception::runtime(_("dataset must be a simple datatype"));
+        
+        // read matrix size (first element is column size, second row size)
+        hsize_t l_size[2];
+        l_dataspace.getSimpleExtentDims( l_size );
+        
+        if ((p_row + p_rows > l_size[1]) || (p_column + p_columns > l_size[0]))
+            throw exception::runtime(_("block is out of the dataset"));
+        
+        // select the block (the matrix is stored transposed)
+        hsize_t l_offset[2] = { p_column, p_row };
+        hsize_t l_count[2]  = { p_columns, p_rows };
+        l_dataspace.selectHyperslab( H5S_SELECT_SET, l_count, l_offset );
+        H5::DataSpace l_memspace( 2, l_count );
+        
+        // read data (read column oriantated, because data order is changed)
+        ublas::matrix<T, ublas::column_major> l_mat(p_rows,p_columns);
+        l_dataset.read( &(l_mat.data()[0]), getHDFType(p_datatype), l_memspace, l_dataspace );
+        
+        l_memspace.close();
+        l_dataspace.close();
+        l_dataset.close();
+        return l_mat;
+    }
+    
+    
+    /** returns the size of a matrix dataset without reading the data
+     * @param p_path dataset name
+     * @return pair with number of rows and columns
+     **/
+    inline std::pair<std::size_t, std::size_t> hdf::getBlasMatrixSize( const std::string& p_path ) const
+    {
+        if (!isAbsolutePath(p_path))
+            throw exception::runtime(_("path is not an absolute path"));
+        
+        H5::DataSet   l_dataset   = m_file.openDataSet( p_path.c_str() );
+        H5::DataSpace l_dataspace = l_dataset.getSpace();
+        
+        if (l_dataspace.getSimpleExtentNdims() != 2)
+            throw exception::runtime(_("dataset must be two-dimensional"));
+        
+        hsize_t l_size[2];
+        l_dataspace.getSimpleExtentDims( l_size );
+        
+        l_dataspace.close();
+        l_dataset.close();
+        return std::pair<std::size_t, std::size_t>( l_size[1], l_size[0] );
+    }
+    
+    
     /** reads a vector with convert to blas vector
      * @param p_path dataset path & name
      * @param p_datatype datatype for reading data
@@ -669,6 +800,87 @@ namespace machinelearning { namespace tools { namespace files {
     }
     
     
+    /** write a blas matrix into a block of an existing matrix dataset (@see createBlasMatrix),
+     * so large matrices can be written in patches
+     * @param p_path dataset path & name
+     * @param p_row first row of the block
+     * @param p_column first column of the block
+     * @param p_dataset matrixdata
+     * @param p_datatype datatype for writing data
+     **/
+    template<typename T> inline void hdf::writeBlasMatrix( const std::string& p_path, const std::size_t& p_row, const std::size_t& p_column, const ublas::matrix<T>& p_dataset, const datatype& p_datatype ) const
+    {
+        if ((!p_dataset.size1()) || (!p_dataset.size2()))
+            throw exception::runtime(_("can not write empty data"));
+        
+        if (!isAbsolutePath(p_path))
+            throw exception::runtime(_("path is not an absolute path"));
+        
+        H5::DataSet   l_dataset   = m_file.openDataSet( p_path.c_str() );
+        H5::DataSpace l_dataspace = l_dataset.getSpace();
+        
+        if (l_dataspace.getSimpleExtentNdims() != 2)
+            throw exception::runtime(_("dataset must be two-dimensional"));
+        
+        // read matrix size (first element is column size, second row size)
+        hsize_t l_size[2];
+        l_dataspace.getSimpleExtentDims( l_size );
+        
+        if ((p_row + p_dataset.size1() > l_size[1]) || (p_column + p_dataset.size2() > l_size[0]))
+            throw exception::runtime(_("block is out of the dataset"));
+        
+        // select the block (the matrix is stored transposed)
+        hsize_t l_offset[2] = { p_column, p_row };
+        hsize_t l_count[2]  = { p_dataset.size2(), p_dataset.size1() };
+        l_dataspace.selectHyperslab( H5S_SELECT_SET, l_count, l_offset );
+        H5::DataSpace l_memspace( 2, l_count );
+        
+        // write data (column oriantated, because data order is changed)
+        const ublas::matrix<T, ublas::column_major> l_matrix( p_dataset );
+        l_dataset.write( &(l_matrix.data()[0]), getHDFType(p_datatype), l_memspace, l_dataspace );
+        
+        l_memspace.close();
+        l_dataspace.close();
+        l_dataset.close();
+    }
+    
+    
+    /** creates an empty matrix dataset, that is stored in square chunks, so blocks can be
+     * written (@see writeBlasMatrix) without holding the matrix in the memory. The elements
+     * are initialized with zero
+     * @param p_path dataset path & name
+     * @param p_rows number of rows
+     * @param p_columns number of columns
+     * @param p_chunk number of rows and columns of a chunk
+     * @param p_datatype datatype of the data
+     **/
+    inline void hdf::createBlasMatrix( const std::string& p_path, const std::size_t& p_rows, const std::size_t& p_columns, const std::size_t& p_chunk, const datatype& p_datatype ) const
+    {
+        if ((!p_rows) || (!p_columns) || (!p_chunk))
+            throw exception::runtime(_("dimension need not be zero"));
+        
+        if (!isAbsolutePath(p_path))
+            throw exception::runtime(_("path is not an absolute path"));
+        
+        H5::DataSet l_dataset;
+        H5::DataSpace l_dataspace;
+        std::vector<H5::Group> l_groups;
+        
+        ublas::vector<std::size_t> l_dim(2);
+        l_dim(0) = p_columns;
+        l_dim(1) = p_rows;
+        
+        // a chunk can not be larger than the dataset
+        hsize_t l_chunk[2] = { std::min(p_chunk, p_columns), std::min(p_chunk, p_rows) };
+        H5::DSetCreatPropList l_property;
+        l_property.setChunk( 2, l_chunk );
+        
+        createDataSpace(p_path,  getHDFType(p_datatype), l_dim, l_dataspace, l_dataset, l_groups, l_property);
+        closeSpace(l_groups, l_dataset, l_dataspace);
+        l_property.close();
+    }
+    
+    
     /** write a blas vector to hdf file
      * @param p_path dataset path & name
      * @param p_dataset vectordata
@@ -760,8 +972,9 @@ namespace machinelearning { namespace tools { namespace files {
      * @param p_dataspace refernce of the dataspace
      * @param p_dataset refernce for the dataset
      * @param p_groups groups for closing
+     * @param p_property creation properties of the dataset (e.g. chunking)
      **/
-    inline void hdf::createDataSpace( const std::string& p_path, const H5::PredType& p_datatype, const ublas::vector<std::size_t>& p_dim, H5::DataSpace& p_dataspace, H5::DataSet& p_dataset, std::vector<H5::Group>& p_groups ) const
+    inline void hdf::createDataSpace( const std::string& p_path, const H5::PredType& p_datatype, const ublas::vector<std::size_t>& p_dim, H5::DataSpace& p_dataspace, H5::DataSet& p_dataset, std::vector<H5::Group>& p_groups, const H5::DSetCreatPropList& p_property ) const
     {
         if (!p_dim.size())
             throw exception::runtime(_("one dimension is required"));
@@ -779,9 +992,9 @@ namespace machinelearning { namespace tools { namespace files {
             throw exception::runtime(_("empty path is forbidden"));
         
         if (!p_groups.size())
-            p_dataset = m_file.createDataSet( l_path.c_str(), p_datatype, p_dataspace );
+            p_dataset = m_file.createDataSet( l_path.c_str(), p_datatype, p_dataspace, p_property );
         else
-            p_dataset = p_groups[p_groups.size()-1].createDataSet( l_path.c_str(), p_datatype, p_dataspace );
+            p_dataset = p_groups[p_groups.size()-1].createDataSet( l_path.c_str(), p_datatype, p_dataspace, p_property );
     }
     
     
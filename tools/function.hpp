@@ -30,6 +30,7 @@
 #include <cmath>
 #include <limits>
 #include <iterator>
+#include <boost/cstdint.hpp>
 #include <boost/numeric/ublas/vector.hpp>
 #include <boost/numeric/ublas/matrix.hpp>
 #include <boost/iostreams/copy.hpp>
@@ -57,6 +58,9 @@ namespace machinelearning { namespace tools {
             static bool fileExists( const std::string& );
             static std::string urlencode( const std::string& );
             template<typename T> static std::string toString( const T& );
+            static boost::uint64_t fnv( const char*, const std::size_t&, const boost::uint64_t& = 0 );
+            static boost::uint64_t fnvAppend( const boost::uint64_t&, const char& );
+            static boost::uint64_t mix( boost::uint64_t );
     };
 
     
@@ -151,5 +155,46 @@ namespace machinelearning { namespace tools {
         return l_stream.str();
     }
     
+    
+    /** 64 bit FNV-1a hash of a buffer (the hash of an empty buffer is the offset basis)
+     * @see http://www.isthe.com/chongo/tech/comp/fnv/
+     * @param p_data buffer
+     * @param p_size size of the buffer
+     * @param p_seed seed, that is combined with the offset basis
+     * @return hash
+     **/
+    inline boost::uint64_t function::fnv( const char* p_data, const std::size_t& p_size, const boost::uint64_t& p_seed )
+    {
+        boost::uint64_t l_hash = UINT64_C(14695981039346656037) ^ p_seed;
+        for(std::size_t i=0; i < p_size; ++i)
+            l_hash = fnvAppend( l_hash, p_data[i] );
+        
+        return l_hash;
+    }
+    
+    
+    /** extends a 64 bit FNV-1a hash by one byte
+     * @param p_hash hash of the previous bytes
+     * @param p_byte byte
+     * @return hash
+     **/
+    inline boost::uint64_t function::fnvAppend( const boost::uint64_t& p_hash, const char& p_byte )
+    {
+        return (p_hash ^ static_cast<boost::uint64_t>( static_cast<unsigned char>(p_byte) )) * UINT64_C(1099511628211);
+    }
+    
+    
+    /** mixes the bits of a hash value (finalizer of SplitMix64), so the values are uniform
+     * distributed and the order of the values is a random permutation
+     * @param p_value hash value
+     * @return mixed value
+     **/
+    inline boost::uint64_t function::mix( boost::uint64_t p_value )
+    {
+        p_value = (p_value ^ (p_value >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+        p_value = (p_value ^ (p_value >> 27)) * UINT64_C(0x94d049bb133111eb);
+        return p_value ^ (p_value >> 31);
+    }
+    
 }}
 #endif
@@ -25,8 +25,14 @@
 #ifndef __MACHINELEARNING_TOOLS_LAPACK_HPP
 #define __MACHINELEARNING_TOOLS_LAPACK_HPP
 
+#include <omp.h>
+#include <cmath>
+#include <vector>
 #include <boost/numeric/ublas/matrix.hpp>
+#include <boost/numeric/ublas/matrix_sparse.hpp>
 #include <boost/numeric/ublas/vector.hpp>
+#include <boost/numeric/ublas/matrix_proxy.hpp>
+#include <boost/numeric/ublas/vector_proxy.hpp>
 #include <boost/numeric/bindings/blas.hpp>
 #include <boost/numeric/bindings/ublas/vector.hpp>
 #include <boost/numeric/bindings/ublas/matrix.hpp>
@@ -34,6 +40,11 @@
 #include <boost/numeric/bindings/lapack/driver/ggev.hpp>
 #include <boost/numeric/bindings/lapack/driver/gesv.hpp> 
 #include <boost/numeric/bindings/lapack/driver/gesvd.hpp>
+#include <boost/numeric/bindings/lapack/driver/syevd.hpp>
+#include <boost/numeric/bindings/lapack/driver/syevr.hpp>
+#include <boost/numeric/bindings/lapack/driver/sygv.hpp>
+#include <boost/numeric/bindings/lapack/workspace.hpp>
+#include <boost/numeric/bindings/upper.hpp>
 #include <boost/numeric/bindings/lapack/computational/hseqr.hpp>
 
 
@@ -47,6 +58,37 @@ namespace machinelearning { namespace tools {
     namespace ublas     = boost::numeric::ublas;
     namespace blas      = boost::numeric::bindings::blas;
     namespace linalg    = boost::numeric::bindings::lapack;
+    namespace bindings  = boost::numeric::bindings;
+    #endif
+    
+    
+    #ifndef SWIG
+    class lapack;
+    
+    /** workspace of the symmetric eigenvalue decomposition. The LAPACK buffers are
+     * only grown, so an object can be reused for calls with the same or smaller matrices
+     **/
+    template<typename T> class symmetricworkspace
+    {
+        friend class lapack;
+        
+        public :
+        
+            symmetricworkspace( void );
+        
+        
+        private :
+        
+            /** real workspace **/
+            ublas::vector<T> m_work;
+            /** integer workspace **/
+            ublas::vector<int> m_iwork;
+            /** support of the eigenvectors **/
+            ublas::vector<int> m_support;
+        
+            void resize( const std::size_t&, const std::size_t& );
+        
+    };
     #endif
     
     
@@ -69,16 +111,43 @@ namespace machinelearning { namespace tools {
         
         public :
         
+            /** part of the spectrum **/
+            enum spectrum
+            {
+                largest     = 0,
+                smallest    = 1
+            };
+            
+            
             template<typename T> static void eigen( const ublas::matrix<T>&, ublas::vector<T>&, ublas::matrix<T>&, const bool& = true );
             template<typename T> static void eigen( const ublas::matrix<T>&, const ublas::matrix<T>&, ublas::vector<T>&, ublas::matrix<T>&, const bool& = true );
             template<typename T> static void svd( const ublas::matrix<T>&, ublas::vector<T>&, ublas::matrix<T>&, ublas::matrix<T>&, const bool& = true );
             template<typename T> static void solve( const ublas::matrix<T>&, const ublas::vector<T>&, ublas::vector<T>& );
+            #ifndef SWIG
+            template<typename T> static void symmetricEigen( const ublas::matrix<T>&, ublas::vector<T>&, ublas::matrix<T>& );
+            template<typename T> static void symmetricEigen( const ublas::matrix<T>&, const std::size_t&, const std::size_t&, ublas::vector<T>&, ublas::matrix<T>& );
+            template<typename T> static void symmetricEigen( const ublas::matrix<T>&, const std::size_t&, const std::size_t&, ublas::vector<T>&, ublas::matrix<T>&, symmetricworkspace<T>& );
+            template<typename T> static void symmetricEigen( const ublas::matrix<T>&, const std::size_t&, const spectrum&, ublas::vector<T>&, ublas::matrix<T>& );
+            template<typename T> static void symmetricEigen( const ublas::matrix<T>&, const std::size_t&, const spectrum&, ublas::vector<T>&, ublas::matrix<T>&, symmetricworkspace<T>& );
+            template<typename T> static void symmetricEigen( const ublas::matrix<T>&, const ublas::matrix<T>&, ublas::vector<T>&, ublas::matrix<T>& );
+            template<typename T> static void lanczos( const ublas::compressed_matrix<T>&, const std::size_t&, ublas::vector<T>&, ublas::matrix<T>&, const T& = 1e-8, const std::size_t& = 1000 );
+            template<typename T> static void svd( const ublas::matrix<T>&, const std::size_t&, ublas::vector<T>&, ublas::matrix<T>&, ublas::matrix<T>& );
+            template<typename T> static void randomizedSvd( const ublas::matrix<T>&, const std::size_t&, ublas::vector<T>&, ublas::matrix<T>&, ublas::matrix<T>&, const std::size_t& = 10, const std::size_t& = 2 );
+            #endif
             //template<typename T> static ublas::matrix<T> expm( const ublas::matrix<T>& );
             template<typename T> static ublas::vector<T> perronfrobenius( const ublas::matrix<T>&, const std::size_t& );
             template<typename T> static ublas::vector<T> perronfrobenius( const ublas::matrix<T>&, const std::size_t&, const ublas::vector<T>& );
             template<typename T> static ublas::matrix<T> unnormalizedGraphLaplacian( const ublas::matrix<T>& );
             template<typename T> static ublas::matrix<T> normalizedGraphLaplacian( const ublas::matrix<T>& );
         
+        
+        private :
+        
+            #ifndef SWIG
+            template<typename T> static void lanczosOrthogonalize( ublas::matrix<T, ublas::column_major>&, const std::size_t&, const std::size_t&, ublas::vector<T>& );
+            template<typename T> static void orthonormalize( ublas::matrix<T, ublas::column_major>& );
+            #endif
+        
     };
 
     
@@ -166,6 +235,188 @@ namespace machinelearning { namespace tools {
     }
     
     
+    /** constructor of the workspace **/
+    template<typename T> inline symmetricworkspace<T>::symmetricworkspace( void ) :
+        m_work(),
+        m_iwork(),
+        m_support()
+    {}
+    
+    
+    /** resizes the workspace (only growing) for the syevr call
+     * @param p_size matrix size
+     * @param p_count number of eigenvalues
+     **/
+    template<typename T> inline void symmetricworkspace<T>::resize( const std::size_t& p_size, const std::size_t& p_count )
+    {
+        if (m_work.size() < 26*p_size)
+            m_work.resize( 26*p_size, false );
+        if (m_iwork.size() < 10*p_size)
+            m_iwork.resize( 10*p_size, false );
+        if (m_support.size() < 2*std::max(p_count, static_cast<std::size_t>(1)))
+            m_support.resize( 2*std::max(p_count, static_cast<std::size_t>(1)), false );
+    }
+    
+    
+    /** calculates all eigenvalues and eigenvectors of a symmetric matrix (divide & conquer, syevd)
+     * @param p_matrix symmetric input matrix (only the upper triangle is used)
+     * @param p_eigval blas vector for eigenvalues (ascending) [initialisation is not needed]
+     * @param p_eigvec blas matrix for orthonormal eigenvectors (every column is a eigenvector) [initialisation is not needed]
+     **/
+    template<typename T> inline void lapack::symmetricEigen( const ublas::matrix<T>& p_matrix, ublas::vector<T>& p_eigval, ublas::matrix<T>& p_eigvec )
+    {
+        if (p_matrix.size1() != p_matrix.size2())
+            throw exception::runtime(_("matrix must be square"));
+        
+        // copy matrix for LAPACK, the matrix is overwritten with the eigenvectors
+        ublas::matrix<T, ublas::column_major> l_matrix(p_matrix);
+        ublas::vector<T> l_eigval(l_matrix.size1());
+        
+        if (linalg::syevd( 'V', bindings::upper(l_matrix), l_eigval, linalg::optimal_workspace() ) != 0)
+            throw exception::runtime(_("eigenvalue decomposition does not converge"));
+        
+        p_eigvec = l_matrix;
+        p_eigval = l_eigval;
+    }
+    
+    
+    /** calculates all generalized eigenvalues and eigenvectors of the symmetric-definite problem A x = lambda B x.
+     * B is reduced with the Cholesky decomposition, so the problem is solved as a symmetric eigenproblem (sygv)
+     * @param p_matrix symmetric input matrix A (only the upper triangle is used)
+     * @param p_definite symmetric positive definite matrix B (only the upper triangle is used)
+     * @param p_eigval blas vector for eigenvalues (ascending) [initialisation is not needed]
+     * @param p_eigvec blas matrix for eigenvectors, that are normalized with x' B x = 1 (every column is a eigenvector) [initialisation is not needed]
+     **/
+    template<typename T> inline void lapack::symmetricEigen( const ublas::matrix<T>& p_matrix, const ublas::matrix<T>& p_definite, ublas::vector<T>& p_eigval, ublas::matrix<T>& p_eigvec )
+    {
+        if ( (p_matrix.size1() != p_matrix.size2()) || (p_definite.size1() != p_definite.size2()) )
+            throw exception::runtime(_("matrix must be square"));
+        if (p_matrix.size1() != p_definite.size1())
+            throw exception::runtime(_("both matrices have not the same size"));
+        
+        // copy matrices for LAPACK, the first matrix is overwritten with the eigenvectors, the second with the Cholesky factor
+        ublas::matrix<T, ublas::column_major> l_matrix(p_matrix);
+        ublas::matrix<T, ublas::column_major> l_definite(p_definite);
+        ublas::vector<T> l_eigval(l_matrix.size1());
+        
+        const int l_info = linalg::sygv( 1, 'V', bindings::upper(l_matrix), l_definite, l_eigval, linalg::optimal_workspace() );
+        if (l_info > static_cast<int>(l_matrix.size1()))
+            throw exception::runtime(_("matrix is not positive definite"));
+        if (l_info != 0)
+            throw exception::runtime(_("eigenvalue decomposition does not converge"));
+        
+        p_eigvec = l_matrix;
+        p_eigval = l_eigval;
+    }
+    
+    
+    /** calculates the eigenvalues with the index [first, last) of the ascending spectrum of a symmetric matrix
+     * and their eigenvectors (relatively robust representation, syevr), only the requested eigenpairs are computed
+     * @param p_matrix symmetric input matrix (only the upper triangle is used)
+     * @param p_first first index
+     * @param p_last last index (excluded)
+     * @param p_eigval blas vector for eigenvalues (ascending) [initialisation is not needed]
+     * @param p_eigvec blas matrix for orthonormal eigenvectors (every column is a eigenvector) [initialisation is not needed]
+     **/
+    template<typename T> inline void lapack::symmetricEigen( const ublas::matrix<T>& p_matrix, const std::size_t& p_first, const std::size_t& p_last, ublas::vector<T>& p_eigval, ublas::matrix<T>& p_eigvec )
+    {
+        symmetricworkspace<T> l_workspace;
+        symmetricEigen( p_matrix, p_first, p_last, p_eigval, p_eigvec, l_workspace );
+    }
+    
+    
+    /** calculates the eigenvalues with the index [first, last) of the ascending spectrum of a symmetric matrix
+     * and their eigenvectors (relatively robust representation, syevr), only the requested eigenpairs are computed
+     * @param p_matrix symmetric input matrix (only the upper triangle is used)
+     * @param p_first first index
+     * @param p_last last index (excluded)
+     * @param p_eigval blas vector for eigenvalues (ascending) [initialisation is not needed]
+     * @param p_eigvec blas matrix for orthonormal eigenvectors (every column is a eigenvector) [initialisation is not needed]
+     * @param p_workspace workspace, that is reused
+     **/
+    template<typename T> inline void lapack::symmetricEigen( const ublas::matrix<T>& p_matrix, const std::size_t& p_first, const std::size_t& p_last, ublas::vector<T>& p_eigval, ublas::matrix<T>& p_eigvec, symmetricworkspace<T>& p_workspace )
+    {
+        if (p_matrix.size1() != p_matrix.size2())
+            throw exception::runtime(_("matrix must be square"));
+        if ( (p_first >= p_last) || (p_last > p_matrix.size1()) )
+            throw exception::runtime(_("index range of the eigenvalues is not valid"));
+        
+        const std::size_t l_count = p_last - p_first;
+        p_workspace.resize( p_matrix.size1(), l_count );
+        
+        // copy matrix for LAPACK and create result structures
+        ublas::matrix<T, ublas::column_major> l_matrix(p_matrix);
+        ublas::matrix<T, ublas::column_major> l_eigvec(l_matrix.size1(), l_count);
+        ublas::vector<T> l_eigval(l_matrix.size1());
+        int l_found = 0;
+        
+        // LAPACK index range is one-based and inclusive
+        if (linalg::syevr( 'V', 'I', bindings::upper(l_matrix), static_cast<T>(0), static_cast<T>(0), static_cast<int>(p_first+1), static_cast<int>(p_last), static_cast<T>(0), l_found, l_eigval, l_eigvec, p_workspace.m_support, linalg::workspace(p_workspace.m_work, p_workspace.m_iwork) ) != 0)
+            throw exception::runtime(_("eigenvalue decomposition does not converge"));
+        if (static_cast<std::size_t>(l_found) != l_count)
+            throw exception::runtime(_("number of calculated eigenvalues is not equal to the index range"));
+        
+        p_eigval = ublas::subrange(l_eigval, 0, l_count);
+        p_eigvec = l_eigvec;
+    }
+    
+    
+    /** calculates the largest or smallest eigenvalues and their eigenvectors of a symmetric matrix
+     * @param p_matrix symmetric input matrix (only the upper triangle is used)
+     * @param p_count number of eigenvalues
+     * @param p_spectrum largest or smallest part of the spectrum
+     * @param p_eigval blas vector for eigenvalues (the largest eigenvalues are descending, the smallest ascending) [initialisation is not needed]
+     * @param p_eigvec blas matrix for orthonormal eigenvectors (every column is a eigenvector) [initialisation is not needed]
+     **/
+    template<typename T> inline void lapack::symmetricEigen( const ublas::matrix<T>& p_matrix, const std::size_t& p_count, const spectrum& p_spectrum, ublas::vector<T>& p_eigval, ublas::matrix<T>& p_eigvec )
+    {
+        symmetricworkspace<T> l_workspace;
+        symmetricEigen( p_matrix, p_count, p_spectrum, p_eigval, p_eigvec, l_workspace );
+    }
+    
+    
+    /** calculates the largest or smallest eigenvalues and their eigenvectors of a symmetric matrix
+     * @param p_matrix symmetric input matrix (only the upper triangle is used)
+     * @param p_count number of eigenvalues
+     * @param p_spectrum largest or smallest part of the spectrum
+     * @param p_eigval blas vector for eigenvalues (the largest eigenvalues are descending, the smallest ascending) [initialisation is not needed]
+     * @param p_eigvec blas matrix for orthonormal eigenvectors (every column is a eigenvector) [initialisation is not needed]
+     * @param p_workspace workspace, that is reused
+     **/
+    template<typename T> inline void lapack::symmetricEigen( const ublas::matrix<T>& p_matrix, const std::size_t& p_count, const spectrum& p_spectrum, ublas::vector<T>& p_eigval, ublas::matrix<T>& p_eigvec, symmetricworkspace<T>& p_workspace )
+    {
+        if ( (p_count == 0) || (p_count > p_matrix.size1()) )
+            throw exception::runtime(_("number of eigenvalues must be greater than zero and not greater than the matrix size"));
+        
+        switch (p_spectrum) {
+            
+            case smallest :
+                symmetricEigen( p_matrix, 0, p_count, p_eigval, p_eigvec, p_workspace );
+                break;
+                
+            case largest :
+            {
+                ublas::vector<T> l_eigval;
+                ublas::matrix<T> l_eigvec;
+                symmetricEigen( p_matrix, p_matrix.size1()-p_count, p_matrix.size1(), l_eigval, l_eigvec, p_workspace );
+                
+                // reverse the ascending order
+                p_eigval.resize( p_count, false );
+                p_eigvec.resize( l_eigvec.size1(), p_count, false );
+                for(std::size_t i=0; i < p_count; ++i)
+                {
+                    p_eigval(i)                 = l_eigval(p_count-i-1);
+                    ublas::column(p_eigvec, i)  = ublas::column(l_eigvec, p_count-i-1);
+                }
+                break;
+            }
+                
+            default :
+                throw exception::runtime(_("spectrum option is unknown"));
+        }
+    }
+
+    
     /** singular value decomposition
      * @param p_matrix input matrix
      * @param p_svdval blas vector for eigenvalues [initialisation is not needed]
@@ -229,6 +480,329 @@ namespace machinelearning { namespace tools {
     }
   
      
+    /** calculates the largest (algebraic) eigenvalues and their eigenvectors of a sparse symmetric matrix
+     * with a block Lanczos iteration (full reorthogonalization and thick restart). Only the matrix-vector
+     * product is used, so the matrix is never stored dense and only a basis of a few vectors per wanted
+     * eigenpair is held. The block size is the number of the eigenpairs, so multiple eigenvalues
+     * (e.g. disconnected graph components) are found, too.
+     * @param p_matrix symmetric sparse matrix
+     * @param p_count number of eigenpairs
+     * @param p_eigval blas vector for the eigenvalues (descending) [initialisation is not needed]
+     * @param p_eigvec blas matrix for the normalized eigenvectors (every column is a eigenvector) [initialisation is not needed]
+     * @param p_tolerance residual tolerance (relative to the largest eigenvalue)
+     * @param p_restarts maximum number of restarts
+     **/
+    template<typename T> inline void lapack::lanczos( const ublas::compressed_matrix<T>& p_matrix, const std::size_t& p_count, ublas::vector<T>& p_eigval, ublas::matrix<T>& p_eigvec, const T& p_tolerance, const std::size_t& p_restarts )
+    {
+        if (p_matrix.size1() != p_matrix.size2())
+            throw exception::runtime(_("matrix must be square"));
+        if ( (p_count == 0) || (p_count > p_matrix.size1()) )
+            throw exception::runtime(_("number of eigenvalues must be greater than zero and not greater than the matrix size"));
+        
+        const std::size_t l_size  = p_matrix.size1();
+        
+        // copy the matrix into a compressed row structure, so the product can be run parallel over the rows
+        std::vector<std::size_t> l_rowptr(l_size+1, 0);
+        std::vector<std::size_t> l_colidx;
+        std::vector<T> l_values;
+        l_colidx.reserve( p_matrix.nnz() );
+        l_values.reserve( p_matrix.nnz() );
+        
+        for(typename ublas::compressed_matrix<T>::const_iterator1 it = p_matrix.begin1(); it != p_matrix.end1(); ++it)
+            for(typename ublas::compressed_matrix<T>::const_iterator2 jt = it.begin(); jt != it.end(); ++jt)
+            {
+                l_colidx.push_back( jt.index2() );
+                l_values.push_back( *jt );
+                l_rowptr[jt.index1()+1]++;
+            }
+        for(std::size_t i=0; i < l_size; ++i)
+            l_rowptr[i+1] += l_rowptr[i];
+        
+        
+        // basis size, number of kept Ritz vectors on restart and block size
+        const std::size_t l_block   = p_count;
+        const std::size_t l_basis   = std::min( l_size, std::max(4*p_count, p_count+20) );
+        const std::size_t l_keep    = std::max( p_count, std::min(l_basis-l_block, p_count + p_count/2) );
+        const std::size_t l_blocksize = 512;
+        
+        // basis (V) and the product of the matrix with the basis (AV), both column-major so a column is continuous
+        ublas::matrix<T, ublas::column_major> l_basisvec(l_size, l_basis);
+        ublas::matrix<T, ublas::column_major> l_product(l_size, l_basis);
+        ublas::vector<T> l_coefficient(l_basis);
+        
+        ublas::vector<T> l_ritzval;
+        symmetricworkspace<T> l_workspace;
+        std::size_t l_filled    = 0;
+        
+        for(std::size_t n=0; ; ++n)
+        {
+            // extend the basis: each candidate is the product of a former basis vector, which is orthogonalized against the
+            // basis. Candidates, which are linear dependend, are skipped, if no candidate exists a random vector is used
+            for(std::size_t l_candidate=0; l_filled < l_basis; )
+            {
+                if ( ((n == 0) && (l_filled < l_block)) || (l_candidate >= l_filled) )
+                    ublas::column(l_basisvec, l_filled) = vector::random<T>(l_size);
+                else
+                    ublas::column(l_basisvec, l_filled) = ublas::column(l_product, l_candidate++);
+                
+                const T l_length = blas::nrm2( static_cast< ublas::vector<T> >(ublas::column(l_basisvec, l_filled)) );
+                lanczosOrthogonalize( l_basisvec, l_filled, l_blocksize, l_coefficient );
+                const T l_norm   = blas::nrm2( static_cast< ublas::vector<T> >(ublas::column(l_basisvec, l_filled)) );
+                if ( (l_norm == 0) || (l_norm <= std::sqrt(std::numeric_limits<T>::epsilon()) * l_length) )
+                    continue;
+                ublas::column(l_basisvec, l_filled) /= l_norm;
+                
+                // sparse matrix-vector product of the new basis vector
+                const T* const l_vec    = &l_basisvec.data()[l_filled*l_size];
+                T* const l_result       = &l_product.data()[l_filled*l_size];
+                #pragma omp parallel for
+                for(std::size_t i=0; i < l_size; ++i)
+                {
+                    T l_sum = 0;
+                    for(std::size_t j=l_rowptr[i]; j < l_rowptr[i+1]; ++j)
+                        l_sum += l_values[j] * l_vec[l_colidx[j]];
+                    l_result[i] = l_sum;
+                }
+                
+                l_filled++;
+            }
+            
+            
+            // Rayleigh-Ritz projection H = V' A V, the rows are split into blocks, so that
+            // a block of all basis vectors is held within the cache
+            ublas::matrix<T> l_projection(l_basis, l_basis, 0);
+            #pragma omp parallel
+            {
+                ublas::matrix<T> l_local(l_basis, l_basis, 0);
+                
+                #pragma omp for
+                for(std::size_t l_row=0; l_row < l_size; l_row += l_blocksize)
+                {
+                    const std::size_t l_end = std::min(l_size, l_row+l_blocksize);
+                    for(std::size_t i=0; i < l_basis; ++i)
+                        for(std::size_t j=0; j <= i; ++j)
+                        {
+                            const T* const l_left   = &l_basisvec.data()[i*l_size];
+                            const T* const l_right  = &l_product.data()[j*l_size];
+                            T l_sum = 0;
+                            for(std::size_t k=l_row; k < l_end; ++k)
+                                l_sum += l_left[k] * l_right[k];
+                            l_local(i,j) += l_sum;
+                        }
+                }
+                
+                #pragma omp critical
+                l_projection += l_local;
+            }
+            for(std::size_t i=0; i < l_basis; ++i)
+                for(std::size_t j=0; j < i; ++j)
+                    l_projection(j,i) = l_projection(i,j);
+            
+            
+            // the projection is symmetric, so only the wanted eigenpairs are calculated (descending), the
+            // eigenvectors are orthonormal also for multiple eigenvalues
+            ublas::matrix<T> l_ritzcoefficient;
+            symmetricEigen( l_projection, l_keep, largest, l_ritzval, l_ritzcoefficient, l_workspace );
+            
+            
+            // Ritz vectors Y = V S and AY = AV S (no further matrix-vector product is needed), they are
+            // written blockwise into the first columns of the basis, so the basis is restarted with them
+            #pragma omp parallel
+            {
+                ublas::matrix<T, ublas::column_major> l_ritzbasis(l_blocksize, l_keep);
+                ublas::matrix<T, ublas::column_major> l_ritzproduct(l_blocksize, l_keep);
+                
+                #pragma omp for
+                for(std::size_t l_row=0; l_row < l_size; l_row += l_blocksize)
+                {
+                    const std::size_t l_length = std::min(l_size, l_row+l_blocksize) - l_row;
+                    l_ritzbasis.clear();
+                    l_ritzproduct.clear();
+                    
+                    for(std::size_t j=0; j < l_keep; ++j)
+                        for(std::size_t k=0; k < l_basis; ++k)
+                        {
+                            const T l_coefficient = l_ritzcoefficient(k,j);
+                            const T* const l_basiscolumn    = &l_basisvec.data()[k*l_size+l_row];
+                            const T* const l_productcolumn  = &l_product.data()[k*l_size+l_row];
+                            T* const l_vec                  = &l_ritzbasis.data()[j*l_blocksize];
+                            T* const l_prod                 = &l_ritzproduct.data()[j*l_blocksize];
+                            for(std::size_t i=0; i < l_length; ++i)
+                            {
+                                l_vec[i]  += l_coefficient * l_basiscolumn[i];
+                                l_prod[i] += l_coefficient * l_productcolumn[i];
+                            }
+                        }
+                    
+                    for(std::size_t j=0; j < l_keep; ++j)
+                    {
+                        std::copy( &l_ritzbasis.data()[j*l_blocksize], &l_ritzbasis.data()[j*l_blocksize]+l_length, &l_basisvec.data()[j*l_size+l_row] );
+                        std::copy( &l_ritzproduct.data()[j*l_blocksize], &l_ritzproduct.data()[j*l_blocksize]+l_length, &l_product.data()[j*l_size+l_row] );
+                    }
+                }
+            }
+            l_filled = l_keep;
+            
+            
+            // residuals ||AY - Y theta|| of the wanted eigenpairs, the full basis creates the exact decomposition
+            bool l_converged = true;
+            const T l_scale  = std::max( static_cast<T>(1), std::fabs(l_ritzval(0)) );
+            for(std::size_t i=0; (i < p_count) && l_converged; ++i)
+                l_converged = blas::nrm2( static_cast< ublas::vector<T> >(ublas::column(l_product, i) - l_ritzval(i) * ublas::column(l_basisvec, i)) ) <= p_tolerance * l_scale;
+            
+            if ( l_converged || (l_basis == l_size) || (n+1 >= p_restarts) )
+            {
+                p_eigval = ublas::subrange(l_ritzval, 0, p_count);
+                p_eigvec = ublas::subrange(l_basisvec, 0, l_size, 0, p_count);
+                return;
+            }
+        }
+    }
+    
+    
+    /** calculates the largest singular values and their singular vectors (thin SVD, only the
+     * singular vectors of the nonzero singular values are calculated)
+     * @param p_matrix input matrix
+     * @param p_rank number of singular values
+     * @param p_svdval blas vector for the singular values (descending) [initialisation is not needed]
+     * @param p_svdvec1 blas matrix for the left singular vectors (every column is a vector) [initialisation is not needed]
+     * @param p_svdvec2 blas matrix for the right singular vectors (every column is a vector) [initialisation is not needed]
+     **/
+    template<typename T> inline void lapack::svd( const ublas::matrix<T>& p_matrix, const std::size_t& p_rank, ublas::vector<T>& p_svdval, ublas::matrix<T>& p_svdvec1, ublas::matrix<T>& p_svdvec2 )
+    {
+        const std::size_t l_size = std::min(p_matrix.size1(), p_matrix.size2());
+        if ( (p_rank == 0) || (p_rank > l_size) )
+            throw exception::runtime(_("number of singular values must be greater than zero and not greater than the matrix size"));
+        
+        // copy matrix for LAPACK and create result structures
+        ublas::matrix<T, ublas::column_major> l_matrix(p_matrix);
+        ublas::matrix<T, ublas::column_major> l_svdvec1(l_matrix.size1(), l_size);
+        ublas::matrix<T, ublas::column_major> l_svdvec2(l_size, l_matrix.size2());
+        ublas::vector<T> l_svdval(l_size);
+        
+        if (linalg::gesvd( 'S', 'S', l_matrix, l_svdval, l_svdvec1, l_svdvec2, linalg::optimal_workspace() ) != 0)
+            throw exception::runtime(_("singular value decomposition does not converge"));
+        
+        // singular values are sorted descending, second matrix must be transpose
+        p_svdval    = ublas::subrange( l_svdval, 0, p_rank );
+        p_svdvec1   = ublas::subrange( l_svdvec1, 0, l_svdvec1.size1(), 0, p_rank );
+        p_svdvec2   = ublas::trans( ublas::subrange(l_svdvec2, 0, p_rank, 0, l_svdvec2.size2()) );
+    }
+    
+    
+    /** calculates the largest singular values and their singular vectors with a randomized range finder
+     * (Halko, Martinsson & Tropp, 2011). The matrix is only used within matrix products, the SVD is
+     * calculated on the small projection, so the cost is linear in the matrix size
+     * @param p_matrix input matrix
+     * @param p_rank number of singular values
+     * @param p_svdval blas vector for the singular values (descending) [initialisation is not needed]
+     * @param p_svdvec1 blas matrix for the left singular vectors (every column is a vector) [initialisation is not needed]
+     * @param p_svdvec2 blas matrix for the right singular vectors (every column is a vector) [initialisation is not needed]
+     * @param p_oversampling number of additional random samples
+     * @param p_iteration number of power iterations (increases the accuracy on slow decaying spectra)
+     **/
+    template<typename T> inline void lapack::randomizedSvd( const ublas::matrix<T>& p_matrix, const std::size_t& p_rank, ublas::vector<T>& p_svdval, ublas::matrix<T>& p_svdvec1, ublas::matrix<T>& p_svdvec2, const std::size_t& p_oversampling, const std::size_t& p_iteration )
+    {
+        if ( (p_rank == 0) || (p_rank > std::min(p_matrix.size1(), p_matrix.size2())) )
+            throw exception::runtime(_("number of singular values must be greater than zero and not greater than the matrix size"));
+        
+        const std::size_t l_sample = std::min( p_rank + p_oversampling, std::min(p_matrix.size1(), p_matrix.size2()) );
+        
+        // sample the range of the matrix with gaussian vectors
+        ublas::matrix<T, ublas::column_major> l_range = ublas::prod( p_matrix, matrix::random<T>(p_matrix.size2(), l_sample, random::normal) );
+        orthonormalize( l_range );
+        
+        // power iterations, every step is orthonormalized, so the small singular values are not lost
+        for(std::size_t i=0; i < p_iteration; ++i)
+        {
+            ublas::matrix<T, ublas::column_major> l_corange = ublas::prod( ublas::trans(p_matrix), l_range );
+            orthonormalize( l_corange );
+            
+            l_range = ublas::prod( p_matrix, l_corange );
+            orthonormalize( l_range );
+        }
+        
+        // SVD of the projection onto the range
+        ublas::matrix<T> l_svdvec1;
+        svd<T>( ublas::prod(ublas::trans(l_range), p_matrix), p_rank, p_svdval, l_svdvec1, p_svdvec2 );
+        p_svdvec1 = ublas::prod( l_range, l_svdvec1 );
+    }
+    
+    
+    /** orthogonalize a basis column against all previous columns (classical Gram-Schmidt with reorthogonalization)
+     * @param p_basis basis matrix
+     * @param p_column column index, that is orthogonalized against the columns [0, p_column)
+     * @param p_blocksize number of rows, that are processed together
+     * @param p_coefficient buffer for the projection coefficients
+     **/
+    template<typename T> inline void lapack::lanczosOrthogonalize( ublas::matrix<T, ublas::column_major>& p_basis, const std::size_t& p_column, const std::size_t& p_blocksize, ublas::vector<T>& p_coefficient )
+    {
+        const std::size_t l_size    = p_basis.size1();
+        T* const l_vec              = &p_basis.data()[p_column*l_size];
+        
+        for(std::size_t n=0; n < 2; ++n)
+        {
+            // projection coefficients, calculated over row blocks
+            std::fill( p_coefficient.begin(), p_coefficient.begin()+p_column, static_cast<T>(0) );
+            #pragma omp parallel
+            {
+                ublas::vector<T> l_local(p_column, 0);
+                
+                #pragma omp for
+                for(std::size_t l_row=0; l_row < l_size; l_row += p_blocksize)
+                {
+                    const std::size_t l_end = std::min(l_size, l_row+p_blocksize);
+                    for(std::size_t j=0; j < p_column; ++j)
+                    {
+                        const T* const l_basisvec = &p_basis.data()[j*l_size];
+                        T l_sum = 0;
+                        for(std::size_t i=l_row; i < l_end; ++i)
+                            l_sum += l_basisvec[i] * l_vec[i];
+                        l_local(j) += l_sum;
+                    }
+                }
+                
+                #pragma omp critical
+                ublas::subrange(p_coefficient, 0, p_column) += l_local;
+            }
+            
+            // remove the projection
+            #pragma omp parallel for
+            for(std::size_t l_row=0; l_row < l_size; l_row += p_blocksize)
+            {
+                const std::size_t l_end = std::min(l_size, l_row+p_blocksize);
+                for(std::size_t j=0; j < p_column; ++j)
+                {
+                    const T l_coefficient       = p_coefficient(j);
+                    const T* const l_basisvec   = &p_basis.data()[j*l_size];
+                    for(std::size_t i=l_row; i < l_end; ++i)
+                        l_vec[i] -= l_coefficient * l_basisvec[i];
+                }
+            }
+        }
+    }
+    
+    
+    /** orthonormalize the columns of a matrix (classical Gram-Schmidt with reorthogonalization),
+     * linear dependend columns are set to zero
+     * @param p_matrix matrix
+     **/
+    template<typename T> inline void lapack::orthonormalize( ublas::matrix<T, ublas::column_major>& p_matrix )
+    {
+        ublas::vector<T> l_coefficient(p_matrix.size2());
+        for(std::size_t i=0; i < p_matrix.size2(); ++i)
+        {
+            lanczosOrthogonalize( p_matrix, i, 512, l_coefficient );
+            
+            const T l_norm = ublas::norm_2( ublas::column(p_matrix, i) );
+            if (function::isNumericalZero(l_norm))
+                ublas::column(p_matrix, i) = ublas::zero_vector<T>(p_matrix.size1());
+            else
+                ublas::column(p_matrix, i) /= l_norm;
+        }
+    }
+    
+    
     /** generates the eigenvalue / -vector with the perronforbenius theorem
      * @see http://en.wikipedia.org/wiki/Perron–Frobenius_theorem
      * @param p_matrix input matrix
@@ -294,14 +868,20 @@ namespace machinelearning { namespace tools {
         
         // change the distance matrix to a degree matrix
         const ublas::vector<T> l_vertexdegree       = matrix::sum(p_adjacency);
-        const ublas::matrix<T> l_degree             = matrix::diag(l_vertexdegree);
         
-        // degree minus adjacency matrix
-        const ublas::matrix<T> l_unnormlaplacian    = l_degree - p_adjacency;
+        // normalized laplacian: l_degree^-1 * (l_degree - adjacency), the degree matrix is diagonal,
+        // so each row is scaled with the inverse vertex degree (without creating the inverse matrix)
+        ublas::matrix<T> l_laplacian = -p_adjacency;
+        for(std::size_t i=0; i < l_laplacian.size1(); ++i)
+        {
+            l_laplacian(i,i) += l_vertexdegree(i);
+            if (function::isNumericalZero(l_vertexdegree(i)))
+                ublas::row(l_laplacian, i) = ublas::zero_vector<T>(l_laplacian.size2());
+            else
+                ublas::row(l_laplacian, i) /= l_vertexdegree(i);
+        }
         
-        // normalized laplacian: multiply l_degree^-1 * l_unnormlaplacian
-        // degree matrix is a diagnomal matrix, so invert the elements and do a matrix product
-        return ublas::prod( matrix::invert(l_degree), l_unnormlaplacian );
+        return l_laplacian;
     }
 
 }}
@@ -45,5 +45,6 @@ namespace machinelearning {
 #include "files/files.h"
 #include "language/language.h"
 #include "iostreams/iostreams.h"
+#include "communication/communication.h"
 
 #endif